@@ -0,0 +1,67 @@
+/**
+ * @file affine.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Affine transformations of the image plane
+ *
+ */
+
+#include "affine.h"
+#include <math.h>
+
+// ========================================
+// TRANSFORMATION FUNCTIONS
+// ========================================
+
+
+t_affine affine_rotation(double degrees, double cx, double cy)
+{
+    // With y going down, the usual matrix turns clockwise on screen
+    double angle = degrees * 3.14159265358979323846 / 180.0;
+    double cosine = cos(angle), sine = sin(angle);
+    t_affine m = {cosine, -sine, 0.0, sine, cosine, 0.0};
+    m.c = cx - cosine * cx + sine * cy;
+    m.f = cy - sine * cx - cosine * cy;
+    return m;
+}
+
+
+t_affine affine_scale(double sx, double sy, double cx, double cy)
+{
+    t_affine m = {sx, 0.0, cx - sx * cx, 0.0, sy, cy - sy * cy};
+    return m;
+}
+
+
+t_affine affine_shear(double kx, double ky, double cx, double cy)
+{
+    t_affine m = {1.0, kx, -kx * cy, ky, 1.0, -ky * cx};
+    return m;
+}
+
+
+t_affine affine_compose(const t_affine *first, const t_affine *then)
+{
+    t_affine m;
+    m.a = then->a * first->a + then->b * first->d;
+    m.b = then->a * first->b + then->b * first->e;
+    m.c = then->a * first->c + then->b * first->f + then->c;
+    m.d = then->d * first->a + then->e * first->d;
+    m.e = then->d * first->b + then->e * first->e;
+    m.f = then->d * first->c + then->e * first->f + then->f;
+    return m;
+}
+
+
+int affine_invert(const t_affine *transform, t_affine *inverse)
+{
+    double det = transform->a * transform->e - transform->b * transform->d;
+    if (fabs(det) < 1e-12)
+        return 0;
+    inverse->a = transform->e / det;
+    inverse->b = -transform->b / det;
+    inverse->d = -transform->d / det;
+    inverse->e = transform->a / det;
+    inverse->c = -(inverse->a * transform->c + inverse->b * transform->f);
+    inverse->f = -(inverse->d * transform->c + inverse->e * transform->f);
+    return 1;
+}
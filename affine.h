@@ -0,0 +1,99 @@
+/**
+ * @file affine.h
+ * @brief Affine transformations of the image plane
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines the affine transformations used by the warps of
+ * imageview, bmp8 and bmp24 (rotation by any angle, scaling, shear) and the
+ * sampling modes used by warps and resizes to read pixels between pixel
+ * centres. Transformations are built from the helpers below and chained
+ * with affine_compose:
+ * @code
+ *     t_affine deskew = affine_rotation(-2.5, cx, cy);
+ *     t_affine shrink = affine_scale(0.5, 0.5, cx, cy);
+ *     t_affine both = affine_compose(&deskew, &shrink);
+ * @endcode
+ */
+
+#ifndef AFFINE_H
+#define AFFINE_H
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @enum t_sampling
+ * @brief How a pixel is read between pixel centres
+ */
+typedef enum {
+    SAMPLE_NEAREST,     /**< Value of the closest pixel */
+    SAMPLE_BILINEAR,    /**< Weighted average of the 4 closest pixels */
+    SAMPLE_AREA,        /**< Average of the pixels covered (resize only) */
+    SAMPLE_BICUBIC,     /**< Cubic convolution, 4x4 pixels (resize only) */
+    SAMPLE_LANCZOS3     /**< Windowed sinc, 6x6 pixels (resize only) */
+} t_sampling;
+
+/**
+ * @struct t_affine
+ * @brief Affine transformation of the plane
+ *
+ * Maps (x, y) to (a x + b y + c, d x + e y + f). Coordinates are in pixels,
+ * with (0, 0) the centre of the top-left pixel and y going down.
+ */
+typedef struct {
+    double a, b, c;     /**< x' = a x + b y + c */
+    double d, e, f;     /**< y' = d x + e y + f */
+} t_affine;
+
+/* ============================================================================
+ * TRANSFORMATION FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Rotation around a point
+ * @param degrees Angle, clockwise on screen
+ * @param cx Column of the centre
+ * @param cy Row of the centre
+ * @return Transformation
+ */
+t_affine affine_rotation(double degrees, double cx, double cy);
+
+/**
+ * @brief Scaling from a point
+ * @param sx Horizontal factor
+ * @param sy Vertical factor
+ * @param cx Column of the fixed point
+ * @param cy Row of the fixed point
+ * @return Transformation
+ */
+t_affine affine_scale(double sx, double sy, double cx, double cy);
+
+/**
+ * @brief Shear around a point
+ * @param kx Horizontal shift per row away from cy
+ * @param ky Vertical shift per column away from cx
+ * @param cx Column of the fixed point
+ * @param cy Row of the fixed point
+ * @return Transformation
+ */
+t_affine affine_shear(double kx, double ky, double cx, double cy);
+
+/**
+ * @brief Chain two transformations
+ * @param first Transformation applied first
+ * @param then Transformation applied to the result
+ * @return Transformation doing both
+ */
+t_affine affine_compose(const t_affine *first, const t_affine *then);
+
+/**
+ * @brief Inverse of a transformation
+ * @param transform Transformation to invert
+ * @param inverse Result
+ * @return 1 on success, 0 if the transformation flattens the plane
+ */
+int affine_invert(const t_affine *transform, t_affine *inverse);
+
+#endif //AFFINE_H
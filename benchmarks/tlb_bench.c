@@ -0,0 +1,174 @@
+/**
+ * @file tlb_bench.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Benchmark of huge-page backed pixel buffers (Linux only)
+ *
+ * Usage: tlb_bench [width] [height] [repeats]
+ *
+ * Runs column-direction work on a large 8-bit image twice, once with normal
+ * pages and once with pool_setHugePages(1):
+ * - A column walk (one byte per row, column after column), the worst case
+ * - bmp8_applyFilter with a 3x3 box blur (three rows touched per pixel)
+ * - bmp8_horizontalFlip (rows taken from both ends of the image)
+ *
+ * For each one it prints the time and, when the kernel allows
+ * perf_event_open, the data TLB read misses. The AnonHugePages line shows
+ * whether the kernel actually gave huge pages to the process.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "../bmp8.h"
+#include "../bmp24.h"
+#include "../bufpool.h"
+#include "../scratch.h"
+
+// ========================================
+// MEASUREMENT
+// ========================================
+
+
+// Counter of data TLB read misses of this thread, -1 if not available
+static int openTlbCounter(void)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB
+                  | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                  | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+// Huge page memory of the process in kB, from /proc/self/smaps_rollup
+static long anonHugePages(void)
+{
+    FILE *file = fopen("/proc/self/smaps_rollup", "r");
+    if (!file) return -1;
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), file))
+        if (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1)
+            break;
+    fclose(file);
+    return kb;
+}
+
+// ========================================
+// WORKLOADS
+// ========================================
+
+static volatile unsigned long sink;
+
+
+static void columnWalk(t_bmp8 *img)
+{
+    unsigned long sum = 0;
+    for (size_t x = 0; x < img->width; x += 16)
+        for (size_t y = 0; y < img->height; y++)
+            sum += img->data[y * img->stride + x];
+    sink = sum;
+}
+
+
+static void boxBlur(t_bmp8 *img)
+{
+    size_t mark = scratch_mark();
+    float **kernel = createScratchKernel(3);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            kernel[i][j] = 1.0f / 9.0f;
+    bmp8_applyFilter(img, kernel, 3);
+    scratch_release(mark);
+}
+
+
+static void run(const char *name, void (*work)(t_bmp8 *), t_bmp8 *img, int repeats, int counter)
+{
+    long long misses = 0;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    double start = now();
+    for (int i = 0; i < repeats; i++)
+        work(img);
+    double elapsed = now() - start;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &misses, sizeof(misses)) != sizeof(misses))
+            misses = -1;
+    }
+
+    printf("  %-16s %9.1f ms", name, elapsed * 1000 / repeats);
+    if (counter >= 0 && misses >= 0)
+        printf("  %12lld dTLB misses", misses / repeats);
+    printf("\n");
+}
+
+
+static void benchmark(int hugePages, unsigned int width, unsigned int height, int repeats, int counter)
+{
+    // Start from empty pools so that every buffer is mapped with the setting
+    scratch_trim();
+    pool_trim();
+    pool_setHugePages(hugePages);
+
+    t_bmp8 *img = bmp8_allocate(width, height);
+    if (!img) {
+        printf("Not enough memory for %ux%u\n", width, height);
+        exit(1);
+    }
+    for (size_t i = 0; i < img->dataSize; i++)
+        img->data[i] = (unsigned char)(i * 2654435761u >> 24);
+
+    printf("%s pages:\n", hugePages ? "Huge" : "Normal");
+    run("column walk", columnWalk, img, repeats, counter);
+    run("3x3 box blur", boxBlur, img, repeats, counter);
+    run("horizontal flip", bmp8_horizontalFlip, img, repeats, counter);
+    printf("  AnonHugePages: %ld kB, huge buffers: %lu\n", anonHugePages(), pool_getStats().huge);
+    bmp8_freeImage(img);
+}
+
+
+int main(int argc, char *argv[])
+{
+    unsigned int width = argc > 1 ? (unsigned int)atoi(argv[1]) : 16384;
+    unsigned int height = argc > 2 ? (unsigned int)atoi(argv[2]) : 8192;
+    int repeats = argc > 3 ? atoi(argv[3]) : 3;
+    if (width == 0 || height == 0 || repeats <= 0) {
+        fprintf(stderr, "Usage: %s [width] [height] [repeats]\n", argv[0]);
+        return 1;
+    }
+
+    int counter = openTlbCounter();
+    printf("%ux%u 8-bit image (%.0f MiB), %d repeats%s\n", width, height,
+           (double)width * height / (1 << 20), repeats,
+           counter < 0 ? ", dTLB counter not available (perf_event_paranoid?)" : "");
+
+    benchmark(0, width, height, repeats, counter);
+    benchmark(1, width, height, repeats, counter);
+    if (counter >= 0) close(counter);
+    return 0;
+}
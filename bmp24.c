@@ -10,7 +10,13 @@
  */
 
 #include "bmp24.h"
+#include "scratch.h"
+#include "bufpool.h"
+#include "imageview.h"
+#include "resize.h"
+#include "rank.h"
 #include <math.h>
+#include <string.h>
 #include "bmp8.h"
 
 // ========================================
@@ -37,44 +43,61 @@
 
 
 t_pixel ** bmp24_allocateDataPixels (int width, int height){
-    t_pixel **pixels;
+    // Array of row pointers (at least one, pixels[0] holds the block)
+    t_pixel **pixels = (t_pixel **)malloc((height > 0 ? height : 1) * sizeof(t_pixel *));
 
-    // First, allocate array of row pointers (one pointer per row)
-    pixels = (t_pixel **)malloc(height * sizeof(t_pixel *));
-
-    // Then allocate each individual row (width pixels per row)
-    for (int i = 0; i < height; i++)
-    {
-        pixels[i] = (t_pixel *)malloc( width * sizeof(t_pixel));
-    }
+    // All the rows in one block from the pool, top row first
+    t_pixel *block = pool_alloc((size_t)width * height * sizeof(t_pixel));
 
     // Check if allocation failed and clean up if necessary
-    if (!pixels) {
+    if (!pixels || !block) {
         printf("Error allocating memory for pixels\n");
-        // Free any already allocated rows
-        for (int j = 0; j < height; j++)
-            free(pixels[j]);
         free(pixels);
+        pool_free(block);
         return NULL;
-    };
+    }
+    pixels[0] = block;
+    for (int i = 1; i < height; i++)
+        pixels[i] = block + (size_t)i * width;
     return pixels;
 }
 
 
 void bmp24_freeDataPixels (t_pixel ** pixels, int height){
-    // Free each row
-    for (int i = 0; i < height; i++)
-        free(pixels[i]);
-    // Free the array of row pointers
+    (void)height;   // The rows share one block
+    if (!pixels)
+        return;
+    pool_free(pixels[0]);
     free(pixels);
 }
 
 
+/**
+ * Refresh the size fields of the headers from img->width and img->height,
+ * for images whose dimensions differ from the file they were read from.
+ */
+void bmp24_updateHeaders(t_bmp24 *img)
+{
+    uint64_t rowSize = (((uint64_t)img->width * 3 + 3) / 4) * 4;
+    uint64_t imageSize = rowSize * img->height;
+    img->header_info.width = img->width;
+    img->header_info.height = img->height;
+
+    // 0 is valid for uncompressed data and is used when the size needs more than 32 bits
+    img->header_info.imagesize = imageSize > UINT32_MAX - img->header.offset ? 0 : (uint32_t)imageSize;
+    img->header.size = imageSize > UINT32_MAX - img->header.offset ? 0 : (uint32_t)(img->header.offset + imageSize);
+}
+
+
 t_bmp24 * bmp24_allocate (int width, int height, int colorDepth){
     t_bmp24 *img;
 
     // Allocate memory for the main image structure
     img = (t_bmp24 *)malloc(sizeof(t_bmp24));
+    if (!img) {
+        printf("Error allocating memory for image\n");
+        return NULL;
+    }
 
     // Initialize basic properties
     img->width = width;
@@ -87,13 +110,38 @@ t_bmp24 * bmp24_allocate (int width, int height, int colorDepth){
     // Check if pixel data allocation failed
     if (!img->data) {
         printf("Error allocating memory for data\n");
-        bmp24_freeDataPixels (img->data, img->height);
+        free(img);
         return NULL;
     }
+
+    // Default headers of an uncompressed file; loaders overwrite them with the file's
+    memset(&img->header, 0, sizeof(img->header));
+    memset(&img->header_info, 0, sizeof(img->header_info));
+    img->header.type = BMP_TYPE;
+    img->header.offset = HEADER_SIZE + INFO_SIZE;
+    img->header_info.size = INFO_SIZE;
+    img->header_info.planes = 1;
+    img->header_info.bits = colorDepth;
+    img->header_info.compression = COMPRESSION_RGB;
+    img->header_info.xresolution = 2835;   // 72 DPI
+    img->header_info.yresolution = 2835;
+    bmp24_updateHeaders(img);
     return img;
 }
 
 
+t_bmp24 * bmp24_copy(t_bmp24 * img){
+    t_bmp24 *copy = bmp24_allocate(img->width, img->height, img->colorDepth);
+    if (!copy) return NULL;
+
+    copy->header = img->header;
+    copy->header_info = img->header_info;
+    for (int i = 0; i < img->height; i++)
+        memcpy(copy->data[i], img->data[i], img->width * sizeof(t_pixel));
+    return copy;
+}
+
+
 void bmp24_free(t_bmp24 * img){
     bmp24_freeDataPixels(img->data, img->height);
     free(img);
@@ -104,14 +152,36 @@ void bmp24_free(t_bmp24 * img){
 // ========================================
 
 
-void file_rawRead (uint32_t position, void * buffer, uint32_t size, size_t n, FILE * file) {
-    fseek(file, position, SEEK_SET);  // Move to specified position
+int file_seek64 (FILE * file, uint64_t position) {
+    // fseek takes a long, which is only 32 bits on Windows
+#ifdef _WIN32
+    return _fseeki64(file, (long long)position, SEEK_SET);
+#else
+    return fseeko(file, (off_t)position, SEEK_SET);
+#endif
+}
+
+
+uint64_t file_size64 (FILE * file) {
+#ifdef _WIN32
+    if (_fseeki64(file, 0, SEEK_END) != 0) return 0;
+    long long size = _ftelli64(file);
+#else
+    if (fseeko(file, 0, SEEK_END) != 0) return 0;
+    off_t size = ftello(file);
+#endif
+    return size > 0 ? (uint64_t)size : 0;
+}
+
+
+void file_rawRead (uint64_t position, void * buffer, size_t size, size_t n, FILE * file) {
+    file_seek64(file, position);      // Move to specified position
     fread(buffer, size, n, file);     // Read data into buffer
 }
 
 
-void file_rawWrite (uint32_t position, void * buffer, uint32_t size, size_t n, FILE * file) {
-    fseek(file, position, SEEK_SET);   // Move to specified position
+void file_rawWrite (uint64_t position, void * buffer, size_t size, size_t n, FILE * file) {
+    file_seek64(file, position);       // Move to specified position
     fwrite(buffer, size, n, file);     // Write data from buffer
 }
 
@@ -123,11 +193,11 @@ void file_rawWrite (uint32_t position, void * buffer, uint32_t size, size_t n, F
 void bmp24_readPixelValue(t_bmp24 *image, const int x, const int y, FILE *file)
 {
     // Calculate row size including padding (BMP rows are padded to 4-byte boundaries)
-    int rowSize = ((image->width * 3 + 3) / 4) * 4;
+    size_t rowSize = (((size_t)image->width * 3 + 3) / 4) * 4;
 
     // Calculate file position: start of pixel data + row offset + column offset
     // Note: (height - 1 - y) flips Y coordinate since BMP stores bottom-to-top
-    uint32_t position = image->header.offset + (image->height - 1 - y) * rowSize + x * 3;
+    uint64_t position = image->header.offset + (uint64_t)(image->height - 1 - y) * rowSize + (uint64_t)x * 3;
 
     // Read 3 bytes (BGR) from file
     uint8_t pixelData[3];
@@ -150,20 +220,40 @@ void bmp24_readPixelValue(t_bmp24 *image, const int x, const int y, FILE *file)
 
 
 void bmp24_readPixelData(t_bmp24 *image, FILE *file){
-    for (int y = 0; y < image->height; y++) {
+    size_t rowSize = (((size_t)image->width * 3 + 3) / 4) * 4;
+    uint8_t *row = malloc(rowSize);
+    if (!row) {
+        // Fall back on pixel-by-pixel reads
+        for (int y = 0; y < image->height; y++)
+            for (int x = 0; x < image->width; x++)
+                bmp24_readPixelValue(image, x, y, file);
+        return;
+    }
+
+    // Stream the pixel array sequentially: one seek, then one padded row per read.
+    // Rows are stored bottom-up, so the first row in the file is the last image row.
+    file_seek64(file, image->header.offset);
+    for (int y = image->height - 1; y >= 0; y--) {
+        if (fread(row, 1, rowSize, file) != rowSize) {
+            printf("Error : Pixel data is truncated\n");
+            break;
+        }
         for (int x = 0; x < image->width; x++) {
-            bmp24_readPixelValue(image, x, y, file);
+            image->data[y][x].blue  = row[x * 3];
+            image->data[y][x].green = row[x * 3 + 1];
+            image->data[y][x].red   = row[x * 3 + 2];
         }
     }
+    free(row);
 }
 
 
 void bmp24_writePixelValue(t_bmp24 *image, int x, int y, FILE *file) {
     // Calculate row size with padding
-    int rowSize = ((image->width * 3 + 3) / 4) * 4;
+    size_t rowSize = (((size_t)image->width * 3 + 3) / 4) * 4;
 
     // Calculate file position (flip Y coordinate for BMP format)
-    uint32_t position = image->header.offset + (image->height - 1 - y) * rowSize + x * 3;
+    uint64_t position = image->header.offset + (uint64_t)(image->height - 1 - y) * rowSize + (uint64_t)x * 3;
 
     // Convert RGB to BGR format for BMP file
     uint8_t pixelData[3];
@@ -177,11 +267,27 @@ void bmp24_writePixelValue(t_bmp24 *image, int x, int y, FILE *file) {
 
 
 void bmp24_writePixelData(t_bmp24 *image, FILE *file) {
-    for (int y = 0; y < image->height; y++) {
+    size_t rowSize = (((size_t)image->width * 3 + 3) / 4) * 4;
+    uint8_t *row = calloc(rowSize, 1);   // Padding bytes stay zero
+    if (!row) {
+        // Fall back on pixel-by-pixel writes
+        for (int y = 0; y < image->height; y++)
+            for (int x = 0; x < image->width; x++)
+                bmp24_writePixelValue(image, x, y, file);
+        return;
+    }
+
+    // Stream padded rows sequentially, bottom row first
+    file_seek64(file, image->header.offset);
+    for (int y = image->height - 1; y >= 0; y--) {
         for (int x = 0; x < image->width; x++) {
-            bmp24_writePixelValue(image, x, y, file);
+            row[x * 3]     = image->data[y][x].blue;
+            row[x * 3 + 1] = image->data[y][x].green;
+            row[x * 3 + 2] = image->data[y][x].red;
         }
+        fwrite(row, 1, rowSize, file);
     }
+    free(row);
 }
 
 // ========================================
@@ -189,6 +295,37 @@ void bmp24_writePixelData(t_bmp24 *image, FILE *file) {
 // ========================================
 
 
+/**
+ * Read and validate the file and info headers of a 24-bit BMP.
+ * Returns 1 on success, 0 (after printing the reason) otherwise.
+ */
+static int bmp24_readHeaders(FILE *file, t_bmp_header *header, t_bmp_info *info)
+{
+    // Read main BMP header fields
+    file_rawRead(BITMAP_MAGIC, &header->type, sizeof(uint16_t), 1, file);     // Magic number
+    file_rawRead(BITMAP_SIZE, &header->size, sizeof(uint32_t), 1, file);      // File size
+    file_rawRead(BITMAP_OFFSET, &header->offset, sizeof(uint32_t), 1, file);  // Pixel data offset
+
+    // Read info header (contains image dimensions and format info)
+    file_rawRead(HEADER_SIZE, info, sizeof(t_bmp_info), 1, file);
+
+    // Validate that this is actually a BMP file
+    if (header->type != BMP_TYPE)
+    {
+        printf("Error : File is not a BMP file\n");
+        return 0;
+    }
+
+    // Validate that this is 24-bit color depth
+    if (info->bits != 24)
+    {
+        printf("Error : File is not 24 bit\n");
+        return 0;
+    }
+    return 1;
+}
+
+
 t_bmp24 * bmp24_loadImage (const char * filename){
     // Open file in binary read mode
     FILE *file = fopen(filename, "rb");
@@ -201,46 +338,180 @@ t_bmp24 * bmp24_loadImage (const char * filename){
     t_bmp_header header;
     t_bmp_info info;
 
-    // Read main BMP header fields
-    file_rawRead(BITMAP_MAGIC, &header.type, sizeof(uint16_t), 1, file);     // Magic number
-    file_rawRead(BITMAP_SIZE, &header.size, sizeof(uint32_t), 1, file);      // File size
-    file_rawRead(BITMAP_OFFSET, &header.offset, sizeof(uint32_t), 1, file);  // Pixel data offset
+    if (!bmp24_readHeaders(file, &header, &info))
+    {
+        fclose(file);
+        return NULL;
+    }
 
-    // Read info header (contains image dimensions and format info)
-    file_rawRead(HEADER_SIZE, &info, sizeof(t_bmp_info), 1, file);
+    // Allocate image structure with dimensions from file
+    t_bmp24 * img = bmp24_allocate(info.width, info.height, info.bits);
 
-    // Validate that this is actually a BMP file
-    if (header.type != BMP_TYPE)
+    if (!img) {
+        printf("Error allocating memory for data\n");
+        fclose(file);
+        return NULL;
+    }
+
+    // Store header information in image structure
+    img->header = header;
+    img->header_info = info;
+
+    // Read all pixel data from file
+    bmp24_readPixelData(img, file);
+
+    fclose(file);
+    return img;
+}
+
+
+t_bmp24 * bmp24_loadImageROI (const char * filename, int x, int y, int width, int height){
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        printf("Error : Opening of the file impossible %s\n", filename);
+        return NULL;
+    }
+
+    t_bmp_header header;
+    t_bmp_info info;
+
+    if (!bmp24_readHeaders(file, &header, &info))
     {
-        printf("Error : File is not a BMP file\n");
         fclose(file);
         return NULL;
     }
 
-    // Validate that this is 24-bit color depth
-    if (info.bits != 24)
+    // The region must be non-empty and lie entirely inside the image
+    if (x < 0 || y < 0 || width <= 0 || height <= 0
+        || x + width > info.width || y + height > info.height)
     {
-        printf("Error : File is not 24 bit\n");
+        printf("Error : Region (%d, %d, %dx%d) is outside the image\n", x, y, width, height);
         fclose(file);
         return NULL;
     }
 
-    // Allocate image structure with dimensions from file
-    t_bmp24 * img = bmp24_allocate(info.width, info.height, info.bits);
+    t_bmp24 * img = bmp24_allocate(width, height, info.bits);
+    uint8_t * span = malloc((size_t)width * 3);
+    if (!img || !span) {
+        printf("Error allocating memory for data\n");
+        if (img) bmp24_free(img);
+        free(span);
+        fclose(file);
+        return NULL;
+    }
 
-    if (!img) {
+    img->header = header;
+    img->header_info = info;
+    bmp24_updateHeaders(img);
+
+    // Same position math as bmp24_readPixelValue, but one read per scanline span
+    uint64_t rowSize = (((uint64_t)info.width * 3 + 3) / 4) * 4;
+    for (int r = 0; r < height; r++)
+    {
+        uint64_t position = header.offset + (info.height - 1 - (y + r)) * rowSize + (uint64_t)x * 3;
+        file_rawRead(position, span, sizeof(uint8_t), width * 3, file);
+
+        // Convert from the file's BGR order
+        for (int c = 0; c < width; c++)
+        {
+            img->data[r][c].blue  = span[c * 3];
+            img->data[r][c].green = span[c * 3 + 1];
+            img->data[r][c].red   = span[c * 3 + 2];
+        }
+    }
+
+    free(span);
+    fclose(file);
+    return img;
+}
+
+
+t_bmp24 * bmp24_loadImageScaled (const char * filename, int factor, int average){
+    if (factor != 1 && factor != 2 && factor != 4 && factor != 8) {
+        printf("Error : Invalid scale factor %d (expected 1, 2, 4 or 8)\n", factor);
+        return NULL;
+    }
+
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        printf("Error : Opening of the file impossible %s\n", filename);
+        return NULL;
+    }
+
+    t_bmp_header header;
+    t_bmp_info info;
+
+    if (!bmp24_readHeaders(file, &header, &info))
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    // Partial blocks on the right and bottom edges are dropped
+    int width = info.width / factor > 0 ? info.width / factor : 1;
+    int height = info.height / factor > 0 ? info.height / factor : 1;
+    size_t rowSize = (((size_t)info.width * 3 + 3) / 4) * 4;
+    int rowsPerBlock = average ? factor : 1;
+
+    t_bmp24 * img = bmp24_allocate(width, height, info.bits);
+    uint8_t * row = malloc(rowSize);
+    unsigned int * sums = malloc((size_t)width * 3 * sizeof(unsigned int));
+    if (!img || !row || !sums) {
         printf("Error allocating memory for data\n");
+        if (img) bmp24_free(img);
+        free(row);
+        free(sums);
         fclose(file);
         return NULL;
     }
 
-    // Store header information in image structure
     img->header = header;
     img->header_info = info;
+    bmp24_updateHeaders(img);
 
-    // Read all pixel data from file
-    bmp24_readPixelData(img, file);
+    for (int oy = 0; oy < height; oy++)
+    {
+        // Point sampling reads the centre row of the block, averaging reads all of them.
+        // Every other row of the block is never read from disk.
+        int top = oy * factor + (average ? 0 : factor / 2);
+        if (top >= info.height) top = info.height - 1;
+        memset(sums, 0, width * 3 * sizeof(unsigned int));
+
+        // A block is cut short only when the image is smaller than factor
+        int rows = 0;
+        for (int k = 0; k < rowsPerBlock && top + k < info.height; k++, rows++)
+        {
+            uint64_t position = header.offset + (uint64_t)(info.height - 1 - (top + k)) * rowSize;
+            file_rawRead(position, row, sizeof(uint8_t), info.width * 3, file);
+
+            for (int ox = 0; ox < width; ox++)
+            {
+                if (average) {
+                    for (int j = 0; j < factor && ox * factor + j < info.width; j++)
+                        for (int c = 0; c < 3; c++)
+                            sums[ox * 3 + c] += row[(ox * factor + j) * 3 + c];
+                } else {
+                    int sx = ox * factor + factor / 2;
+                    if (sx >= info.width) sx = info.width - 1;
+                    for (int c = 0; c < 3; c++)
+                        sums[ox * 3 + c] = row[sx * 3 + c];
+                }
+            }
+        }
+
+        // File order is BGR
+        for (int ox = 0; ox < width; ox++)
+        {
+            int columns = info.width - ox * factor < factor ? info.width - ox * factor : factor;
+            int divisor = average ? rows * columns : 1;
+            img->data[oy][ox].blue  = (sums[ox * 3]     + divisor / 2) / divisor;
+            img->data[oy][ox].green = (sums[ox * 3 + 1] + divisor / 2) / divisor;
+            img->data[oy][ox].red   = (sums[ox * 3 + 2] + divisor / 2) / divisor;
+        }
+    }
 
+    free(row);
+    free(sums);
     fclose(file);
     return img;
 }
@@ -252,10 +523,12 @@ void bmp24_printInfo(t_bmp24 *img){
         return;
     }
     printf("Image Info :\n");
-    printf("Width : %u pixels\n", img->width);
-    printf("Height : %u pixels\n", img->height);
-    printf("Color Depth : %u bits\n", img->colorDepth);
-    printf("Data Size : %u bytes\n", img->header.size);
+    printf("Width : %d pixels\n", img->width);
+    printf("Height : %d pixels\n", img->height);
+    printf("Color Depth : %d bits\n", img->colorDepth);
+    // Recomputed in 64 bits: header.size is 0 for files above 4 GiB
+    uint64_t rowSize = (((uint64_t)img->width * 3 + 3) / 4) * 4;
+    printf("Data Size : %llu bytes\n", (unsigned long long)(img->header.offset + rowSize * img->height));
 }
 
 
@@ -294,93 +567,140 @@ void bmp24_saveImage(t_bmp24 *img, const char *filename){
 
 
 void bmp24_negative(t_bmp24 *img) {
-    for (int i = 0; i < img->height; i++) {
-        for (int j = 0; j < img->width; j++) {
-            // Invert each color channel by subtracting from maximum value (255)
-            img->data[i][j].red   = 255 - img->data[i][j].red;
-            img->data[i][j].green = 255 - img->data[i][j].green;
-            img->data[i][j].blue  = 255 - img->data[i][j].blue;
-        }
-    }
+    // Invert each color channel by subtracting from maximum value (255)
+    t_image_view view = view_fromBmp24(img);
+    view_negative(&view);
 }
 
 
 void bmp24_grayscale (t_bmp24 * img) {
-    for (int i = 0; i < img->height; i++) {
-        for (int j = 0; j < img->width; j++) {
-            // Calculate average of RGB values
-            uint8_t grayscale = (img->data[i][j].blue + img->data[i][j].green + img->data[i][j].red) / 3;
-
-            // Set all color channels to the same gray value
-            img->data[i][j].red   = grayscale;
-            img->data[i][j].green = grayscale;
-            img->data[i][j].blue  = grayscale;
-        }
-    }
+    // Set all color channels to the average of RGB values
+    t_image_view view = view_fromBmp24(img);
+    view_grayscale(&view);
 }
 
 
 void bmp24_brightness (t_bmp24 * img,  int value) {
-    for (int i = 0; i < img->height; i++) {
-        for (int j = 0; j < img->width; j++) {
-            // Adjust red channel with clamping to valid range [0, 255]
-            if (img->data[i][j].red + value > 255) {
-                img->data[i][j].red = 255;
-            } else if (img->data[i][j].red + value < 0) {
-                img->data[i][j].red = 0;
-            } else {
-                img->data[i][j].red += value;
-            }
+    // Adjust each channel with clamping to valid range [0, 255]
+    t_image_view view = view_fromBmp24(img);
+    view_brightness(&view, value);
+}
 
-            // Adjust green channel with clamping
-            if (img->data[i][j].green + value > 255) {
-                img->data[i][j].green = 255;
-            } else if (img->data[i][j].green + value < 0) {
-                img->data[i][j].green = 0;
-            } else {
-                img->data[i][j].green += value;
-            }
+void bmp24_horizontalFlip(t_bmp24 *img)
+{
+    t_image_view view = view_fromBmp24(img);
+    view_flipRows(&view);
+}
 
-            // Adjust blue channel with clamping
-            if (img->data[i][j].blue + value > 255) {
-                img->data[i][j].blue = 255;
-            } else if (img->data[i][j].blue + value < 0) {
-                img->data[i][j].blue = 0;
-            } else {
-                img->data[i][j].blue += value;
-            }
-        }
+void bmp24_verticalFlip(t_bmp24 *img)
+{
+    t_image_view view = view_fromBmp24(img);
+    view_flipColumns(&view);
+}
+
+void bmp24_rotate(t_bmp24 *img, int quarterTurns)
+{
+    int turns = ((quarterTurns % 4) + 4) % 4;
+    t_image_view view = view_fromBmp24(img);
+    if (turns == 0)
+        return;
+    if (turns == 2) {
+        view_flipRows(&view);
+        view_flipColumns(&view);
+        return;
+    }
+
+    // A quarter turn is a transposition followed by a mirror
+    if (img->width == img->height) {
+        view_transposeSquare(&view);
+        if (turns == 1) view_flipColumns(&view);
+        else view_flipRows(&view);
+        return;
     }
+
+    int width = img->height;
+    int height = img->width;
+    t_pixel **data = bmp24_allocateDataPixels(width, height);
+    if (!data)
+        return;
+
+    t_image_view rotated = view;
+    rotated.data = (uint8_t *)data[0];
+    rotated.width = width;
+    rotated.height = height;
+    rotated.stride = (ptrdiff_t)width * (ptrdiff_t)sizeof(t_pixel);
+    view_transform(&view, &rotated, 1, turns == 3, turns == 1);
+
+    bmp24_freeDataPixels(img->data, img->height);
+    img->data = data;
+    img->width = width;
+    img->height = height;
+    bmp24_updateHeaders(img);
 }
 
-void bmp24_horizontalFlip(t_bmp24 *img)
+
+// Copy rows into the pixels of img. Operations that keep the size write back
+// this way rather than replacing img->data, which may be a mapped file or a
+// shared memory segment
+static void bmp24_copyRows(t_bmp24 *img, t_pixel **data)
 {
-    t_pixel ** temp = bmp24_allocateDataPixels(img->width, img->height);
-    for (int i = 0; i < img->height; i++)
-        for (int j = 0; j < img->width; j++)
-            temp[i][j] = img->data[i][j];
-    for (int i = 0; i < img->height; i++)
-        for (int j = 0; j < img->width; j++)
-        {
-            img->data[i][j] = temp[img->height - i - 1][j];
-        }
-    for (int i = 0; i < img->height; i++) free(temp[i]);
-    free(temp);
+    for (int y = 0; y < img->height; y++)
+        memcpy(img->data[y], data[y], (size_t)img->width * sizeof(t_pixel));
 }
 
-void bmp24_verticalFlip(t_bmp24 *img)
+
+void bmp24_warp(t_bmp24 *img, const t_affine *transform, t_sampling sampling, unsigned char fill)
 {
-    t_pixel ** temp = bmp24_allocateDataPixels(img->width, img->height);
-    for (int i = 0; i < img->height; i++)
-        for (int j = 0; j < img->width; j++)
-            temp[i][j] = img->data[i][j];
-    for (int i = 0; i < img->height; i++)
-        for (int j = 0; j < img->width; j++)
-        {
-            img->data[i][j] = temp[i][img->width - j -1];
-        }
-    for (int i = 0; i < img->height; i++) free(temp[i]);
-    free(temp);
+    t_pixel **data = bmp24_allocateDataPixels(img->width, img->height);
+    if (!data)
+        return;
+
+    t_image_view view = view_fromBmp24(img);
+    t_image_view warped = view;
+    warped.data = (uint8_t *)data[0];
+    warped.stride = (ptrdiff_t)img->width * (ptrdiff_t)sizeof(t_pixel);
+    if (!view_warp(&view, &warped, transform, sampling, fill)) {
+        printf("Error: The transformation cannot be inverted\n");
+        bmp24_freeDataPixels(data, img->height);
+        return;
+    }
+
+    bmp24_copyRows(img, data);
+    bmp24_freeDataPixels(data, img->height);
+}
+
+
+void bmp24_rotateAngle(t_bmp24 *img, double degrees)
+{
+    t_affine rotation = affine_rotation(degrees, (img->width - 1) / 2.0, (img->height - 1) / 2.0);
+    bmp24_warp(img, &rotation, SAMPLE_BILINEAR, 255);
+}
+
+
+void bmp24_resize(t_bmp24 *img, int width, int height, t_sampling filter)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    t_pixel **data = bmp24_allocateDataPixels(width, height);
+    if (!data)
+        return;
+
+    t_image_view view = view_fromBmp24(img);
+    t_image_view resized = view;
+    resized.data = (uint8_t *)data[0];
+    resized.width = width;
+    resized.height = height;
+    resized.stride = (ptrdiff_t)width * (ptrdiff_t)sizeof(t_pixel);
+    if (!view_resize(&view, &resized, filter)) {
+        bmp24_freeDataPixels(data, height);
+        return;
+    }
+
+    bmp24_freeDataPixels(img->data, img->height);
+    img->data = data;
+    img->width = width;
+    img->height = height;
+    bmp24_updateHeaders(img);
 }
 
 // ========================================
@@ -402,6 +722,19 @@ float ** createKernel(int size)
 }
 
 
+float ** createScratchKernel(int size)
+{
+    // Row pointers and values, both released with the arena
+    float ** kernel = scratch_alloc(size * sizeof(float*));
+    float * values = scratch_alloc((size_t)size * size * sizeof(float));
+    if (!kernel || !values)
+        return NULL;
+    for (int i = 0; i < size; i++)
+        kernel[i] = values + i * size;
+    return kernel;
+}
+
+
 void freeKernel(float ** kernel, int size)
 {
     for (int i = 0; i < size; i++)
@@ -443,21 +776,39 @@ t_pixel bmp24_convolution ( t_bmp24 * img,  int x,  int y, float ** kernel,  int
 
 
 void bmp24_applyFilter(t_bmp24 *img, float **kernel, const int kernelSize) {
-    // Allocate temporary storage for filtered image
-    t_pixel** filterData = bmp24_allocateDataPixels(img->width, img->height);
-    int kernelCenter = (kernelSize - 1) / 2;
-
-    // Process only pixels where full kernel fits (skip edges)
-    for (int y = kernelCenter; y < img->height - kernelCenter; y++) {
-        for (int x = kernelCenter; x < img->width - kernelCenter; x++) {
-            // Apply convolution at this pixel
-            filterData[y][x] = bmp24_convolution(img, x, y, kernel, kernelSize);
-        }
+    // Pixels where the kernel does not fit keep their values
+    t_image_view view = view_fromBmp24(img);
+    if (!view_applyFilter(&view, kernel, kernelSize)) {
+        printf("Error allocating scratch memory\n");
     }
+}
 
-    // Replace original data with filtered data
-    bmp24_freeDataPixels(img->data, img->height);
-    img->data = filterData;
+
+void bmp24_applyFilters(t_bmp24 *img, float ***kernels, const int *kernelSizes, int count) {
+    t_image_view view = view_fromBmp24(img);
+    if (!view_applyFilters(&view, kernels, kernelSizes, count)) {
+        printf("Error allocating scratch memory\n");
+    }
+}
+
+
+void bmp24_rankFilter(t_bmp24 *img, int radius, int percentile) {
+    t_pixel **data = bmp24_allocateDataPixels(img->width, img->height);
+    if (!data)
+        return;
+
+    t_image_view view = view_fromBmp24(img);
+    t_image_view filtered = view;
+    filtered.data = (uint8_t *)data[0];
+    filtered.stride = (ptrdiff_t)img->width * (ptrdiff_t)sizeof(t_pixel);
+    if (view_rankFilter(&view, &filtered, radius, percentile))
+        bmp24_copyRows(img, data);
+    bmp24_freeDataPixels(data, img->height);
+}
+
+
+void bmp24_median(t_bmp24 *img, int radius) {
+    bmp24_rankFilter(img, radius, RANK_MEDIAN);
 }
 
 // ========================================
@@ -467,7 +818,9 @@ void bmp24_applyFilter(t_bmp24 *img, float **kernel, const int kernelSize) {
 
 void bmp24_boxBlur(t_bmp24 *img) {
     int kernelSize = 3;
-    float **box_blur = createKernel(kernelSize);
+    size_t mark = scratch_mark();
+    float **box_blur = createScratchKernel(kernelSize);
+    if (!box_blur) return;
 
     // Fill kernel with equal weights (1/9 for each position)
     for (int i = 0; i < kernelSize; i++) {
@@ -477,13 +830,15 @@ void bmp24_boxBlur(t_bmp24 *img) {
     }
 
     bmp24_applyFilter(img, box_blur, kernelSize);
-    freeKernel(box_blur, kernelSize);
+    scratch_release(mark);
 }
 
 
 void bmp24_gaussianBlur(t_bmp24 *img) {
     int kernelSize = 3;
-    float **gaussian_blur = createKernel(kernelSize);
+    size_t mark = scratch_mark();
+    float **gaussian_blur = createScratchKernel(kernelSize);
+    if (!gaussian_blur) return;
 
     // Gaussian kernel weights (center weighted)
     float values_gaussian[3][3] = {
@@ -498,13 +853,15 @@ void bmp24_gaussianBlur(t_bmp24 *img) {
             gaussian_blur[i][j] = values_gaussian[i][j];
 
     bmp24_applyFilter(img, gaussian_blur, kernelSize);
-    freeKernel(gaussian_blur, kernelSize);
+    scratch_release(mark);
 }
 
 
 void bmp24_outline(t_bmp24 *img) {
     int kernelSize = 3;
-    float **outline = createKernel(kernelSize);
+    size_t mark = scratch_mark();
+    float **outline = createScratchKernel(kernelSize);
+    if (!outline) return;
 
     // Edge detection kernel (Laplacian)
     float values_outline[3][3] = {
@@ -518,13 +875,15 @@ void bmp24_outline(t_bmp24 *img) {
             outline[i][j] = values_outline[i][j];
 
     bmp24_applyFilter(img, outline, kernelSize);
-    freeKernel(outline, kernelSize);
+    scratch_release(mark);
 }
 
 
 void bmp24_emboss(t_bmp24 *img) {
     int kernelSize = 3;
-    float **emboss = createKernel(kernelSize);
+    size_t mark = scratch_mark();
+    float **emboss = createScratchKernel(kernelSize);
+    if (!emboss) return;
 
     // Emboss kernel (simulates directional lighting)
     float values_emboss[3][3] = {
@@ -538,13 +897,15 @@ void bmp24_emboss(t_bmp24 *img) {
             emboss[i][j] = values_emboss[i][j];
 
     bmp24_applyFilter(img, emboss, kernelSize);
-    freeKernel(emboss, kernelSize);
+    scratch_release(mark);
 }
 
 
 void bmp24_sharpen(t_bmp24 *img) {
     int kernelSize = 3;
-    float **sharpen = createKernel(kernelSize);
+    size_t mark = scratch_mark();
+    float **sharpen = createScratchKernel(kernelSize);
+    if (!sharpen) return;
 
     // Sharpening kernel (enhances center pixel relative to neighbors)
     float values_sharpen[3][3] = {
@@ -558,12 +919,14 @@ void bmp24_sharpen(t_bmp24 *img) {
             sharpen[i][j] = values_sharpen[i][j];
 
     bmp24_applyFilter(img, sharpen, kernelSize);
-    freeKernel(sharpen, kernelSize);
+    scratch_release(mark);
 }
 
 void bmp24_sobelX(t_bmp24 *img) {
     int kernelSize = 3;
-    float **sobelX = createKernel(kernelSize);
+    size_t mark = scratch_mark();
+    float **sobelX = createScratchKernel(kernelSize);
+    if (!sobelX) return;
 
     // Sobel x kernel weights (center weighted)
     float values_sobelX[3][3] = {
@@ -578,12 +941,14 @@ void bmp24_sobelX(t_bmp24 *img) {
             sobelX[i][j] = values_sobelX[i][j];
 
     bmp24_applyFilter(img, sobelX, kernelSize);
-    freeKernel(sobelX, kernelSize);
+    scratch_release(mark);
 }
 
 void bmp24_sobelY(t_bmp24 *img) {
     int kernelSize = 3;
-    float **sobelY = createKernel(kernelSize);
+    size_t mark = scratch_mark();
+    float **sobelY = createScratchKernel(kernelSize);
+    if (!sobelY) return;
 
     // Sobel y kernel weights (center weighted)
     float values_sobelY[3][3] = {
@@ -598,12 +963,14 @@ void bmp24_sobelY(t_bmp24 *img) {
             sobelY[i][j] = values_sobelY[i][j];
 
     bmp24_applyFilter(img, sobelY, kernelSize);
-    freeKernel(sobelY, kernelSize);
+    scratch_release(mark);
 }
 
 void bmp24_motionBlur(t_bmp24 *img) {
     int kernelSize = 3;
-    float **motion = createKernel(kernelSize);
+    size_t mark = scratch_mark();
+    float **motion = createScratchKernel(kernelSize);
+    if (!motion) return;
 
     // motion blur kernel weights (center weighted)
     float values_motion[3][3] = {
@@ -618,29 +985,13 @@ void bmp24_motionBlur(t_bmp24 *img) {
             motion[i][j] = values_motion[i][j];
 
     bmp24_applyFilter(img, motion, kernelSize);
-    freeKernel(motion, kernelSize);
+    scratch_release(mark);
 }
 
 void bmp24_sepia(t_bmp24 *img)
 {
-
-    for (int i = 0; i < img->height; i++) {
-        for (int j = 0; j < img->width; j++) {
-            // Conversion for RGB to sepia scale
-            unsigned int R = (int)round(img->data[i][j].red * 0.393 + img->data[i][j].green * 0.769 + img->data[i][j].blue * 0.189);
-            unsigned int G = (int)round(img->data[i][j].red * 0.349 + img->data[i][j].green * 0.686 + img->data[i][j].blue * 0.168);
-            unsigned int B = (int)round(img->data[i][j].red * 0.272 + img->data[i][j].green * 0.534 + img->data[i][j].blue * 0.131);
-
-            // Clamp RGB values to the [0, 255] range
-            if (R > 255) R = 255;
-            if (G > 255) G = 255;
-            if (B > 255) B = 255;
-
-            img->data[i][j].red   = R;
-            img->data[i][j].green = G;
-            img->data[i][j].blue  = B;
-        }
-    }
+    t_image_view view = view_fromBmp24(img);
+    view_sepia(&view);
 }
 
 // ========================================
@@ -648,6 +999,23 @@ void bmp24_sepia(t_bmp24 *img)
 // ========================================
 
 
+// Convert one row using standard RGB to YUV conversion formulas
+static void bmp24_rowToYUV(const t_pixel *row, t_pixel_YUV *YUV, int width)
+{
+    for (int j = 0; j < width; j++)
+    {
+        // Y (luminance)
+        YUV[j].Y = 0.299 * row[j].red + 0.587 * row[j].green + 0.114 * row[j].blue;
+
+        // U (blue-yellow chrominance)
+        YUV[j].U = -0.14713 * row[j].red - 0.28886* row[j].green+ 0.436 * row[j].blue;
+
+        // V (red-cyan chrominance)
+        YUV[j].V = 0.625 * row[j].red - 0.51419 * row[j].green - 0.10001 * row[j].blue;
+    }
+}
+
+
 t_pixel_YUV ** RGB_to_YUV(t_bmp24 * img)
 {
     // Allocate YUV pixel array
@@ -655,80 +1023,91 @@ t_pixel_YUV ** RGB_to_YUV(t_bmp24 * img)
     for (int i = 0; i < img->height; i++)
         YUV[i] = (t_pixel_YUV *)malloc(img->width * sizeof(t_pixel_YUV));
 
-    // Convert each pixel using standard RGB to YUV conversion formulas
     for (int i = 0; i < img->height; i++)
-        for (int j = 0; j < img->width; j++)
-        {
-            // Y (luminance)
-            YUV[i][j].Y = 0.299 * img->data[i][j].red + 0.587 * img->data[i][j].green + 0.114 * img->data[i][j].blue;
-
-            // U (blue-yellow chrominance)
-            YUV[i][j].U = -0.14713 * img->data[i][j].red - 0.28886* img->data[i][j].green+ 0.436 * img->data[i][j].blue;
-
-            // V (red-cyan chrominance)
-            YUV[i][j].V = 0.625 * img->data[i][j].red - 0.51419 * img->data[i][j].green - 0.10001 * img->data[i][j].blue;
-        }
+        bmp24_rowToYUV(img->data[i], YUV[i], img->width);
     return YUV;
 }
 
 
-unsigned int * bmp24_computeHistogram(t_bmp24 * img)
+size_t * bmp24_computeHistogram(t_bmp24 * img)
 {
     // Initialize histogram array to zeros (256 possible brightness values)
-    unsigned int * hist = calloc(256 ,sizeof(unsigned int));
-
-    // Convert image to YUV to get luminance values
-    t_pixel_YUV ** YUV = RGB_to_YUV(img);
+    size_t * hist = calloc(256 ,sizeof(size_t));
+
+    // Convert image to YUV to get luminance values, one row at a time
+    size_t mark = scratch_mark();
+    t_pixel_YUV * YUV = scratch_alloc(img->width * sizeof(t_pixel_YUV));
+    if (!hist || !YUV) {
+        printf("Error allocating memory for the histogram\n");
+        scratch_release(mark);
+        free(hist);
+        return NULL;
+    }
 
     // Count frequency of each brightness level
     for (int i = 0; i < img->height ; i++)
+    {
+        bmp24_rowToYUV(img->data[i], YUV, img->width);
         for (int j = 0; j < img->width; j++)
         {
             // Round Y value and increment corresponding histogram bin
-            hist[(int)round(YUV[i][j].Y)]++;
+            hist[(int)round(YUV[j].Y)]++;
         }
-    for (int i = 0; i < img->height; i++) free(YUV[i]);
-    free(YUV);
+    }
+    scratch_release(mark);
     return hist;
 }
 
 
-unsigned int * bmp24_computeCDF(unsigned int * hist)
+unsigned int * bmp24_computeCDF(size_t * hist)
 {
     // Compute cumulative sum (CDF)
-  unsigned int * cdf = malloc(256 * sizeof(unsigned int));
-  unsigned int sum = 0;
+  size_t mark = scratch_mark();
+  size_t * cdf = scratch_alloc(256 * sizeof(size_t));
+  if (!cdf) return NULL;
+  size_t sum = 0;
   for (int i = 0; i < 256; i++){
       sum += hist[i];          // Add current histogram value to running sum
       cdf[i] = sum;           // Store cumulative sum
   }
 
     // Calculate equalization mapping
-  unsigned int N = cdf[255];              // Total number of pixels
-  unsigned int cdf_min = min_arr(cdf,256,N);        // Minimum non-zero CDF value
+  size_t N = cdf[255];              // Total number of pixels
+  size_t cdf_min = min_arr(cdf,256,N);        // Minimum non-zero CDF value
   unsigned int * hist_eq = malloc(256 * sizeof(unsigned int));
-  for (int i = 0; i < 255; i++)
+  for (int i = 0; i < 256; i++)
   {
-    hist_eq[i] = round((float)(cdf[i] - cdf_min) / (N - cdf_min) * 255);
+    hist_eq[i] = round((double)(cdf[i] - cdf_min) / (N - cdf_min) * 255);
   }
+  scratch_release(mark);
   return hist_eq;
 }
 
 void bmp24_equalize(t_bmp24 *img) {
     // Compute the histogram of the image based on Y (luminance) component
-    unsigned * hist = bmp24_computeHistogram(img);
+    size_t * hist = bmp24_computeHistogram(img);
 
     // Compute the equalized histogram using CDF
-    unsigned int * hist_eq = bmp24_computeCDF(hist);
-
-    // Convert RGB pixels to YUV color space to isolate brightness
-    t_pixel_YUV ** YUV = RGB_to_YUV(img);
+    unsigned int * hist_eq = hist ? bmp24_computeCDF(hist) : NULL;
+
+    // RGB pixels are converted to YUV color space to isolate brightness,
+    // one row at a time
+    size_t mark = scratch_mark();
+    t_pixel_YUV * YUV = scratch_alloc(img->width * sizeof(t_pixel_YUV));
+    if (!hist_eq || !YUV) {
+        printf("Error allocating memory for the equalization\n");
+        scratch_release(mark);
+        free(hist_eq);
+        free(hist);
+        return;
+    }
 
     // For each pixel in the image
     for (int y = 0; y < img->height; y++) {
+        bmp24_rowToYUV(img->data[y], YUV, img->width);
         for (int x = 0; x < img->width; x++) {
             // Get the original luminance value and ensure it's in [0, 255]
-            int y_val = (int)round(YUV[y][x].Y);
+            int y_val = (int)round(YUV[x].Y);
             if (y_val < 0) y_val = 0;
             if (y_val > 255) y_val = 255;
 
@@ -736,8 +1115,8 @@ void bmp24_equalize(t_bmp24 *img) {
             float new_Y = (float)hist_eq[y_val];
 
             // Retrieve U and V chrominance values
-            float U = YUV[y][x].U;
-            float V = YUV[y][x].V;
+            float U = YUV[x].U;
+            float V = YUV[x].V;
 
             // Convert equalized YUV back to RGB using standard conversion formulas
             int r = round(new_Y + 1.13983 * V);
@@ -759,8 +1138,7 @@ void bmp24_equalize(t_bmp24 *img) {
     // Free all allocated memory
     free(hist_eq);
     free(hist);
-    for (int i = 0; i < img->height; i++) free(YUV[i]);
-    free(YUV);
+    scratch_release(mark);
 }
 
 
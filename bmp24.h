@@ -17,6 +17,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "affine.h"
 
 #ifndef BMP24_H
 #define BMP24_H
@@ -40,6 +41,11 @@
 #define INFO_SIZE        0x28   /**< BMP info header size (40 bytes) */
 #define DEFAULT_DEPTH    0x18   /**< Default color depth (24 bits) */
 
+// Compression types (biCompression)
+#define COMPRESSION_RGB        0 /**< BI_RGB: uncompressed pixels */
+#define COMPRESSION_RLE8       1 /**< BI_RLE8: run-length encoded 8-bit pixels */
+#define COMPRESSION_BITFIELDS  3 /**< BI_BITFIELDS: uncompressed pixels described by channel masks */
+
 /* ============================================================================
  * STRUCTURE DEFINITIONS
  * ============================================================================ */
@@ -112,6 +118,10 @@ typedef struct {
  * 
  * Contains all data needed to represent and manipulate a 24-bit color BMP image,
  * including headers, metadata, and pixel data organized as a 2D array.
+ *
+ * The rows are stored one after the other in a single block taken from the
+ * buffer pool (see bufpool.h): data[0] is the start of the block and
+ * data[y] == data[0] + y * width. Rows must not be reordered.
  */
 typedef struct {
     t_bmp_header header;      /**< BMP file header */
@@ -132,16 +142,18 @@ typedef struct {
  * @param height Image height in pixels
  * @return Pointer to allocated 2D pixel array, or NULL on failure
  * 
- * Allocates a 2D array of t_pixel structures for storing image data.
+ * Allocates a 2D array of t_pixel structures for storing image data. The
+ * pixels are one contiguous block from the buffer pool; pixels[y] points to
+ * row y inside it.
  */
 t_pixel **bmp24_allocateDataPixels(int width, int height);
 
 /**
  * @brief Free memory allocated for 2D pixel array
  * @param pixels Pointer to 2D pixel array to free
- * @param height Height of the array (needed for proper deallocation)
+ * @param height Height of the array (unused: the rows share one block)
  * 
- * Properly deallocates a 2D pixel array including all rows.
+ * Gives the pixel block back to the buffer pool and frees the row pointers.
  */
 void bmp24_freeDataPixels(t_pixel **pixels, int height);
 
@@ -156,6 +168,19 @@ void bmp24_freeDataPixels(t_pixel **pixels, int height);
  */
 t_bmp24 *bmp24_allocate(int width, int height, int colorDepth);
 
+/**
+ * @brief Refresh the size fields of the headers from the image dimensions
+ * @param img Pointer to BMP24 structure, after its width or height changed
+ */
+void bmp24_updateHeaders(t_bmp24 *img);
+
+/**
+ * @brief Duplicate a BMP24 image
+ * @param img Pointer to BMP24 structure to copy
+ * @return Newly allocated copy with the same headers, or NULL on failure
+ */
+t_bmp24 *bmp24_copy(t_bmp24 *img);
+
 /**
  * @brief Free all memory associated with a BMP24 structure
  * @param img Pointer to BMP24 structure to free
@@ -178,6 +203,33 @@ void bmp24_free(t_bmp24 *img);
  */
 t_bmp24 *bmp24_loadImage(const char *filename);
 
+/**
+ * @brief Load only a rectangular region of a 24-bit BMP image
+ * @param filename Path to the BMP file to load
+ * @param x Left column of the region
+ * @param y Top row of the region
+ * @param width Region width in pixels
+ * @param height Region height in pixels
+ * @return Pointer to a t_bmp24 holding just the region, or NULL on failure
+ *
+ * Computes each scanline position from the pixel data offset and the padded
+ * row size (as bmp24_readPixelValue does) and reads only the requested span
+ * of the rows inside the region. Headers are updated to the region size.
+ */
+t_bmp24 *bmp24_loadImageROI(const char *filename, int x, int y, int width, int height);
+
+/**
+ * @brief Load a reduced-size preview of a 24-bit BMP image
+ * @param filename Path to the BMP file to load
+ * @param factor Reduction factor: 1, 2, 4 or 8
+ * @param average Non-zero to average each factor x factor block, 0 to point-sample it
+ * @return Pointer to a t_bmp24 of size (width / factor) x (height / factor), or NULL on failure
+ *
+ * Decodes while reading scanlines, one read per row actually used. With point
+ * sampling only one row in factor is read from disk.
+ */
+t_bmp24 *bmp24_loadImageScaled(const char *filename, int factor, int average);
+
 /**
  * @brief Save a 24-bit BMP image to file
  * @param img Pointer to BMP24 structure to save
@@ -199,6 +251,26 @@ void bmp24_printInfo(t_bmp24 *img);
  * LOW-LEVEL FILE ACCESS FUNCTIONS
  * ============================================================================ */
 
+/**
+ * @brief Seek to an absolute 64-bit file position
+ * @param file File pointer to reposition
+ * @param position Byte offset from the start of the file
+ * @return 0 on success, non-zero on failure
+ *
+ * Portable replacement for fseek, whose long offset is 32 bits on Windows.
+ */
+int file_seek64(FILE *file, uint64_t position);
+
+/**
+ * @brief Size of a file, with a 64-bit position
+ * @param file File pointer, left at the end of the file
+ * @return Size in bytes, or 0 on failure
+ *
+ * Portable replacement for fseek/ftell to the end, whose long is 32 bits
+ * on Windows.
+ */
+uint64_t file_size64(FILE *file);
+
 /**
  * @brief Read raw data from specific file position
  * @param position File position to read from
@@ -209,7 +281,7 @@ void bmp24_printInfo(t_bmp24 *img);
  * 
  * Seeks to specified position and reads raw binary data.
  */
-void file_rawRead(uint32_t position, void *buffer, uint32_t size, size_t n, FILE *file);
+void file_rawRead(uint64_t position, void *buffer, size_t size, size_t n, FILE *file);
 
 /**
  * @brief Write raw data to specific file position
@@ -221,7 +293,7 @@ void file_rawRead(uint32_t position, void *buffer, uint32_t size, size_t n, FILE
  * 
  * Seeks to specified position and writes raw binary data.
  */
-void file_rawWrite(uint32_t position, void *buffer, uint32_t size, size_t n, FILE *file);
+void file_rawWrite(uint64_t position, void *buffer, size_t size, size_t n, FILE *file);
 
 /* ============================================================================
  * PIXEL-LEVEL I/O FUNCTIONS
@@ -243,7 +315,8 @@ void bmp24_readPixelValue(t_bmp24 *image, int x, int y, FILE *file);
  * @param image Pointer to BMP24 structure
  * @param file File pointer to read from
  * 
- * Reads all pixel data from file into the image structure.
+ * Reads all pixel data from file into the image structure, streaming the
+ * pixel array one padded row at a time from a single seek.
  */
 void bmp24_readPixelData(t_bmp24 *image, FILE *file);
 
@@ -263,7 +336,8 @@ void bmp24_writePixelValue(t_bmp24 *image, int x, int y, FILE *file);
  * @param image Pointer to BMP24 structure
  * @param file File pointer to write to
  * 
- * Writes all pixel data from image structure to file.
+ * Writes all pixel data from image structure to file, streaming one
+ * padded row at a time.
  */
 void bmp24_writePixelData(t_bmp24 *image, FILE *file);
 
@@ -301,7 +375,8 @@ void bmp24_brightness(t_bmp24 *img, int value);
  * @brief Flip the image horizontally
  * @param img Pointer to the image to modify
  *
- * Convert an image into its horizontal mirrored versions
+ * Convert an image into its horizontal mirrored versions. Rows are swapped
+ * in place; the row pointers keep pointing at the same memory.
  */
 void bmp24_horizontalFlip(t_bmp24 *img);
 
@@ -309,10 +384,59 @@ void bmp24_horizontalFlip(t_bmp24 *img);
  * @brief Flip the image vertically
  * @param img Pointer to the image to modify
  *
- * Convert an image into its vertical mirrored versions
+ * Convert an image into its vertical mirrored versions. Each row is
+ * reversed in place.
  */
 void bmp24_verticalFlip(t_bmp24 *img);
 
+/**
+ * @brief Rotate the image by a multiple of 90 degrees
+ * @param img Pointer to the image to modify
+ * @param quarterTurns Number of quarter turns clockwise (negative for counterclockwise)
+ *
+ * Half turns and square images are rotated in place. Other quarter turns
+ * write the pixels in one pass into a new block from the pool, which
+ * replaces the old one; width, height, rows and headers are updated.
+ */
+void bmp24_rotate(t_bmp24 *img, int quarterTurns);
+
+/**
+ * @brief Apply an affine transformation (rotation, scale, shear) to the image
+ * @param img Pointer to the image to modify
+ * @param transform Where each pixel goes, in top-down pixel coordinates
+ * @param sampling SAMPLE_NEAREST or SAMPLE_BILINEAR
+ * @param fill Value of the areas that come from outside the image
+ *
+ * The image keeps its size: what is moved out is cut, what is uncovered
+ * takes the fill value. The result is drawn tile by tile into a buffer from
+ * the pool, which replaces the old one (see view_warp).
+ */
+void bmp24_warp(t_bmp24 *img, const t_affine *transform, t_sampling sampling, unsigned char fill);
+
+/**
+ * @brief Rotate the image by any angle around its centre
+ * @param img Pointer to the image to modify
+ * @param degrees Angle, clockwise (negative for counterclockwise)
+ *
+ * Meant for small corrections such as deskewing a scan: bilinear sampling,
+ * same size, corners filled with white.
+ */
+void bmp24_rotateAngle(t_bmp24 *img, double degrees);
+
+/**
+ * @brief Resize the image
+ * @param img Pointer to the image to modify
+ * @param width New width in pixels
+ * @param height New height in pixels
+ * @param filter SAMPLE_AREA for thumbnails, SAMPLE_BILINEAR, SAMPLE_BICUBIC,
+ *               SAMPLE_LANCZOS3 (sharpest) or SAMPLE_NEAREST
+ *
+ * The pixels are resized into a buffer from the pool, which replaces the
+ * old one, and the header is updated (see view_resize). Weight tables are
+ * cached, so resizing a batch of images of the same size computes them once.
+ */
+void bmp24_resize(t_bmp24 *img, int width, int height, t_sampling filter);
+
 /* ============================================================================
  * CONVOLUTION AND KERNEL FUNCTIONS
  * ============================================================================ */
@@ -335,6 +459,16 @@ float **createKernel(int size);
  */
 void freeKernel(float **kernel, int size);
 
+/**
+ * @brief Create a square convolution kernel in the scratch arena
+ * @param size Size of the square kernel
+ * @return Pointer to 2D float array, or NULL if the arena is full
+ *
+ * Same as createKernel without any malloc: the kernel is released with
+ * scratch_release (see scratch.h), never with freeKernel.
+ */
+float **createScratchKernel(int size);
+
 /**
  * @brief Apply convolution operation to a single pixel
  * @param img Pointer to image
@@ -354,10 +488,44 @@ t_pixel bmp24_convolution(t_bmp24 *img, int x, int y, float **kernel, int kernel
  * @param kernel Convolution kernel
  * @param kernelSize Size of the kernel
  * 
- * Applies convolution filter to all applicable pixels in the image.
+ * Applies convolution filter to all applicable pixels in the image. Border
+ * pixels are left unchanged. The source copy comes from the scratch arena.
  */
 void bmp24_applyFilter(t_bmp24 *img, float **kernel, const int kernelSize);
 
+/**
+ * @brief Apply several convolution filters in a row
+ * @param img Pointer to image to modify
+ * @param kernels Convolution kernels, first applied first
+ * @param kernelSizes Size of each kernel
+ * @param count Number of kernels
+ *
+ * Same result as calling bmp24_applyFilter for each kernel, computed tile
+ * by tile so that the image is read and written only once.
+ */
+void bmp24_applyFilters(t_bmp24 *img, float ***kernels, const int *kernelSizes, int count);
+
+/**
+ * @brief Apply a rank filter to each channel of the image
+ * @param img Pointer to image to modify
+ * @param radius Half side of the square around each pixel, 1 to RANK_MAX_RADIUS
+ * @param percentile 0 for the minimum, RANK_MEDIAN for the median, 100 for
+ *                   the maximum, or any rank in between
+ *
+ * Red, green and blue are filtered separately (see view_rankFilter); the
+ * time does not depend on the radius.
+ */
+void bmp24_rankFilter(t_bmp24 *img, int radius, int percentile);
+
+/**
+ * @brief Apply a median filter to each channel of the image
+ * @param img Pointer to image to modify
+ * @param radius Half side of the square around each pixel, 1 to RANK_MAX_RADIUS
+ *
+ * Removes salt and pepper noise while keeping edges sharp, unlike blurs.
+ */
+void bmp24_median(t_bmp24 *img, int radius);
+
 /* ============================================================================
  * PREDEFINED FILTER FUNCTIONS
  * ============================================================================ */
@@ -457,11 +625,11 @@ t_pixel_YUV **RGB_to_YUV(t_bmp24 *img);
 /**
  * @brief Compute histogram of luminance values
  * @param img Pointer to color image
- * @return Array of 256 integers representing luminance frequency distribution
+ * @return Array of 256 counts representing luminance frequency distribution
  * 
  * Computes histogram based on Y (luminance) component in YUV color space.
  */
-unsigned int *bmp24_computeHistogram(t_bmp24 *img);
+size_t *bmp24_computeHistogram(t_bmp24 *img);
 
 /**
  * @brief Compute cumulative distribution function for histogram equalization
@@ -470,7 +638,7 @@ unsigned int *bmp24_computeHistogram(t_bmp24 *img);
  * 
  * Computes CDF and creates mapping for histogram equalization of color images.
  */
-unsigned int *bmp24_computeCDF(unsigned int *hist);
+unsigned int *bmp24_computeCDF(size_t *hist);
 
 /**
  * @brief Apply histogram equalization to color image
@@ -0,0 +1,437 @@
+/**
+ * @file bmp32.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief 32-bit BGRA BMP image processing library
+ *
+ * This file contains the loading, saving and processing functions of the
+ * 32-bit BGRA working format. Pixels are 4-byte aligned and rows are aligned
+ * to BMP32_ALIGNMENT bytes, so point operations and convolutions work on whole
+ * pixels instead of 3-byte triplets.
+ *
+ */
+
+#include "bmp32.h"
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Channel masks written in BI_BITFIELDS files (BGRA byte order)
+#define MASK_RED    0x00FF0000u
+#define MASK_GREEN  0x0000FF00u
+#define MASK_BLUE   0x000000FFu
+#define MASK_ALPHA  0xFF000000u
+
+// ========================================
+// MEMORY MANAGEMENT FUNCTIONS
+// ========================================
+
+
+/**
+ * Allocate size bytes aligned to BMP32_ALIGNMENT.
+ */
+static void *bmp32_alignedAlloc(size_t size)
+{
+#ifdef _WIN32
+    return _aligned_malloc(size, BMP32_ALIGNMENT);
+#else
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, BMP32_ALIGNMENT, size) != 0)
+        return NULL;
+    return ptr;
+#endif
+}
+
+
+static void bmp32_alignedFree(void *ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+
+t_bmp32 * bmp32_allocate(int width, int height){
+    t_bmp32 *img = (t_bmp32 *)malloc(sizeof(t_bmp32));
+    if (!img) {
+        printf("Error allocating memory for image\n");
+        return NULL;
+    }
+
+    // Round the stride up so that every row starts on an aligned address
+    int pixelsPerLine = BMP32_ALIGNMENT / sizeof(t_pixel32);
+    img->width = width;
+    img->height = height;
+    img->stride = (width + pixelsPerLine - 1) / pixelsPerLine * pixelsPerLine;
+    img->data = bmp32_alignedAlloc((size_t)img->stride * height * sizeof(t_pixel32));
+    if (!img->data) {
+        printf("Error allocating memory for data\n");
+        free(img);
+        return NULL;
+    }
+
+    // Headers describe the file bmp32_saveImage writes: V4 header, BGRA bitfields
+    uint64_t imageSize = (uint64_t)width * height * 4;
+    memset(&img->header, 0, sizeof(img->header));
+    memset(&img->header_info, 0, sizeof(img->header_info));
+    img->header.type = BMP_TYPE;
+    img->header.offset = HEADER_SIZE + INFO_V4_SIZE;
+    img->header.size = imageSize > UINT32_MAX - img->header.offset ? 0 : (uint32_t)(img->header.offset + imageSize);
+    img->header_info.size = INFO_V4_SIZE;
+    img->header_info.width = width;
+    img->header_info.height = height;
+    img->header_info.planes = 1;
+    img->header_info.bits = 32;
+    img->header_info.compression = COMPRESSION_BITFIELDS;
+    img->header_info.imagesize = imageSize > UINT32_MAX ? 0 : (uint32_t)imageSize;
+    img->header_info.xresolution = 2835;   // 72 DPI
+    img->header_info.yresolution = 2835;
+    return img;
+}
+
+
+void bmp32_free(t_bmp32 * img){
+    if (img) {
+        bmp32_alignedFree(img->data);
+        free(img);
+    }
+}
+
+// ========================================
+// BMP FILE LOADING AND SAVING
+// ========================================
+
+
+/**
+ * Number of trailing zero bits of a channel mask and the maximum value of the
+ * channel, used to rescale any bitfield to 8 bits.
+ */
+static void bmp32_maskShift(uint32_t mask, int *shift, uint32_t *max)
+{
+    *shift = 0;
+    *max = 0;
+    if (!mask) return;
+    while (!(mask & 1u)) {
+        mask >>= 1;
+        (*shift)++;
+    }
+    *max = mask;
+}
+
+
+static uint8_t bmp32_extract(uint32_t value, uint32_t mask, int shift, uint32_t max)
+{
+    if (!mask) return 255;   // Missing channel (usually alpha): opaque
+    return (uint8_t)((((value & mask) >> shift) * 255 + max / 2) / max);
+}
+
+
+t_bmp32 * bmp32_loadImage(const char * filename){
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        printf("Error : Opening of the file impossible %s\n", filename);
+        return NULL;
+    }
+
+    t_bmp_header header;
+    t_bmp_info info;
+    file_rawRead(BITMAP_MAGIC, &header.type, sizeof(uint16_t), 1, file);
+    file_rawRead(BITMAP_SIZE, &header.size, sizeof(uint32_t), 1, file);
+    file_rawRead(BITMAP_OFFSET, &header.offset, sizeof(uint32_t), 1, file);
+    file_rawRead(HEADER_SIZE, &info, sizeof(t_bmp_info), 1, file);
+
+    if (header.type != BMP_TYPE) {
+        printf("Error : File is not a BMP file\n");
+        fclose(file);
+        return NULL;
+    }
+    if (info.bits != 32 && info.bits != 24) {
+        printf("Error : File is not 32 or 24 bit\n");
+        fclose(file);
+        return NULL;
+    }
+    if (info.compression != COMPRESSION_RGB && !(info.bits == 32 && info.compression == COMPRESSION_BITFIELDS)) {
+        printf("Error : Unsupported compression %u\n", info.compression);
+        fclose(file);
+        return NULL;
+    }
+
+    // Channel masks: right after the 40-byte info header (or inside a V4/V5 header)
+    uint32_t masks[4] = {MASK_RED, MASK_GREEN, MASK_BLUE, 0};   // Alpha ignored in BI_RGB
+    if (info.compression == COMPRESSION_BITFIELDS) {
+        file_rawRead(HEADER_SIZE + INFO_SIZE, masks, sizeof(uint32_t), 3, file);
+        if (info.size >= INFO_SIZE + 16)
+            file_rawRead(HEADER_SIZE + INFO_SIZE + 12, &masks[3], sizeof(uint32_t), 1, file);
+    }
+    int directCopy = info.bits == 32 && masks[0] == MASK_RED && masks[1] == MASK_GREEN
+                     && masks[2] == MASK_BLUE && masks[3] == MASK_ALPHA;
+
+    // A negative height means the rows are stored top-down
+    int topDown = info.height < 0;
+    int height = topDown ? -info.height : info.height;
+    t_bmp32 *img = bmp32_allocate(info.width, height);
+    size_t rowSize = (((size_t)info.width * info.bits / 8) + 3) / 4 * 4;
+    uint8_t *row = malloc(rowSize);
+    if (!img || !row) {
+        printf("Error allocating memory for data\n");
+        bmp32_free(img);
+        free(row);
+        fclose(file);
+        return NULL;
+    }
+
+    int shifts[4];
+    uint32_t maxima[4];
+    for (int c = 0; c < 4; c++)
+        bmp32_maskShift(masks[c], &shifts[c], &maxima[c]);
+
+    // Stream the pixel array sequentially from a single seek
+    file_seek64(file, header.offset);
+    for (int r = 0; r < height; r++) {
+        int y = topDown ? r : height - 1 - r;
+        t_pixel32 *dst = img->data + (size_t)y * img->stride;
+
+        if (directCopy) {
+            // Same layout as in memory: read the row straight into the buffer
+            fread(dst, sizeof(t_pixel32), info.width, file);
+            continue;
+        }
+
+        fread(row, 1, rowSize, file);
+        for (int x = 0; x < info.width; x++) {
+            if (info.bits == 24) {
+                dst[x].blue  = row[x * 3];
+                dst[x].green = row[x * 3 + 1];
+                dst[x].red   = row[x * 3 + 2];
+                dst[x].alpha = 255;
+            } else {
+                uint32_t value;
+                memcpy(&value, row + x * 4, sizeof(value));
+                dst[x].red   = bmp32_extract(value, masks[0], shifts[0], maxima[0]);
+                dst[x].green = bmp32_extract(value, masks[1], shifts[1], maxima[1]);
+                dst[x].blue  = bmp32_extract(value, masks[2], shifts[2], maxima[2]);
+                dst[x].alpha = bmp32_extract(value, masks[3], shifts[3], maxima[3]);
+            }
+        }
+    }
+
+    // Keep the resolution of the source; the other fields describe the file we write
+    img->header_info.xresolution = info.xresolution;
+    img->header_info.yresolution = info.yresolution;
+
+    free(row);
+    fclose(file);
+    return img;
+}
+
+
+void bmp32_saveImage(t_bmp32 *img, const char *filename){
+    if (!img) {
+        printf("Error: Invalid image pointer\n");
+        return;
+    }
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        printf("Error: Opening of the file impossible %s\n", filename);
+        return;
+    }
+
+    // File header (14 bytes), then the 40 common bytes of the info header
+    uint64_t imageSize = (uint64_t)img->width * img->height * 4;
+    img->header.type = BMP_TYPE;
+    img->header.offset = HEADER_SIZE + INFO_V4_SIZE;
+    img->header.size = imageSize > UINT32_MAX - img->header.offset ? 0 : (uint32_t)(img->header.offset + imageSize);
+    img->header_info.size = INFO_V4_SIZE;
+    img->header_info.width = img->width;
+    img->header_info.height = img->height;   // Positive: bottom-up rows
+    img->header_info.planes = 1;
+    img->header_info.bits = 32;
+    img->header_info.compression = COMPRESSION_BITFIELDS;
+    img->header_info.imagesize = imageSize > UINT32_MAX ? 0 : (uint32_t)imageSize;
+    img->header_info.ncolors = 0;
+    img->header_info.importantcolors = 0;
+    file_rawWrite(BITMAP_MAGIC, &img->header.type, sizeof(uint16_t), 1, file);
+    file_rawWrite(BITMAP_SIZE, &img->header.size, sizeof(uint32_t), 1, file);
+    file_rawWrite(BITMAP_OFFSET, &img->header.offset, sizeof(uint32_t), 1, file);
+    file_rawWrite(HEADER_SIZE, &img->header_info, sizeof(t_bmp_info), 1, file);
+
+    // V4 extension: RGBA masks, 'sRGB' color space, then endpoints and gamma (unused)
+    uint8_t v4[INFO_V4_SIZE - INFO_SIZE] = {0};
+    uint32_t masks[5] = {MASK_RED, MASK_GREEN, MASK_BLUE, MASK_ALPHA, 0x73524742u};
+    memcpy(v4, masks, sizeof(masks));
+    fwrite(v4, 1, sizeof(v4), file);
+
+    // 4-byte pixels never need row padding: write each row straight from the buffer
+    for (int y = img->height - 1; y >= 0; y--)
+        fwrite(img->data + (size_t)y * img->stride, sizeof(t_pixel32), img->width, file);
+
+    fclose(file);
+    printf("Image successfully saved\n");
+}
+
+
+t_bmp32 * bmp32_fromBmp24(t_bmp24 *img){
+    t_bmp32 *out = bmp32_allocate(img->width, img->height);
+    if (!out) return NULL;
+    out->header_info.xresolution = img->header_info.xresolution;
+    out->header_info.yresolution = img->header_info.yresolution;
+
+    for (int y = 0; y < img->height; y++) {
+        t_pixel32 *dst = out->data + (size_t)y * out->stride;
+        for (int x = 0; x < img->width; x++) {
+            dst[x].red   = img->data[y][x].red;
+            dst[x].green = img->data[y][x].green;
+            dst[x].blue  = img->data[y][x].blue;
+            dst[x].alpha = 255;
+        }
+    }
+    return out;
+}
+
+
+t_bmp24 * bmp32_toBmp24(t_bmp32 *img){
+    t_bmp24 *out = bmp24_allocate(img->width, img->height, DEFAULT_DEPTH);
+    if (!out) return NULL;
+
+    // Plain 24-bit headers (54 bytes, BI_RGB)
+    uint64_t rowSize = (((uint64_t)img->width * 3 + 3) / 4) * 4;
+    uint64_t imageSize = rowSize * img->height;
+    out->header = img->header;
+    out->header.offset = HEADER_SIZE + INFO_SIZE;
+    out->header.size = imageSize > UINT32_MAX - out->header.offset ? 0 : (uint32_t)(out->header.offset + imageSize);
+    out->header_info = img->header_info;
+    out->header_info.size = INFO_SIZE;
+    out->header_info.bits = DEFAULT_DEPTH;
+    out->header_info.compression = COMPRESSION_RGB;
+    out->header_info.imagesize = imageSize > UINT32_MAX ? 0 : (uint32_t)imageSize;
+
+    for (int y = 0; y < img->height; y++) {
+        const t_pixel32 *src = img->data + (size_t)y * img->stride;
+        for (int x = 0; x < img->width; x++) {
+            out->data[y][x].red   = src[x].red;
+            out->data[y][x].green = src[x].green;
+            out->data[y][x].blue  = src[x].blue;
+        }
+    }
+    return out;
+}
+
+
+void bmp32_printInfo(t_bmp32 *img){
+    if (!img) {
+        printf("Erreur : Image non valide\n");
+        return;
+    }
+    printf("Image Info :\n");
+    printf("Width : %d pixels\n", img->width);
+    printf("Height : %d pixels\n", img->height);
+    printf("Color Depth : 32 bits (BGRA)\n");
+    printf("Data Size : %llu bytes\n", (unsigned long long)img->width * img->height * 4);
+}
+
+// ========================================
+// IMAGE PROCESSING FUNCTIONS
+// ========================================
+
+
+void bmp32_negative(t_bmp32 *img){
+    for (int y = 0; y < img->height; y++) {
+        // One XOR per pixel inverts blue, green and red and leaves alpha
+        uint32_t *row = (uint32_t *)(img->data + (size_t)y * img->stride);
+        for (int x = 0; x < img->width; x++)
+            row[x] ^= MASK_RED | MASK_GREEN | MASK_BLUE;
+    }
+}
+
+
+void bmp32_grayscale(t_bmp32 *img){
+    for (int y = 0; y < img->height; y++) {
+        t_pixel32 *row = img->data + (size_t)y * img->stride;
+        for (int x = 0; x < img->width; x++) {
+            uint8_t gray = (row[x].red + row[x].green + row[x].blue) / 3;
+            row[x].red = gray;
+            row[x].green = gray;
+            row[x].blue = gray;
+        }
+    }
+}
+
+
+void bmp32_brightness(t_bmp32 *img, int value){
+    // Clamped result for every possible channel value
+    uint8_t lut[256];
+    for (int i = 0; i < 256; i++) {
+        int v = i + value;
+        lut[i] = v > 255 ? 255 : (v < 0 ? 0 : v);
+    }
+
+    for (int y = 0; y < img->height; y++) {
+        t_pixel32 *row = img->data + (size_t)y * img->stride;
+        for (int x = 0; x < img->width; x++) {
+            row[x].red   = lut[row[x].red];
+            row[x].green = lut[row[x].green];
+            row[x].blue  = lut[row[x].blue];
+        }
+    }
+}
+
+
+void bmp32_applyFilter(t_bmp32 *img, float **kernel, int kernelSize){
+    int n = kernelSize / 2;
+    size_t total = (size_t)img->stride * img->height;
+
+    // Convolution reads from an unmodified copy of the image
+    t_pixel32 *src = bmp32_alignedAlloc(total * sizeof(t_pixel32));
+    if (!src) {
+        printf("Error allocating memory for the filter.\n");
+        return;
+    }
+    memcpy(src, img->data, total * sizeof(t_pixel32));
+
+    for (int y = n; y < img->height - n; y++) {
+        t_pixel32 *dst = img->data + (size_t)y * img->stride;
+        for (int x = n; x < img->width - n; x++) {
+#if defined(__SSE2__)
+            // Widen the 4 channels of each pixel to floats, accumulate, then pack with saturation
+            __m128 acc = _mm_setzero_ps();
+            const __m128i zero = _mm_setzero_si128();
+            for (int ky = -n; ky <= n; ky++) {
+                const t_pixel32 *line = src + (size_t)(y + ky) * img->stride + x;
+                for (int kx = -n; kx <= n; kx++) {
+                    int bgra;
+                    memcpy(&bgra, line + kx, sizeof(bgra));
+                    __m128i p = _mm_cvtsi32_si128(bgra);
+                    p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(p, zero), zero);
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_cvtepi32_ps(p), _mm_set1_ps(kernel[ky + n][kx + n])));
+                }
+            }
+            __m128i result = _mm_cvttps_epi32(acc);            // Truncate like the (uint8_t) cast
+            result = _mm_packs_epi32(result, result);
+            result = _mm_packus_epi16(result, result);         // Clamp to [0, 255]
+            uint8_t alpha = dst[x].alpha;
+            int bgra = _mm_cvtsi128_si32(result);
+            memcpy(dst + x, &bgra, sizeof(bgra));
+            dst[x].alpha = alpha;
+#else
+            float blue = 0.0f, green = 0.0f, red = 0.0f;
+            for (int ky = -n; ky <= n; ky++) {
+                const t_pixel32 *line = src + (size_t)(y + ky) * img->stride + x;
+                for (int kx = -n; kx <= n; kx++) {
+                    float k = kernel[ky + n][kx + n];
+                    blue  += line[kx].blue * k;
+                    green += line[kx].green * k;
+                    red   += line[kx].red * k;
+                }
+            }
+            dst[x].blue  = (blue > 255) ? 255 : ((blue < 0) ? 0 : (uint8_t)blue);
+            dst[x].green = (green > 255) ? 255 : ((green < 0) ? 0 : (uint8_t)green);
+            dst[x].red   = (red > 255) ? 255 : ((red < 0) ? 0 : (uint8_t)red);
+#endif
+        }
+    }
+
+    bmp32_alignedFree(src);
+}
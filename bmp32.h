@@ -0,0 +1,172 @@
+/**
+ * @file bmp32.h
+ * @brief Header file for 32-bit BGRA BMP image processing
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines the structures and function prototypes for a
+ * 32-bit BGRA working format. Each pixel is 4 bytes, in the same order as in
+ * a 32-bit BMP file, and rows are stored contiguously in one aligned buffer:
+ * - Loading of 32-bit BMPs (BI_RGB and BI_BITFIELDS) and of 24-bit BMPs,
+ *   converted on load
+ * - Saving as BI_BITFIELDS BGRA with a BITMAPV4HEADER so alpha is kept
+ * - Point operations and convolution on 4-byte aligned pixels, alpha carried through
+ */
+
+#ifndef BMP32_H
+#define BMP32_H
+
+#include "bmp24.h"
+
+/* ============================================================================
+ * BMP FILE FORMAT CONSTANTS
+ * ============================================================================ */
+
+#define INFO_V4_SIZE     0x6C   /**< BITMAPV4HEADER size (108 bytes) */
+#define BMP32_ALIGNMENT  64     /**< Alignment of the pixel buffer and of each row, in bytes */
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @struct t_pixel32
+ * @brief BGRA pixel structure for 32-bit color
+ *
+ * Same byte order as a 32-bit BMP file, so rows can be read and written
+ * without any reordering. Four pixels fill exactly one 16-byte SIMD register.
+ */
+typedef struct {
+    uint8_t blue;   /**< Blue color component (0-255) */
+    uint8_t green;  /**< Green color component (0-255) */
+    uint8_t red;    /**< Red color component (0-255) */
+    uint8_t alpha;  /**< Alpha component (0 = transparent, 255 = opaque) */
+} t_pixel32;
+
+/**
+ * @struct t_bmp32
+ * @brief Complete 32-bit BGRA image structure
+ *
+ * Pixels are stored top row first in a single buffer aligned to
+ * BMP32_ALIGNMENT bytes. Row y starts at data + y * stride, and the stride is
+ * rounded up so that every row starts on an aligned address.
+ */
+typedef struct {
+    t_bmp_header header;      /**< BMP file header */
+    t_bmp_info header_info;   /**< BMP information header (first 40 bytes) */
+    int width;                /**< Image width in pixels */
+    int height;               /**< Image height in pixels */
+    int stride;               /**< Pixels between the starts of two rows */
+    t_pixel32 *data;          /**< Aligned pixel buffer, stride * height pixels */
+} t_bmp32;
+
+/* ============================================================================
+ * MEMORY MANAGEMENT FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Allocate a 32-bit image with aligned rows
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @return Pointer to allocated t_bmp32 structure, or NULL on failure
+ *
+ * Headers are initialised for a BI_BITFIELDS BGRA file; pixel data is left
+ * uninitialised.
+ */
+t_bmp32 *bmp32_allocate(int width, int height);
+
+/**
+ * @brief Free all memory associated with a BMP32 structure
+ * @param img Pointer to BMP32 structure to free
+ */
+void bmp32_free(t_bmp32 *img);
+
+/* ============================================================================
+ * FILE I/O AND CONVERSION FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Load a 32-bit or 24-bit BMP image into the BGRA working format
+ * @param filename Path to the BMP file to load
+ * @return Pointer to loaded t_bmp32 structure, or NULL on failure
+ *
+ * 32-bit files in BGRA order are read one row per read straight into the
+ * pixel buffer; other channel masks are decoded per pixel. 24-bit files are
+ * expanded on load with an opaque alpha. Top-down files (negative height) are
+ * supported.
+ */
+t_bmp32 *bmp32_loadImage(const char *filename);
+
+/**
+ * @brief Save a BMP32 image as a BI_BITFIELDS BGRA file
+ * @param img Pointer to BMP32 structure to save
+ * @param filename Path where to save the BMP file
+ *
+ * Writes a BITMAPV4HEADER with explicit red, green, blue and alpha masks.
+ * Rows are written directly from the pixel buffer.
+ */
+void bmp32_saveImage(t_bmp32 *img, const char *filename);
+
+/**
+ * @brief Convert a 24-bit image to the 32-bit working format
+ * @param img Pointer to the 24-bit image
+ * @return Newly allocated t_bmp32 with opaque alpha, or NULL on failure
+ */
+t_bmp32 *bmp32_fromBmp24(t_bmp24 *img);
+
+/**
+ * @brief Convert a 32-bit image back to 24 bits
+ * @param img Pointer to the 32-bit image
+ * @return Newly allocated t_bmp24 (alpha is dropped), or NULL on failure
+ */
+t_bmp24 *bmp32_toBmp24(t_bmp32 *img);
+
+/**
+ * @brief Print image information to console
+ * @param img Pointer to BMP32 structure
+ */
+void bmp32_printInfo(t_bmp32 *img);
+
+/* ============================================================================
+ * IMAGE PROCESSING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Apply negative filter to the color channels
+ * @param img Pointer to image to modify
+ *
+ * Inverts red, green and blue with one XOR per pixel; alpha is unchanged.
+ */
+void bmp32_negative(t_bmp32 *img);
+
+/**
+ * @brief Convert image to grayscale
+ * @param img Pointer to image to modify
+ *
+ * Uses the same (R + G + B) / 3 average as bmp24_grayscale; alpha is unchanged.
+ */
+void bmp32_grayscale(t_bmp32 *img);
+
+/**
+ * @brief Adjust image brightness
+ * @param img Pointer to image to modify
+ * @param value Brightness adjustment value (-255 to +255)
+ *
+ * Adds value to each color channel with clamping, through a 256-entry table.
+ */
+void bmp32_brightness(t_bmp32 *img, int value);
+
+/**
+ * @brief Apply a convolution filter to the color channels
+ * @param img Pointer to image to modify
+ * @param kernel Convolution kernel
+ * @param kernelSize Size of the kernel (odd)
+ *
+ * Same arithmetic as bmp24_applyFilter (float accumulation, clamping to
+ * [0, 255]). Border pixels are left unchanged and alpha is carried through
+ * from the centre pixel. With SSE2 all four channels of a pixel are
+ * processed by one vector operation.
+ */
+void bmp32_applyFilter(t_bmp32 *img, float **kernel, int kernelSize);
+
+#endif //BMP32_H
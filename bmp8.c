@@ -11,11 +11,141 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <stdint.h>
 #include "bmp8.h"
+#include "bmp24.h"
+#include "scratch.h"
+#include "bufpool.h"
+#include "imageview.h"
+#include "resize.h"
+#include "rank.h"
+#include "morph.h"
+
+
+/**
+ * Size in bytes of one row of pixels on disk: BMP rows are padded to 4 bytes.
+ */
+static size_t bmp8_rowSize(unsigned int width)
+{
+    return ((size_t)width + 3) / 4 * 4;
+}
+
+
+/**
+ * Write the dimensions and sizes of img back into its raw 54-byte header,
+ * so that an image built in memory (allocation, region load) saves correctly.
+ * Sizes describe the padded rows written by bmp8_saveImage, whatever img->stride is.
+ */
+void bmp8_updateHeader(t_bmp8 *img)
+{
+    unsigned int offset = 54 + 1024;                      // Header + color table
+    uint64_t imageSize = (uint64_t)bmp8_rowSize(img->width) * img->height;
+    uint64_t fileSize = offset + imageSize;
+
+    // The 32-bit size fields cannot describe more than 4 GiB; 0 is allowed for
+    // uncompressed data and readers fall back on width and height
+    *(unsigned int *)&img->header[2] = fileSize > UINT32_MAX ? 0 : (unsigned int)fileSize;
+    *(unsigned int *)&img->header[10] = offset;                  // Pixel data offset
+    *(unsigned int *)&img->header[18] = img->width;
+    *(unsigned int *)&img->header[22] = img->height;
+    *(unsigned int *)&img->header[30] = COMPRESSION_RGB;         // Pixels are held uncompressed
+    *(unsigned int *)&img->header[34] = fileSize > UINT32_MAX ? 0 : (unsigned int)imageSize;
+}
+
+
+/**
+ * Read and validate the header of an 8-bit BMP, then its color table, which
+ * follows the info header (whose size varies between BMP versions).
+ * The header is normalised to a 40-byte info header and a 256-entry table,
+ * the layout bmp8_saveImage writes; bfOffBits, biCompression and biSizeImage
+ * are left untouched for the caller.
+ * Returns 1 on success, 0 (after printing the reason) otherwise.
+ */
+static int bmp8_readHeader(FILE *file, unsigned char *header, unsigned char *colorTable)
+{
+    if (fread(header, 1, 54, file) != 54 || header[0] != 'B' || header[1] != 'M') {
+        printf("Erreur : Le fichier n'est pas un fichier BMP\n");
+        return 0;
+    }
+
+    // Validate that this is an 8-bit grayscale image (biBitCount is 16 bits wide)
+    if (*(unsigned short *)&header[28] != 8) {
+        printf("Erreur : L'image n'est pas en niveaux de gris 8 bits\n");
+        return 0;
+    }
+    unsigned int compression = *(unsigned int *)&header[30];
+    if (compression != COMPRESSION_RGB && compression != COMPRESSION_RLE8) {
+        printf("Erreur : Compression %u non supportee\n", compression);
+        return 0;
+    }
+
+    // Color table (up to 256 colors * 4 bytes): Blue, Green, Red, Reserved.
+    // It starts right after the info header and ends at the pixel data.
+    unsigned int tableStart = 14 + *(unsigned int *)&header[14];
+    unsigned int offset = *(unsigned int *)&header[10];
+    size_t tableSize = offset > tableStart ? offset - tableStart : 0;
+    if (tableSize > 1024) tableSize = 1024;
+    memset(colorTable, 0, 1024);
+    file_rawRead(tableStart, colorTable, 1, tableSize, file);
+
+    *(unsigned int *)&header[14] = 40;                    // Info header size
+    *(unsigned int *)&header[46] = 256;                   // Colors in palette
+    return 1;
+}
+
+
+/**
+ * Expand BI_RLE8 data into img->data (bottom row first, like the file).
+ * Runs are written with memset and absolute blocks with memcpy; pixels skipped
+ * by end-of-line or delta codes stay 0. Returns 0 if the stream is malformed.
+ */
+static int bmp8_decodeRLE8(const unsigned char *src, size_t srcSize, t_bmp8 *img)
+{
+    size_t x = 0, y = 0, i = 0;
+    memset(img->data, 0, img->dataSize);
+
+    while (i + 1 < srcSize) {
+        unsigned char count = src[i++];
+        unsigned char value = src[i++];
+
+        if (count > 0) {
+            // Encoded mode: count copies of value
+            if (y >= img->height) return 0;
+            size_t room = x < img->width ? img->width - x : 0;   // Clip runs at the row end
+            size_t n = count < room ? count : room;
+            memset(img->data + y * img->stride + x, value, n);
+            x += count;
+        } else if (value == 0) {
+            x = 0;                          // End of line
+            y++;
+        } else if (value == 1) {
+            return 1;                       // End of bitmap
+        } else if (value == 2) {
+            if (i + 1 >= srcSize) return 0; // Delta: move right and up
+            x += src[i++];
+            y += src[i++];
+        } else {
+            // Absolute mode: value literal bytes, padded to a 16-bit boundary
+            if (i + value > srcSize || y >= img->height) return 0;
+            size_t room = x < img->width ? img->width - x : 0;
+            size_t n = value < room ? value : room;
+            memcpy(img->data + y * img->stride + x, src + i, n);
+            x += value;
+            i += value + (value & 1);
+        }
+    }
+    return 1;   // Missing end-of-bitmap marker: keep what was decoded
+}
 
 
 t_bmp8 *bmp8_loadImage(const char *filename) {
+    return bmp8_loadImageEx(filename, 0);
+}
+
+
+t_bmp8 *bmp8_loadImageEx(const char *filename, int keepPadding) {
     FILE *file = fopen(filename, "rb");
     if (!file) {
         printf("Erreur : Impossible d'ouvrir le fichier %s\n", filename);
@@ -30,40 +160,266 @@ t_bmp8 *bmp8_loadImage(const char *filename) {
         return NULL;
     }
 
-    // Read BMP header (54 bytes) and extract metadata
-    fread(img->header, 1, 54, file);
+    // Read BMP header (54 bytes) and color table, and extract metadata
+    if (!bmp8_readHeader(file, img->header, img->colorTable)) {
+        free(img);
+        fclose(file);
+        return NULL;
+    }
+    unsigned int offset = *(unsigned int *)&img->header[10];   // bfOffBits
     img->width = *(unsigned int *)&img->header[18];        // Width at offset 18
     img->height = *(unsigned int *)&img->header[22];       // Height at offset 22
-    img->colorDepth = *(unsigned int *)&img->header[28];   // Bits per pixel at offset 28
-    img->dataSize = img ->height * img->width;             // Total pixels
+    img->colorDepth = 8;
+    size_t rowSize = bmp8_rowSize(img->width);
+    size_t fileDataSize = rowSize * img->height;           // Padded pixel array, in 64 bits
+
+    if (*(unsigned int *)&img->header[30] == COMPRESSION_RLE8) {
+        // Read the whole compressed stream at once and expand it in memory
+        size_t srcSize = *(unsigned int *)&img->header[34];
+        if (srcSize == 0) {
+            uint64_t fileSize = file_size64(file);
+            srcSize = fileSize > offset ? (size_t)(fileSize - offset) : 0;
+        }
+        img->stride = keepPadding ? rowSize : img->width;
+        img->dataSize = img->stride * img->height;
+        unsigned char *src = (unsigned char *)malloc(srcSize);
+        img->data = (unsigned char *)pool_alloc(img->dataSize);
+        if (!src || !img->data) {
+            printf("Erreur : Allocation mémoire échouée pour les données de l'image\n");
+            free(src);
+            pool_free(img->data);
+            free(img);
+            fclose(file);
+            return NULL;
+        }
+        file_seek64(file, offset);
+        srcSize = fread(src, 1, srcSize, file);
+        fclose(file);
 
-    // Validate that this is an 8-bit grayscale image
-    if (img->colorDepth != 8) {
-        printf("Erreur : L'image n'est pas en niveaux de gris 8 bits\n");
+        if (!bmp8_decodeRLE8(src, srcSize, img)) {
+            printf("Erreur : Donnees RLE8 invalides\n");
+        }
+        free(src);
+        bmp8_updateHeader(img);
+        return img;
+    }
+
+    // Allocate memory for the padded pixel array and read it in a single operation
+    img->data = (unsigned char *)pool_alloc(fileDataSize);
+    if (!img->data) {
+        printf("Erreur : Allocation mémoire échouée pour les données de l'image\n");
         free(img);
         fclose(file);
         return NULL;
     }
+    file_seek64(file, offset);
+    if (fread(img->data, 1, fileDataSize, file) != fileDataSize) {
+        printf("Erreur : Donnees de l'image incompletes\n");
+    }
+    fclose(file);
+
+    if (keepPadding || rowSize == img->width) {
+        img->stride = rowSize;
+    } else {
+        // Strip the padding in place: every row moves down, never past a row not yet moved
+        for (size_t y = 1; y < img->height; y++)
+            memmove(img->data + y * img->width, img->data + y * rowSize, img->width);
+        img->stride = img->width;
+    }
+    img->dataSize = img->stride * img->height;
+    bmp8_updateHeader(img);
+    return img;
+}
+
 
-    // Read color table (256 colors * 4 bytes = 1024 bytes)
-    // Each entry contains Blue, Green, Red, Reserved bytes
-    fread(img->colorTable, 1, 1024, file);
+t_bmp8 *bmp8_allocate(unsigned int width, unsigned int height) {
+    t_bmp8 *img = (t_bmp8 *)malloc(sizeof(t_bmp8));
+    if (!img) {
+        printf("Erreur : Allocation mémoire échouée\n");
+        return NULL;
+    }
+
+    img->width = width;
+    img->height = height;
+    img->colorDepth = 8;
+    img->stride = width;
+    img->dataSize = (size_t)width * height;
+
+    // Build a standard BITMAPINFOHEADER for an uncompressed 8-bit image
+    memset(img->header, 0, sizeof(img->header));
+    img->header[0] = 'B';
+    img->header[1] = 'M';
+    *(unsigned int *)&img->header[14] = 40;               // Info header size
+    *(unsigned short *)&img->header[26] = 1;              // Color planes
+    *(unsigned short *)&img->header[28] = 8;              // Bits per pixel
+    *(unsigned int *)&img->header[46] = 256;              // Colors in palette
+    bmp8_updateHeader(img);
+
+    // Identity grayscale palette: entry i is (i, i, i, 0)
+    for (int i = 0; i < 256; i++) {
+        img->colorTable[i * 4] = i;
+        img->colorTable[i * 4 + 1] = i;
+        img->colorTable[i * 4 + 2] = i;
+        img->colorTable[i * 4 + 3] = 0;
+    }
 
-    // Allocate memory for pixel data and read it
-    img->data = (unsigned char *)malloc(img->dataSize);
+    img->data = (unsigned char *)pool_alloc(img->dataSize);
     if (!img->data) {
         printf("Erreur : Allocation mémoire échouée pour les données de l'image\n");
         free(img);
+        return NULL;
+    }
+    return img;
+}
+
+
+t_bmp8 *bmp8_loadImageROI(const char *filename, unsigned int x, unsigned int y,
+                          unsigned int width, unsigned int height) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        printf("Erreur : Impossible d'ouvrir le fichier %s\n", filename);
+        return NULL;
+    }
+
+    unsigned char header[54];
+    unsigned char colorTable[1024];
+    if (!bmp8_readHeader(file, header, colorTable)) {
+        fclose(file);
+        return NULL;
+    }
+    unsigned int srcWidth = *(unsigned int *)&header[18];
+    unsigned int srcHeight = *(unsigned int *)&header[22];
+    unsigned int offset = *(unsigned int *)&header[10];
+
+    // Rows can only be located directly in uncompressed files
+    if (*(unsigned int *)&header[30] != COMPRESSION_RGB) {
+        printf("Erreur : Image compressee, utiliser bmp8_loadImage\n");
         fclose(file);
         return NULL;
     }
-    fread(img->data, 1, img->dataSize, file);
+
+    // The region must be non-empty and lie entirely inside the image
+    if (width == 0 || height == 0 || x >= srcWidth || y >= srcHeight
+        || width > srcWidth - x || height > srcHeight - y) {
+        printf("Erreur : Region (%u, %u, %u x %u) hors de l'image\n", x, y, width, height);
+        fclose(file);
+        return NULL;
+    }
+
+    t_bmp8 *img = bmp8_allocate(width, height);
+    if (!img) {
+        fclose(file);
+        return NULL;
+    }
+    memcpy(img->header, header, 54);
+    memcpy(img->colorTable, colorTable, 1024);
+    bmp8_updateHeader(img);
+
+    // Rows are stored bottom-up and padded to 4 bytes; y is counted from the top.
+    // Data keeps the file order, so output row r is source row (srcHeight - y - height + r).
+    uint64_t rowSize = bmp8_rowSize(srcWidth);
+    uint64_t firstRow = srcHeight - y - height;
+    for (unsigned int r = 0; r < height; r++) {
+        uint64_t position = offset + (firstRow + r) * rowSize + x;
+        file_rawRead(position, img->data + (size_t)r * width, 1, width, file);   // Only the requested span
+    }
 
     fclose(file);
     return img;
 }
 
 
+t_bmp8 *bmp8_loadImageScaled(const char *filename, int factor, int average) {
+    if (factor != 1 && factor != 2 && factor != 4 && factor != 8) {
+        printf("Erreur : Facteur de reduction %d invalide (1, 2, 4 ou 8)\n", factor);
+        return NULL;
+    }
+
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        printf("Erreur : Impossible d'ouvrir le fichier %s\n", filename);
+        return NULL;
+    }
+
+    unsigned char header[54];
+    unsigned char colorTable[1024];
+    if (!bmp8_readHeader(file, header, colorTable)) {
+        fclose(file);
+        return NULL;
+    }
+    unsigned int srcWidth = *(unsigned int *)&header[18];
+    unsigned int srcHeight = *(unsigned int *)&header[22];
+    unsigned int offset = *(unsigned int *)&header[10];
+
+    // Rows can only be located directly in uncompressed files
+    if (*(unsigned int *)&header[30] != COMPRESSION_RGB) {
+        printf("Erreur : Image compressee, utiliser bmp8_loadImage\n");
+        fclose(file);
+        return NULL;
+    }
+
+    // Partial blocks on the right and bottom edges are dropped
+    unsigned int width = srcWidth / factor > 0 ? srcWidth / factor : 1;
+    unsigned int height = srcHeight / factor > 0 ? srcHeight / factor : 1;
+    size_t rowSize = bmp8_rowSize(srcWidth);
+    unsigned int rowsPerBlock = average ? factor : 1;
+
+    t_bmp8 *img = bmp8_allocate(width, height);
+    unsigned char *row = (unsigned char *)malloc(rowSize);
+    unsigned int *sums = (unsigned int *)calloc(width, sizeof(unsigned int));
+    if (!img || !row || !sums) {
+        printf("Erreur : Allocation mémoire échouée\n");
+        bmp8_freeImage(img);
+        free(row);
+        free(sums);
+        fclose(file);
+        return NULL;
+    }
+    memcpy(img->header, header, 54);
+    memcpy(img->colorTable, colorTable, 1024);
+    bmp8_updateHeader(img);
+
+    for (unsigned int oy = 0; oy < height; oy++) {
+        // Point sampling reads the centre row of the block, averaging reads all of them.
+        // Every other row of the block is never read from disk.
+        unsigned int top = oy * factor + (average ? 0 : factor / 2);
+        if (top >= srcHeight) top = srcHeight - 1;
+        memset(sums, 0, width * sizeof(unsigned int));
+
+        // A block is cut short only when the image is smaller than factor
+        unsigned int rows = 0;
+        for (unsigned int k = 0; k < rowsPerBlock && top + k < srcHeight; k++, rows++) {
+            // Rows are stored bottom-up, top + k is counted from the top
+            file_rawRead(offset + (srcHeight - 1 - (top + k)) * (uint64_t)rowSize, row, 1, srcWidth, file);
+
+            for (unsigned int ox = 0; ox < width; ox++) {
+                if (average) {
+                    for (int j = 0; j < factor && ox * factor + j < srcWidth; j++)
+                        sums[ox] += row[ox * factor + j];
+                } else {
+                    unsigned int sx = ox * factor + factor / 2;
+                    sums[ox] = row[sx < srcWidth ? sx : srcWidth - 1];
+                }
+            }
+        }
+
+        // Store in file order (bottom-up) like every other 8-bit image
+        unsigned char *dst = img->data + (size_t)(height - 1 - oy) * width;
+        for (unsigned int ox = 0; ox < width; ox++) {
+            unsigned int columns = srcWidth - ox * factor < (unsigned int)factor ? srcWidth - ox * factor
+                                                                                 : (unsigned int)factor;
+            unsigned int count = rows * columns;
+            dst[ox] = average ? (sums[ox] + count / 2) / count : sums[ox];
+        }
+    }
+
+    free(row);
+    free(sums);
+    fclose(file);
+    return img;
+}
+
+
 void bmp8_saveImage(const char *filename, t_bmp8 *img) {
     FILE *file = fopen(filename, "wb");
     if (!file) {
@@ -72,18 +428,134 @@ void bmp8_saveImage(const char *filename, t_bmp8 *img) {
     }
 
     // Write BMP header, color table, and pixel data in sequence
+    bmp8_updateHeader(img);
     fwrite(img->header, 1, 54, file);      // BMP header
     fwrite(img->colorTable, 1, 1024, file); // Color palette
-    fwrite(img->data, 1, img->dataSize, file); // Pixel data
+
+    // Pixel data: rows padded to 4 bytes, in one write when the buffer already has the padding
+    size_t rowSize = bmp8_rowSize(img->width);
+    if (img->stride == rowSize) {
+        fwrite(img->data, 1, rowSize * img->height, file);
+    } else {
+        const unsigned char padding[3] = {0, 0, 0};
+        for (size_t y = 0; y < img->height; y++) {
+            fwrite(img->data + y * img->stride, 1, img->width, file);
+            fwrite(padding, 1, rowSize - img->width, file);
+        }
+    }
 
     fclose(file);
     printf("Image enregistree sous : %s\n", filename);
 }
 
 
+/**
+ * Append the BI_RLE8 encoding of one row of pixels to out and return its
+ * length. Runs of 2 or more equal pixels use encoded mode; other stretches of
+ * 3 or more pixels use absolute mode. At most 2 * width + 2 bytes are written.
+ */
+static size_t bmp8_encodeRLE8Row(const unsigned char *row, size_t width, unsigned char *out)
+{
+    size_t i = 0, n = 0;
+    while (i < width) {
+        // Length of the run of equal pixels starting at i
+        size_t run = 1;
+        while (i + run < width && run < 255 && row[i + run] == row[i])
+            run++;
+
+        if (run >= 2) {
+            out[n++] = (unsigned char)run;
+            out[n++] = row[i];
+            i += run;
+            continue;
+        }
+
+        // Literal stretch: stop where a run of at least 2 equal pixels begins
+        size_t len = 1;
+        while (i + len < width && len < 255
+               && !(i + len + 1 < width && row[i + len] == row[i + len + 1]))
+            len++;
+
+        if (len >= 3) {
+            out[n++] = 0;
+            out[n++] = (unsigned char)len;
+            memcpy(out + n, row + i, len);
+            n += len;
+            if (len & 1) out[n++] = 0;   // Pad to a 16-bit boundary
+        } else {
+            // Absolute mode needs 3 pixels: 1 or 2 pixels are single-pixel runs
+            for (size_t k = 0; k < len; k++) {
+                out[n++] = 1;
+                out[n++] = row[i + k];
+            }
+        }
+        i += len;
+    }
+    return n;
+}
+
+
+void bmp8_saveImageRLE(const char *filename, t_bmp8 *img) {
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        printf("Erreur : Impossible d'ecrire dans le fichier %s\n", filename);
+        return;
+    }
+
+    unsigned char *out = (unsigned char *)malloc(2 * (size_t)img->width + 2);
+    if (!out) {
+        printf("Erreur : Allocation mémoire échouée\n");
+        fclose(file);
+        return;
+    }
+
+    // Header with BI_RLE8; the sizes are patched once the data is written
+    unsigned char header[54];
+    bmp8_updateHeader(img);
+    memcpy(header, img->header, 54);
+    *(unsigned int *)&header[30] = COMPRESSION_RLE8;
+    fwrite(header, 1, 54, file);
+    fwrite(img->colorTable, 1, 1024, file);
+
+    // Encode row by row, bottom row first as stored; each row ends with an end-of-line
+    // code, the last one with end-of-bitmap
+    uint64_t compressedSize = 0;
+    for (size_t y = 0; y < img->height; y++) {
+        size_t n = bmp8_encodeRLE8Row(img->data + y * img->stride, img->width, out);
+        out[n++] = 0;
+        out[n++] = (y + 1 == img->height) ? 1 : 0;
+        fwrite(out, 1, n, file);
+        compressedSize += n;
+    }
+
+    uint64_t fileSize = 54 + 1024 + compressedSize;
+    unsigned int size32 = fileSize > UINT32_MAX ? 0 : (unsigned int)fileSize;
+    unsigned int image32 = fileSize > UINT32_MAX ? 0 : (unsigned int)compressedSize;
+    file_rawWrite(2, &size32, sizeof(unsigned int), 1, file);
+    file_rawWrite(34, &image32, sizeof(unsigned int), 1, file);
+
+    free(out);
+    fclose(file);
+    printf("Image enregistree sous : %s (RLE8, %llu octets)\n", filename, (unsigned long long)fileSize);
+}
+
+
+t_bmp8 *bmp8_copy(t_bmp8 *img) {
+    t_bmp8 *copy = bmp8_allocate(img->width, img->height);
+    if (!copy) return NULL;
+
+    // Same header and palette; rows are packed whatever the source stride is
+    memcpy(copy->header, img->header, sizeof(copy->header));
+    memcpy(copy->colorTable, img->colorTable, sizeof(copy->colorTable));
+    for (size_t y = 0; y < img->height; y++)
+        memcpy(copy->data + y * copy->stride, img->data + y * img->stride, img->width);
+    return copy;
+}
+
+
 void bmp8_freeImage(t_bmp8 *img) {
     if (img) {
-        free(img->data);  // Free pixel data array
+        pool_free(img->data);  // Give pixel data back to the pool
         free(img);        // Free main structure
     }
 }
@@ -95,81 +567,156 @@ void bmp8_printInfo(t_bmp8 *img) {
         return;
     }
     printf("Image Info :\n");
-    printf("Width : %d pixels\n", img->width);
-    printf("Height : %d pixels\n", img->height);
-    printf("Color Depth : %d bits\n", img->colorDepth);
-    printf("Data Size : %d bytes\n", img->dataSize);
+    printf("Width : %u pixels\n", img->width);
+    printf("Height : %u pixels\n", img->height);
+    printf("Color Depth : %u bits\n", img->colorDepth);
+    printf("Data Size : %llu bytes\n", (unsigned long long)img->dataSize);
 }
 
 
 void bmp8_negative(t_bmp8 * img)
 {
-    for (int i = 0; i < img->width * img->height; i++)
-    {
-        img->data[i] = 255 - img->data[i];  // Invert pixel value
-    }
+    t_image_view view = view_fromBmp8(img);
+    view_negative(&view);  // Invert pixel values
 }
 
 
 void bmp8_brightness(t_bmp8 * img, int value)
 {
-    for (int i = 0; i < img->width * img->height; i++)
-    {
-        // Clamp values to valid range [0, 255]
-        if (img->data[i]+ value > 255)
-        {
-            img->data[i] = 255;  // Cap at maximum brightness
-        }
-        else if (img->data[i]+value < 0)
-        {
-            img->data[i] = 0;    // Cap at minimum brightness
-        }
-        else
-        {
-            img->data[i] = img->data[i] + value;  // Apply brightness change
-        }
-    }
+    t_image_view view = view_fromBmp8(img);
+    view_brightness(&view, value);  // Clamped to [0, 255]
 }
 
 
 void bmp8_threshold(t_bmp8 * img, int threshold)
 {
-    for (int i = 0; i < img->width * img->height; i++)
-    {
-        if (img->data[i] > threshold)
-        {
-            img->data[i] = 255;  // Set to white
-        }else
-        {
-            img->data[i] = 0;    // Set to black
-        }
-    }
+    t_image_view view = view_fromBmp8(img);
+    view_threshold(&view, threshold);
 }
 
 void bmp8_horizontalFlip(t_bmp8 *img)
 {
-    unsigned char * temp = malloc(img->width * img->height * sizeof(unsigned char));
-    for (int i = 0; i < img->width * img->height; i++)
-        temp[i] = img->data[i];
-    for (int i = 0; i < img->height ; i++)
-        for (int j = 0; j < img->width; j++)
-        {
-            img->data[i*img->width + j] = temp[(img->height - i - 1)*img->width + j];
-        }
-    free(temp);
+    t_image_view view = view_fromBmp8(img);
+    view_flipRows(&view);
 }
 
 void bmp8_verticalFlip(t_bmp8 *img)
 {
-    unsigned char * temp = malloc(img->width * img->height * sizeof(unsigned char));
-    for (int i = 0; i < img->width * img->height; i++)
-        temp[i] = img->data[i];
-    for (int i = 0; i < img->height ; i++)
-        for (int j = 0; j < img->width; j++)
-        {
-            img->data[i*img->width + j] = temp[i*img->width + (img->width - j - 1)];
-        }
-    free(temp);
+    t_image_view view = view_fromBmp8(img);
+    view_flipColumns(&view);
+}
+
+void bmp8_rotate(t_bmp8 *img, int quarterTurns)
+{
+    int turns = ((quarterTurns % 4) + 4) % 4;
+    t_image_view view = view_fromBmp8(img);
+    if (turns == 0)
+        return;
+    if (turns == 2) {
+        view_flipRows(&view);
+        view_flipColumns(&view);
+        return;
+    }
+
+    // A quarter turn is a transposition followed by a mirror
+    if (img->width == img->height) {
+        view_transposeSquare(&view);
+        if (turns == 1) view_flipColumns(&view);
+        else view_flipRows(&view);
+        return;
+    }
+
+    unsigned int width = img->height;
+    unsigned int height = img->width;
+    unsigned char *data = pool_alloc((size_t)width * height);
+    if (!data) {
+        printf("Erreur d'allocation memoire pour la rotation\n");
+        return;
+    }
+
+    // Packed rows, bottom row first like every t_bmp8
+    t_image_view rotated = view;
+    rotated.width = width;
+    rotated.height = height;
+    rotated.stride = -(ptrdiff_t)width;
+    rotated.data = data + (size_t)(height - 1) * width;
+    view_transform(&view, &rotated, 1, turns == 3, turns == 1);
+
+    pool_free(img->data);
+    img->data = data;
+    img->width = width;
+    img->height = height;
+    img->stride = width;
+    img->dataSize = (size_t)width * height;
+    bmp8_updateHeader(img);
+}
+
+// Copy packed rows, bottom row first, into the pixels of img. Operations that
+// keep the size write back this way rather than replacing img->data, which
+// may be a mapped file or a shared memory segment
+static void bmp8_copyRows(t_bmp8 *img, const unsigned char *data)
+{
+    for (size_t y = 0; y < img->height; y++)
+        memcpy(img->data + y * img->stride, data + y * img->width, img->width);
+}
+
+void bmp8_warp(t_bmp8 *img, const t_affine *transform, t_sampling sampling, unsigned char fill)
+{
+    unsigned char *data = pool_alloc((size_t)img->width * img->height);
+    if (!data) {
+        printf("Erreur d'allocation memoire pour la transformation\n");
+        return;
+    }
+
+    t_image_view view = view_fromBmp8(img);
+    t_image_view warped = view;
+    warped.stride = -(ptrdiff_t)img->width;
+    warped.data = data + (size_t)(img->height - 1) * img->width;
+    if (!view_warp(&view, &warped, transform, sampling, fill)) {
+        printf("Erreur : transformation non inversible\n");
+        pool_free(data);
+        return;
+    }
+
+    bmp8_copyRows(img, data);
+    pool_free(data);
+}
+
+void bmp8_rotateAngle(t_bmp8 *img, double degrees)
+{
+    t_affine rotation = affine_rotation(degrees, (img->width - 1) / 2.0, (img->height - 1) / 2.0);
+    bmp8_warp(img, &rotation, SAMPLE_BILINEAR, 255);
+}
+
+void bmp8_resize(t_bmp8 *img, unsigned int width, unsigned int height, t_sampling filter)
+{
+    if (width == 0 || height == 0)
+        return;
+    unsigned char *data = pool_alloc((size_t)width * height);
+    if (!data) {
+        printf("Erreur d'allocation memoire pour le redimensionnement\n");
+        return;
+    }
+
+    // Packed rows, bottom row first like every t_bmp8
+    t_image_view view = view_fromBmp8(img);
+    t_image_view resized = view;
+    resized.width = width;
+    resized.height = height;
+    resized.stride = -(ptrdiff_t)width;
+    resized.data = data + (size_t)(height - 1) * width;
+    if (!view_resize(&view, &resized, filter)) {
+        pool_free(data);
+        return;
+    }
+
+    pool_free(img->data);
+    img->data = data;
+    img->width = width;
+    img->height = height;
+    img->stride = width;
+    img->dataSize = (size_t)width * height;
+    bmp8_updateHeader(img);
 }
 
 
@@ -179,12 +726,12 @@ void bmp8_verticalFlip(t_bmp8 *img)
 int** list_to_matrix(t_bmp8 *img)
 {
     int **matrix = (int**)malloc(img->height * sizeof(int*));
-    for (int i = 0; i < img->height; i++)
+    for (size_t i = 0; i < img->height; i++)
     {
         matrix[i] = (int*)malloc(img->width * sizeof(int));
-        for (int j = 0; j < img->width; j++)
+        for (size_t j = 0; j < img->width; j++)
         {
-            matrix[i][j] = img->data[i*img->width + j];
+            matrix[i][j] = img->data[i*img->stride + j];
         }
     }
     return matrix;
@@ -193,12 +740,13 @@ int** list_to_matrix(t_bmp8 *img)
 
 unsigned char * matrix_to_list(int** matrix,int n)
 {
-   unsigned char * list =(unsigned char*)malloc(n*n * sizeof(int));
-    for (int i = 0; i < n; i++)
+    size_t size = (size_t)n;
+    unsigned char * list =(unsigned char*)malloc(size * size * sizeof(int));
+    for (size_t i = 0; i < size; i++)
     {
-        for (int j = 0; j < n; j++)
+        for (size_t j = 0; j < size; j++)
         {
-            list[i * n + j] = matrix[i][j];  // Flatten 2D to 1D
+            list[i * size + j] = matrix[i][j];  // Flatten 2D to 1D
         }
     }
     return list;
@@ -206,67 +754,111 @@ unsigned char * matrix_to_list(int** matrix,int n)
 
 
 void bmp8_applyFilter(t_bmp8 *img, float **kernel, int kernelSize) {
-    int width = img->width;
-    int height = img->height;
-    int n = kernelSize / 2;  // Half kernel size for centering
+    // Rows in memory order, bottom row first: kernel[0] has always been
+    // applied to the row below in 8-bit images
+    t_image_view view = view_fromBmp8(img);
+    view.data = img->data;
+    view.stride = (ptrdiff_t)img->stride;
 
-    // Create temporary buffer to avoid modifying source during processing
-    unsigned char *temp = malloc(img->dataSize * sizeof(unsigned char));
-    if (!temp) {
+    if (!view_applyFilter(&view, kernel, kernelSize)) {
         printf("Error allocating memory for the filter.\n");
-        return;
     }
+}
 
-    // Copy original image data to temporary buffer
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        temp[i] = img->data[i];
+void bmp8_applyFilters(t_bmp8 *img, float ***kernels, const int *kernelSizes, int count) {
+    // Memory order, as bmp8_applyFilter
+    t_image_view view = view_fromBmp8(img);
+    view.data = img->data;
+    view.stride = (ptrdiff_t)img->stride;
+
+    if (!view_applyFilters(&view, kernels, kernelSizes, count)) {
+        printf("Error allocating memory for the filter.\n");
     }
+}
 
-    // Apply convolution to all pixels except border pixels
-    for (int y = n; y < height - n; y++) {
-        for (int x = n; x < width - n; x++) {
-            float sum = 0.0f;
+void bmp8_rankFilter(t_bmp8 *img, int radius, int percentile) {
+    size_t size = (size_t)img->width * img->height;
+    unsigned char *data = pool_alloc(size);
+    if (!data) {
+        printf("Erreur d'allocation memoire pour le filtre\n");
+        return;
+    }
 
-            // Perform convolution operation
-            for (int ky = -n; ky <= n; ky++) {
-                for (int kx = -n; kx <= n; kx++) {
-                    int imgX = x + kx;  // Source pixel X coordinate
-                    int imgY = y + ky;  // Source pixel Y coordinate
-                    unsigned char pixel = temp[imgY * width + imgX];
-                    // Multiply pixel value by corresponding kernel value
-                    sum += pixel * kernel[ky + n][kx + n];
-                }
-            }
+    // Packed rows, bottom row first like every t_bmp8
+    t_image_view view = view_fromBmp8(img);
+    t_image_view filtered = view;
+    filtered.stride = -(ptrdiff_t)img->width;
+    filtered.data = data + (size_t)(img->height - 1) * img->width;
+    if (view_rankFilter(&view, &filtered, radius, percentile))
+        bmp8_copyRows(img, data);
+    pool_free(data);
+}
 
-            // Clamp result to valid pixel range [0, 255]
-            if (sum < 0) sum = 0;
-            if (sum > 255) sum = 255;
+void bmp8_median(t_bmp8 *img, int radius) {
+    bmp8_rankFilter(img, radius, RANK_MEDIAN);
+}
 
-            // Set the new pixel value
-            img->data[y * width + x] = (unsigned char)(sum);
-        }
+
+static void bmp8_morphology(t_bmp8 *img, t_morph_op op, unsigned int width, unsigned int height) {
+    size_t size = (size_t)img->width * img->height;
+    unsigned char *data = pool_alloc(size);
+    if (!data) {
+        printf("Erreur d'allocation memoire pour l'operation morphologique\n");
+        return;
     }
 
-    free(temp); // Free temporary buffer
+    // Packed rows, bottom row first like every t_bmp8
+    t_image_view view = view_fromBmp8(img);
+    t_image_view result = view;
+    result.stride = -(ptrdiff_t)img->width;
+    result.data = data + (size_t)(img->height - 1) * img->width;
+    if (view_morphology(&view, &result, op, width, height))
+        bmp8_copyRows(img, data);
+    pool_free(data);
+}
+
+void bmp8_erode(t_bmp8 *img, unsigned int width, unsigned int height) {
+    bmp8_morphology(img, MORPH_ERODE, width, height);
+}
+
+void bmp8_dilate(t_bmp8 *img, unsigned int width, unsigned int height) {
+    bmp8_morphology(img, MORPH_DILATE, width, height);
+}
+
+void bmp8_opening(t_bmp8 *img, unsigned int width, unsigned int height) {
+    bmp8_morphology(img, MORPH_OPEN, width, height);
+}
+
+void bmp8_closing(t_bmp8 *img, unsigned int width, unsigned int height) {
+    bmp8_morphology(img, MORPH_CLOSE, width, height);
 }
 
+void bmp8_topHat(t_bmp8 *img, unsigned int width, unsigned int height) {
+    bmp8_morphology(img, MORPH_TOPHAT, width, height);
+}
 
-unsigned int * bmp8_computeHistogram(t_bmp8 * img)
+void bmp8_blackHat(t_bmp8 *img, unsigned int width, unsigned int height) {
+    bmp8_morphology(img, MORPH_BLACKHAT, width, height);
+}
+
+
+size_t * bmp8_computeHistogram(t_bmp8 * img)
 {
     // Initialize histogram array with zeros (256 possible intensity values)
-    unsigned int * hist = (unsigned int *)calloc(256,sizeof(unsigned int));
+    size_t * hist = (size_t *)calloc(256,sizeof(size_t));
 
-    // Count frequency of each pixel intensity
-    for (int i = 0; i < img->width * img->height; i++)
-        hist[img->data[i]] ++;
+    // Count frequency of each pixel intensity (padding bytes are not pixels)
+    for (size_t y = 0; y < img->height; y++)
+        for (size_t x = 0; x < img->width; x++)
+            hist[img->data[y * img->stride + x]] ++;
 
     return hist;
 }
 
 
-unsigned int  min_arr(int* arr,int n,int N)
+size_t  min_arr(size_t* arr,int n,size_t N)
 {
-    unsigned int min = N;
+    size_t min = N;
     for (int i = 1; i < n; i++)  // Start from index 1, skip first element
     {
         if (arr[i] < min && arr[i] != 0)
@@ -276,11 +868,13 @@ unsigned int  min_arr(int* arr,int n,int N)
 }
 
 
-unsigned int * bmp8_computeCDF(unsigned int * hist)
+unsigned int * bmp8_computeCDF(size_t * hist)
 {
-    unsigned int * cdf = malloc(256*sizeof(unsigned int));
-    unsigned int sum = 0;
-    int N;
+    size_t mark = scratch_mark();
+    size_t * cdf = scratch_alloc(256*sizeof(size_t));
+    size_t sum = 0;
+    if (!cdf) return NULL;
+    size_t N;
 
     // Compute cumulative distribution function
     for (int i = 0; i < 256; i++)
@@ -290,17 +884,17 @@ unsigned int * bmp8_computeCDF(unsigned int * hist)
     }
 
     N = cdf[255];  // Total number of pixels
-    unsigned int cdf_min = min_arr(cdf,256,N);  // Minimum non-zero CDF value
+    size_t cdf_min = min_arr(cdf,256,N);  // Minimum non-zero CDF value
 
     // Create equalization mapping using histogram equalization formula
     unsigned int * hist_eq = malloc(256 * sizeof(unsigned int));
     for (int i = 0; i < 256; i++)
     {
         // Apply equalization: scale CDF to [0, 255] range
-        hist_eq[i] = round((float)(cdf[i] - cdf_min) / (N - cdf_min) * 255);
+        hist_eq[i] = round((double)(cdf[i] - cdf_min) / (N - cdf_min) * 255);
     }
 
-    free(hist);  // Free original histogram
+    scratch_release(mark);
     return hist_eq;  // Return equalization mapping
 }
 
@@ -308,12 +902,21 @@ unsigned int * bmp8_computeCDF(unsigned int * hist)
 void bmp8_equalize(t_bmp8 * img)
 {
     // Compute histogram and equalization mapping
-    unsigned int * hist = bmp8_computeHistogram(img);
+    size_t * hist = bmp8_computeHistogram(img);
     unsigned int * hist_eq = bmp8_computeCDF(hist);
+    if (!hist_eq) {
+        printf("Erreur d'allocation memoire pour l'egalisation\n");
+        free(hist);
+        return;
+    }
 
     // Apply equalization mapping to all pixels
-    for (int i = 0; i < img->dataSize; i++)
-        img->data[i] = hist_eq[img->data[i]];  // Map old intensity to new intensity
+    for (size_t y = 0; y < img->height; y++)
+    {
+        unsigned char *row = img->data + y * img->stride;
+        for (size_t x = 0; x < img->width; x++)
+            row[x] = hist_eq[row[x]];  // Map old intensity to new intensity
+    }
 
     free(hist);
     free(hist_eq);
@@ -16,6 +16,9 @@
 #ifndef BMP8_H
 #define BMP8_H
 
+#include <stddef.h>
+#include "affine.h"
+
 /**
  * @struct t_bmp8
  * @brief Structure representing an 8-bit grayscale BMP image
@@ -23,8 +26,12 @@
  * This structure contains all necessary data for a grayscale BMP image:
  * - File header information (54 bytes)
  * - Color table for grayscale values (1024 bytes)
- * - Actual pixel data
+ * - Actual pixel data, bottom row first as in the file
  * - Image dimensions and metadata
+ *
+ * Row y starts at data + y * stride. The stride is either the width (padding
+ * stripped) or the padded BMP row size (padding kept); all functions honour it.
+ * The pixel data comes from the buffer pool (see bufpool.h).
  */
 typedef struct {
     unsigned char header[54];      /**< BMP file header (54 bytes) */
@@ -33,7 +40,8 @@ typedef struct {
     unsigned int width;            /**< Image width in pixels */
     unsigned int height;           /**< Image height in pixels */
     unsigned int colorDepth;       /**< Color depth (should be 8 for grayscale) */
-    unsigned int dataSize;         /**< Size of pixel data in bytes */
+    size_t dataSize;               /**< Size of pixel data in bytes (64-bit on 64-bit targets) */
+    size_t stride;                 /**< Bytes between the starts of two consecutive rows */
 } t_bmp8;
 
 /* ============================================================================
@@ -46,24 +54,107 @@ typedef struct {
  * @return Pointer to allocated t_bmp8 structure, or NULL on failure
  *
  * Reads a BMP file and loads it into memory. Validates that the file is
- * a valid 8-bit grayscale BMP before loading.
+ * a valid 8-bit grayscale BMP before loading. The pixel array is located with
+ * the header's data offset and read in one operation; row padding is then
+ * stripped so that stride == width. BI_RLE8 files are read in one operation
+ * too and expanded in memory.
  */
 t_bmp8 *bmp8_loadImage(const char *filename);
 
+/**
+ * @brief Load an 8-bit grayscale BMP image, optionally keeping row padding
+ * @param filename Path to the BMP file to load
+ * @param keepPadding Non-zero to keep the padded rows (stride = padded row size)
+ * @return Pointer to allocated t_bmp8 structure, or NULL on failure
+ *
+ * Same as bmp8_loadImage. Keeping the padding skips the compaction pass and
+ * lets bmp8_saveImage write the pixel array back in a single operation.
+ */
+t_bmp8 *bmp8_loadImageEx(const char *filename, int keepPadding);
+
+/**
+ * @brief Allocate a blank 8-bit grayscale image
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @return Pointer to allocated t_bmp8 structure, or NULL on failure
+ *
+ * Builds a valid header and an identity grayscale color table, and allocates
+ * (uninitialized) pixel data, so the image can be filled and saved directly.
+ */
+t_bmp8 *bmp8_allocate(unsigned int width, unsigned int height);
+
+/**
+ * @brief Load only a rectangular region of an 8-bit grayscale BMP image
+ * @param filename Path to the BMP file to load
+ * @param x Left column of the region
+ * @param y Top row of the region (counted from the top of the image)
+ * @param width Region width in pixels
+ * @param height Region height in pixels
+ * @return Pointer to a t_bmp8 holding just the region, or NULL on failure
+ *
+ * Seeks to each required scanline using the pixel data offset and the padded
+ * row size, and reads only the requested span of each row. The rest of the
+ * file is never read.
+ */
+t_bmp8 *bmp8_loadImageROI(const char *filename, unsigned int x, unsigned int y,
+                          unsigned int width, unsigned int height);
+
+/**
+ * @brief Load a reduced-size preview of an 8-bit grayscale BMP image
+ * @param filename Path to the BMP file to load
+ * @param factor Reduction factor: 1, 2, 4 or 8
+ * @param average Non-zero to average each factor x factor block, 0 to point-sample it
+ * @return Pointer to a t_bmp8 of size (width / factor) x (height / factor), or NULL on failure
+ *
+ * Decodes while reading scanlines: point sampling reads a single row per block
+ * and averaging reads the rows of each block once. Skipped rows are never read
+ * from disk, so a 1/8 thumbnail costs a fraction of the I/O of a full load.
+ */
+t_bmp8 *bmp8_loadImageScaled(const char *filename, int factor, int average);
+
 /**
  * @brief Save an 8-bit grayscale BMP image to file
  * @param filename Path where to save the BMP file
  * @param img Pointer to the image structure to save
  *
  * Writes the complete BMP image (header, color table, and pixel data) to file.
+ * Rows are padded to a multiple of 4 bytes as the BMP format requires.
  */
 void bmp8_saveImage(const char *filename, t_bmp8 *img);
 
+/**
+ * @brief Save an 8-bit grayscale BMP image with BI_RLE8 compression
+ * @param filename Path where to save the BMP file
+ * @param img Pointer to the image structure to save
+ *
+ * Encodes each row with runs of equal pixels and absolute blocks for the rest.
+ * Large uniform areas (document backgrounds) shrink to 2 bytes per 255 pixels.
+ * The file can be read back with bmp8_loadImage.
+ */
+void bmp8_saveImageRLE(const char *filename, t_bmp8 *img);
+
+/**
+ * @brief Refresh the size fields of the header from the image dimensions
+ * @param img Pointer to the image, after its width or height changed
+ *
+ * Sizes describe the padded rows written by bmp8_saveImage, whatever
+ * img->stride is. Other header fields (resolution...) are kept.
+ */
+void bmp8_updateHeader(t_bmp8 *img);
+
+/**
+ * @brief Duplicate an 8-bit image
+ * @param img Pointer to the image to copy
+ * @return Newly allocated copy with packed rows, or NULL on failure
+ */
+t_bmp8 *bmp8_copy(t_bmp8 *img);
+
 /**
  * @brief Free memory allocated for an 8-bit BMP image
  * @param img Pointer to the image structure to free
  *
- * Properly deallocates all memory associated with the image structure.
+ * Properly deallocates all memory associated with the image structure. The
+ * pixel data goes back to the buffer pool for the next image.
  */
 void bmp8_freeImage(t_bmp8 *img);
 
@@ -111,7 +202,8 @@ void bmp8_threshold(t_bmp8 *img, int threshold);
  * @brief Flip the image horizontally
  * @param img Pointer to the image to modify
  *
- * Convert an image into its horizontal mirrored versions
+ * Convert an image into its horizontal mirrored versions. Rows are swapped
+ * in place, without a copy of the image.
  */
 void bmp8_horizontalFlip(t_bmp8 *img);
 
@@ -119,10 +211,60 @@ void bmp8_horizontalFlip(t_bmp8 *img);
  * @brief Flip the image vertically
  * @param img Pointer to the image to modify
  *
- * Convert an image into its vertical mirrored versions
+ * Convert an image into its vertical mirrored versions. Each row is
+ * reversed in place.
  */
 void bmp8_verticalFlip(t_bmp8 *img);
 
+/**
+ * @brief Rotate the image by a multiple of 90 degrees
+ * @param img Pointer to the image to modify
+ * @param quarterTurns Number of quarter turns clockwise (negative for counterclockwise)
+ *
+ * Half turns and square images are rotated in place. Other quarter turns
+ * change the shape of the image: the pixels are written in one pass into
+ * a buffer from the pool, which replaces the old one, and the width,
+ * height and header are updated.
+ */
+void bmp8_rotate(t_bmp8 *img, int quarterTurns);
+
+/**
+ * @brief Apply an affine transformation (rotation, scale, shear) to the image
+ * @param img Pointer to the image to modify
+ * @param transform Where each pixel goes, in top-down pixel coordinates
+ * @param sampling SAMPLE_NEAREST or SAMPLE_BILINEAR
+ * @param fill Value of the areas that come from outside the image
+ *
+ * The image keeps its size: what is moved out is cut, what is uncovered
+ * takes the fill value. The result is drawn tile by tile into a buffer from
+ * the pool, which replaces the old one (see view_warp).
+ */
+void bmp8_warp(t_bmp8 *img, const t_affine *transform, t_sampling sampling, unsigned char fill);
+
+/**
+ * @brief Rotate the image by any angle around its centre
+ * @param img Pointer to the image to modify
+ * @param degrees Angle, clockwise (negative for counterclockwise)
+ *
+ * Meant for small corrections such as deskewing a scan: bilinear sampling,
+ * same size, corners filled with white.
+ */
+void bmp8_rotateAngle(t_bmp8 *img, double degrees);
+
+/**
+ * @brief Resize the image
+ * @param img Pointer to the image to modify
+ * @param width New width in pixels
+ * @param height New height in pixels
+ * @param filter SAMPLE_AREA for thumbnails, SAMPLE_BILINEAR, SAMPLE_BICUBIC,
+ *               SAMPLE_LANCZOS3 (sharpest) or SAMPLE_NEAREST
+ *
+ * The pixels are resized into a buffer from the pool, which replaces the
+ * old one, and the header is updated (see view_resize). Weight tables are
+ * cached, so resizing a batch of images of the same size computes them once.
+ */
+void bmp8_resize(t_bmp8 *img, unsigned int width, unsigned int height, t_sampling filter);
+
 
 /* ============================================================================
  * CONVOLUTION AND FILTER FUNCTIONS
@@ -159,6 +301,112 @@ unsigned char *matrix_to_list(int **matrix, int n);
  */
 void bmp8_applyFilter(t_bmp8 *img, float **kernel, int kernelSize);
 
+/**
+ * @brief Apply several convolution filters in a row
+ * @param img Pointer to the image to modify
+ * @param kernels Kernels, first applied first
+ * @param kernelSizes Size of each kernel
+ * @param count Number of kernels
+ *
+ * Same result as calling bmp8_applyFilter for each kernel, computed tile by
+ * tile so that the image is read and written only once.
+ */
+void bmp8_applyFilters(t_bmp8 *img, float ***kernels, const int *kernelSizes, int count);
+
+/**
+ * @brief Apply a rank filter to the image
+ * @param img Pointer to the image to modify
+ * @param radius Half side of the square around each pixel, 1 to RANK_MAX_RADIUS
+ * @param percentile 0 for the minimum, RANK_MEDIAN for the median, 100 for
+ *                   the maximum, or any rank in between
+ *
+ * Each pixel takes the value of the given rank among its neighbours (see
+ * view_rankFilter); the time does not depend on the radius. Edge pixels
+ * are repeated.
+ */
+void bmp8_rankFilter(t_bmp8 *img, int radius, int percentile);
+
+/**
+ * @brief Apply a median filter to the image
+ * @param img Pointer to the image to modify
+ * @param radius Half side of the square around each pixel, 1 to RANK_MAX_RADIUS
+ *
+ * Removes salt and pepper noise while keeping edges sharp, unlike blurs.
+ */
+void bmp8_median(t_bmp8 *img, int radius);
+
+/* ============================================================================
+ * MORPHOLOGY FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Erode the image with a rectangle
+ * @param img Pointer to the image to modify
+ * @param width Width of the rectangle in pixels
+ * @param height Height of the rectangle in pixels
+ *
+ * Each pixel takes the darkest value under the rectangle centred on it, so
+ * black text gets bolder. The time does not depend on the rectangle size
+ * (see view_morphology).
+ */
+void bmp8_erode(t_bmp8 *img, unsigned int width, unsigned int height);
+
+/**
+ * @brief Dilate the image with a rectangle
+ * @param img Pointer to the image to modify
+ * @param width Width of the rectangle in pixels
+ * @param height Height of the rectangle in pixels
+ *
+ * Each pixel takes the brightest value under the rectangle, so black text
+ * gets thinner and small dark specks disappear.
+ */
+void bmp8_dilate(t_bmp8 *img, unsigned int width, unsigned int height);
+
+/**
+ * @brief Opening of the image: erosion then dilation
+ * @param img Pointer to the image to modify
+ * @param width Width of the rectangle in pixels
+ * @param height Height of the rectangle in pixels
+ *
+ * Removes the bright details the rectangle does not fit in and keeps the
+ * rest of the image in place.
+ */
+void bmp8_opening(t_bmp8 *img, unsigned int width, unsigned int height);
+
+/**
+ * @brief Closing of the image: dilation then erosion
+ * @param img Pointer to the image to modify
+ * @param width Width of the rectangle in pixels
+ * @param height Height of the rectangle in pixels
+ *
+ * Removes the dark details the rectangle does not fit in: specks on a
+ * white page, or the gaps between letters with a wide flat rectangle.
+ */
+void bmp8_closing(t_bmp8 *img, unsigned int width, unsigned int height);
+
+/**
+ * @brief White top-hat: the image minus its opening
+ * @param img Pointer to the image to modify
+ * @param width Width of the rectangle in pixels
+ * @param height Height of the rectangle in pixels
+ *
+ * Keeps only the bright details smaller than the rectangle, on black.
+ * With a rectangle larger than the text, it also flattens an uneven
+ * background before bmp8_threshold.
+ */
+void bmp8_topHat(t_bmp8 *img, unsigned int width, unsigned int height);
+
+/**
+ * @brief Black top-hat: the closing of the image minus the image
+ * @param img Pointer to the image to modify
+ * @param width Width of the rectangle in pixels
+ * @param height Height of the rectangle in pixels
+ *
+ * Keeps only the dark details smaller than the rectangle, bright on black:
+ * dark text on a page of varying brightness comes out evenly.
+ */
+void bmp8_blackHat(t_bmp8 *img, unsigned int width, unsigned int height);
+
 /* ============================================================================
  * HISTOGRAM EQUALIZATION FUNCTIONS
  * ============================================================================ */
@@ -166,15 +414,16 @@ void bmp8_applyFilter(t_bmp8 *img, float **kernel, int kernelSize);
 /**
  * @brief Compute histogram of pixel intensities
  * @param img Pointer to the image
- * @return Array of 256 integers representing frequency of each intensity
+ * @return Array of 256 counts representing frequency of each intensity
  *
  * Calculates the frequency distribution of pixel values (0-255) in the image.
+ * Counts are size_t so that images above 4 Gpixels do not overflow.
  */
-unsigned int *bmp8_computeHistogram(t_bmp8 *img);
+size_t *bmp8_computeHistogram(t_bmp8 *img);
 
 /**
  * @brief Find minimum non-zero value in array
- * @param arr Integer array to search
+ * @param arr Count array to search
  * @param n Size of the array
  * @param N Maximum possible value (used for initialization)
  * @return Minimum non-zero value found
@@ -182,7 +431,7 @@ unsigned int *bmp8_computeHistogram(t_bmp8 *img);
  * Helper function for histogram equalization to find the minimum non-zero
  * value in the cumulative distribution function.
  */
-unsigned int min_arr(int *arr, int n, int N);
+size_t min_arr(size_t *arr, int n, size_t N);
 
 /**
  * @brief Compute cumulative distribution function and equalization mapping
@@ -192,7 +441,7 @@ unsigned int min_arr(int *arr, int n, int N);
  * Computes the CDF from the histogram and creates a mapping for histogram
  * equalization to improve image contrast.
  */
-unsigned int *bmp8_computeCDF(unsigned int *hist);
+unsigned int *bmp8_computeCDF(size_t *hist);
 
 /**
  * @brief Apply histogram equalization to improve image contrast
@@ -0,0 +1,286 @@
+/**
+ * @file bmpmap.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief BMP output files written in place through a memory mapping
+ *
+ * The file is created at its final size before anything is written, so
+ * every pixel can be stored at its final position as soon as it is known.
+ *
+ */
+
+#include "bmpmap.h"
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// ========================================
+// PLATFORM FUNCTIONS
+// ========================================
+
+
+/**
+ * Create the file with the given size and map it read-write into map->base.
+ * Returns 1 on success, 0 otherwise.
+ */
+static int bmpmap_open(t_bmp_map *map, const char *filename)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return 0;
+
+    // Creating a mapping larger than the file extends the file to that size
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+                                        (DWORD)(map->size >> 32), (DWORD)map->size, NULL);
+    void *base = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)map->size) : NULL;
+    if (!base) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        DeleteFileA(filename);
+        return 0;
+    }
+    map->file = file;
+    map->mapping = mapping;
+    map->base = base;
+    return 1;
+#else
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return 0;
+
+    // Reserve the blocks now: running out of space while storing into the
+    // mapping would kill the process with SIGBUS instead of failing here
+    int error = posix_fallocate(fd, 0, (off_t)map->size);
+    if (error == EINVAL || error == EOPNOTSUPP)
+        error = ftruncate(fd, (off_t)map->size) == 0 ? 0 : errno;
+
+    void *base = error ? MAP_FAILED
+                       : mmap(NULL, (size_t)map->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        unlink(filename);
+        return 0;
+    }
+    map->fd = fd;
+    map->base = base;
+    return 1;
+#endif
+}
+
+
+int bmpmap_close(t_bmp_map *map)
+{
+    int ok;
+#ifdef _WIN32
+    ok = UnmapViewOfFile(map->base) != 0;
+    ok = CloseHandle(map->mapping) && ok;
+    ok = CloseHandle(map->file) && ok;
+#else
+    ok = munmap(map->base, (size_t)map->size) == 0;
+    ok = close(map->fd) == 0 && ok;
+#endif
+    free(map);
+    return ok;
+}
+
+// ========================================
+// MAPPING FUNCTIONS
+// ========================================
+
+
+t_bmp_map * bmpmap_create(const char *filename, int width, int height, int bits)
+{
+    if ((bits != 8 && bits != 24) || width <= 0 || height <= 0) {
+        printf("Error : Cannot map a %dx%d image with %d bits per pixel\n", width, height, bits);
+        return NULL;
+    }
+
+    t_bmp_map *map = calloc(1, sizeof(t_bmp_map));
+    if (!map) {
+        printf("Error allocating memory for the mapping\n");
+        return NULL;
+    }
+    uint32_t offset = HEADER_SIZE + INFO_SIZE + (bits == 8 ? 1024 : 0);
+    map->width = width;
+    map->height = height;
+    map->bits = bits;
+    map->rowSize = ((size_t)width * (bits / 8) + 3) / 4 * 4;
+    map->size = offset + (uint64_t)map->rowSize * height;
+
+    if ((uint64_t)(size_t)map->size != map->size || !bmpmap_open(map, filename)) {
+        printf("Error: Opening of the file impossible %s\n", filename);
+        free(map);
+        return NULL;
+    }
+    map->pixels = map->base + offset;
+
+    // File and info headers, in the layout bmp8_saveImage and bmp24_saveImage write
+    uint16_t type = BMP_TYPE;
+    uint64_t imageSize = map->size - offset;
+    uint32_t fileSize = map->size > UINT32_MAX ? 0 : (uint32_t)map->size;
+    t_bmp_info info = {0};
+    info.size = INFO_SIZE;
+    info.width = width;
+    info.height = height;
+    info.planes = 1;
+    info.bits = bits;
+    info.compression = COMPRESSION_RGB;
+    info.imagesize = map->size > UINT32_MAX ? 0 : (uint32_t)imageSize;
+    info.xresolution = 2835;   // 72 DPI
+    info.yresolution = 2835;
+    info.ncolors = bits == 8 ? 256 : 0;
+    memcpy(map->base + BITMAP_MAGIC, &type, sizeof(type));
+    memcpy(map->base + BITMAP_SIZE, &fileSize, sizeof(fileSize));
+    memcpy(map->base + BITMAP_OFFSET, &offset, sizeof(offset));
+    memcpy(map->base + HEADER_SIZE, &info, sizeof(info));
+
+    // Identity grayscale color table: entry i is (i, i, i, 0)
+    if (bits == 8) {
+        uint8_t *colorTable = map->base + HEADER_SIZE + INFO_SIZE;
+        for (int i = 0; i < 256; i++) {
+            colorTable[i * 4] = i;
+            colorTable[i * 4 + 1] = i;
+            colorTable[i * 4 + 2] = i;
+        }
+    }
+    return map;
+}
+
+
+uint8_t * bmpmap_row(const t_bmp_map *map, int y)
+{
+    // Rows are stored bottom row first
+    return map->pixels + (size_t)(map->height - 1 - y) * map->rowSize;
+}
+
+
+t_bmp8 bmpmap_view8(t_bmp_map *map)
+{
+    t_bmp8 view;
+    memcpy(view.header, map->base, 54);
+    memcpy(view.colorTable, map->base + HEADER_SIZE + INFO_SIZE, 1024);
+    view.data = map->pixels;
+    view.width = map->width;
+    view.height = map->height;
+    view.colorDepth = 8;
+    view.stride = map->rowSize;
+    view.dataSize = map->rowSize * map->height;
+    return view;
+}
+
+// ========================================
+// IMAGE FUNCTIONS
+// ========================================
+
+
+void bmp8_saveImageMapped(const char *filename, t_bmp8 *img)
+{
+    t_bmp_map *map = bmpmap_create(filename, img->width, img->height, 8);
+    if (!map) return;
+
+    memcpy(map->base + HEADER_SIZE + INFO_SIZE, img->colorTable, 1024);
+    for (size_t y = 0; y < img->height; y++)
+        memcpy(map->pixels + y * map->rowSize, img->data + y * img->stride, img->width);
+
+    if (bmpmap_close(map))
+        printf("Image enregistree sous : %s\n", filename);
+    else
+        printf("Erreur : Impossible d'ecrire dans le fichier %s\n", filename);
+}
+
+
+void bmp24_saveImageMapped(t_bmp24 *img, const char *filename)
+{
+    t_bmp_map *map = bmpmap_create(filename, img->width, img->height, 24);
+    if (!map) return;
+
+    for (int y = 0; y < img->height; y++) {
+        uint8_t *row = bmpmap_row(map, y);
+        for (int x = 0; x < img->width; x++) {
+            row[x * 3]     = img->data[y][x].blue;
+            row[x * 3 + 1] = img->data[y][x].green;
+            row[x * 3 + 2] = img->data[y][x].red;
+        }
+    }
+
+    if (bmpmap_close(map))
+        printf("Image successfully saved\n");
+    else
+        printf("Error: Writing of the file %s failed\n", filename);
+}
+
+
+void bmp8_applyFilterMapped(const char *filename, t_bmp8 *img, float **kernel, int kernelSize)
+{
+    t_bmp_map *map = bmpmap_create(filename, img->width, img->height, 8);
+    if (!map) return;
+    memcpy(map->base + HEADER_SIZE + INFO_SIZE, img->colorTable, 1024);
+
+    long width = img->width;
+    long height = img->height;
+    long n = kernelSize / 2;
+
+    // Both buffers are stored bottom row first, so row y matches row y
+    for (long y = 0; y < height; y++) {
+        const unsigned char *src = img->data + (size_t)y * img->stride;
+        unsigned char *dst = map->pixels + (size_t)y * map->rowSize;
+
+        if (y < n || y >= height - n) {
+            memcpy(dst, src, width);
+            continue;
+        }
+        for (long x = 0; x < width; x++) {
+            if (x < n || x >= width - n) {
+                dst[x] = src[x];
+                continue;
+            }
+
+            float sum = 0.0f;
+            for (long ky = -n; ky <= n; ky++)
+                for (long kx = -n; kx <= n; kx++)
+                    sum += img->data[(size_t)(y + ky) * img->stride + x + kx] * kernel[ky + n][kx + n];
+
+            // Clamp result to valid pixel range [0, 255]
+            if (sum < 0) sum = 0;
+            if (sum > 255) sum = 255;
+            dst[x] = (unsigned char)sum;
+        }
+    }
+
+    if (bmpmap_close(map))
+        printf("Image enregistree sous : %s\n", filename);
+    else
+        printf("Erreur : Impossible d'ecrire dans le fichier %s\n", filename);
+}
+
+
+void bmp24_applyFilterMapped(t_bmp24 *img, float **kernel, int kernelSize, const char *filename)
+{
+    t_bmp_map *map = bmpmap_create(filename, img->width, img->height, 24);
+    if (!map) return;
+
+    int n = (kernelSize - 1) / 2;
+    for (int y = 0; y < img->height; y++) {
+        uint8_t *row = bmpmap_row(map, y);
+        for (int x = 0; x < img->width; x++) {
+            int border = y < n || y >= img->height - n || x < n || x >= img->width - n;
+            t_pixel p = border ? img->data[y][x] : bmp24_convolution(img, x, y, kernel, kernelSize);
+            row[x * 3]     = p.blue;
+            row[x * 3 + 1] = p.green;
+            row[x * 3 + 2] = p.red;
+        }
+    }
+
+    if (bmpmap_close(map))
+        printf("Image successfully saved\n");
+    else
+        printf("Error: Writing of the file %s failed\n", filename);
+}
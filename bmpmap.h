@@ -0,0 +1,143 @@
+/**
+ * @file bmpmap.h
+ * @brief BMP output files written in place through a memory mapping
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines a writer that creates the final BMP file at its
+ * full size (headers and padded pixel array), maps it in memory and lets
+ * results be written straight into the mapped rows:
+ * - No stdio buffer and no intermediate image: the page cache writes the
+ *   pixels back to disk
+ * - Uncompressed 8-bit (with color table) and 24-bit files
+ * - Save and filter functions that write their output directly into the file
+ *
+ * POSIX systems use ftruncate/posix_fallocate and mmap, Windows uses a file
+ * mapping object.
+ */
+
+#ifndef BMPMAP_H
+#define BMPMAP_H
+
+#include "bmp8.h"
+#include "bmp24.h"
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @struct t_bmp_map
+ * @brief BMP file created at its final size and mapped for writing
+ *
+ * Rows are stored as in the file: bottom row first, BGR order for 24-bit,
+ * each row padded to a multiple of 4 bytes.
+ */
+typedef struct {
+    uint8_t *base;      /**< Start of the mapped file */
+    uint64_t size;      /**< Size of the file in bytes */
+    uint8_t *pixels;    /**< Start of the pixel array (bottom row) */
+    size_t rowSize;     /**< Bytes per row, padding included */
+    int width;          /**< Image width in pixels */
+    int height;         /**< Image height in pixels */
+    int bits;           /**< Bits per pixel: 8 or 24 */
+#ifdef _WIN32
+    void *file;         /**< File handle */
+    void *mapping;      /**< File mapping handle */
+#else
+    int fd;             /**< File descriptor */
+#endif
+} t_bmp_map;
+
+/* ============================================================================
+ * MAPPING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Create a BMP file at its final size and map it for writing
+ * @param filename Path of the file to create (replaced if it exists)
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param bits 8 (identity gray color table) or 24
+ * @return Mapped file with headers written and zeroed pixels, or NULL on failure
+ *
+ * The disk space is reserved up front, so writing the pixels cannot fail for
+ * lack of space.
+ */
+t_bmp_map *bmpmap_create(const char *filename, int width, int height, int bits);
+
+/**
+ * @brief Address of a row of the mapped pixel array
+ * @param map Mapped file
+ * @param y Row index, 0 being the top row of the image
+ * @return First byte of the row
+ */
+uint8_t *bmpmap_row(const t_bmp_map *map, int y);
+
+/**
+ * @brief View an 8-bit mapped file as a t_bmp8
+ * @param map Mapped file created with 8 bits
+ * @return Image whose data is the mapped pixel array (stride = padded row size)
+ *
+ * Every bmp8 function that modifies pixels without changing the size can be
+ * applied to the view and writes into the file. bmp8_resize, and
+ * bmp8_rotate by a quarter turn on a non-square image, need a new pixel
+ * array and must not be used on it. The view owns nothing: do not pass it
+ * to bmp8_freeImage, and stop using it once the map is closed.
+ */
+t_bmp8 bmpmap_view8(t_bmp_map *map);
+
+/**
+ * @brief Unmap and close the file
+ * @param map Mapped file, freed by this call
+ * @return 1 on success, 0 if the mapping or the file could not be closed
+ */
+int bmpmap_close(t_bmp_map *map);
+
+/* ============================================================================
+ * IMAGE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Save an 8-bit image through a mapped file
+ * @param filename Path where to save the file
+ * @param img Pointer to the image to save
+ *
+ * Same file as bmp8_saveImage, written with one copy per row.
+ */
+void bmp8_saveImageMapped(const char *filename, t_bmp8 *img);
+
+/**
+ * @brief Save a 24-bit image through a mapped file
+ * @param img Pointer to the image to save
+ * @param filename Path where to save the file
+ *
+ * Pixels are converted from RGB to BGR directly into the mapped rows.
+ */
+void bmp24_saveImageMapped(t_bmp24 *img, const char *filename);
+
+/**
+ * @brief Apply a convolution filter and write the result to a new file
+ * @param filename Path of the output file
+ * @param img Source image (not modified)
+ * @param kernel Convolution kernel
+ * @param kernelSize Size of the kernel (odd)
+ *
+ * Same arithmetic as bmp8_applyFilter; filtered pixels go straight into the
+ * mapped file without a temporary image. Border pixels are copied.
+ */
+void bmp8_applyFilterMapped(const char *filename, t_bmp8 *img, float **kernel, int kernelSize);
+
+/**
+ * @brief Apply a convolution filter and write the result to a new file
+ * @param img Source image (not modified)
+ * @param kernel Convolution kernel
+ * @param kernelSize Size of the kernel (odd)
+ * @param filename Path of the output file
+ *
+ * Uses bmp24_convolution for each pixel and stores the result in BGR order
+ * directly in the mapped file. Border pixels are copied.
+ */
+void bmp24_applyFilterMapped(t_bmp24 *img, float **kernel, int kernelSize, const char *filename);
+
+#endif //BMPMAP_H
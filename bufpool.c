@@ -0,0 +1,283 @@
+/**
+ * @file bufpool.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Size-class pool of pixel buffers
+ *
+ */
+
+#include "bufpool.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+// ========================================
+// POOL STATE
+// ========================================
+
+// Placed in front of every buffer; the size keeps the buffer aligned
+typedef union t_pool_header {
+    struct {
+        union t_pool_header *next;  // Next free buffer of the class
+        size_t size;                // Class size (usable bytes)
+        int cls;                    // Class index, -1 if too large for a class
+        void *mapping;              // Start of the mmap'ed range, NULL if from the heap
+        size_t mappingSize;
+        int huge;                   // Transparent huge pages were requested
+    } info;
+    unsigned char align[POOL_ALIGN];
+} t_pool_header;
+
+static t_pool_header *pool_lists[POOL_CLASSES];
+static size_t pool_inUse = 0;
+static size_t pool_cached = 0;
+static size_t pool_limit = POOL_DEFAULT_LIMIT;
+static unsigned long pool_hits = 0;
+static unsigned long pool_misses = 0;
+static unsigned long pool_huge = 0;
+static int pool_hugePages = 0;
+
+// Held for a few instructions at a time: a spin lock is enough
+static atomic_flag pool_lock = ATOMIC_FLAG_INIT;
+
+static void pool_acquire(void)
+{
+    while (atomic_flag_test_and_set_explicit(&pool_lock, memory_order_acquire))
+        ;
+}
+
+static void pool_releaseLock(void)
+{
+    atomic_flag_clear_explicit(&pool_lock, memory_order_release);
+}
+
+// ========================================
+// SYSTEM MEMORY
+// ========================================
+
+
+#ifdef __linux__
+/**
+ * Map a buffer whose data starts on a 2 MiB boundary and ask for transparent
+ * huge pages on it. The header sits just before, in a normal page; the rest
+ * of the mapping used for the alignment is unmapped.
+ */
+static t_pool_header * pool_hugeAlloc(size_t size)
+{
+    size_t dataLength = (size + POOL_HUGE_PAGE - 1) & ~(POOL_HUGE_PAGE - 1);
+    size_t length = dataLength + 2 * POOL_HUGE_PAGE;
+    unsigned char *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        return NULL;
+
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t data = ((uintptr_t)base + sizeof(t_pool_header) + POOL_HUGE_PAGE - 1) & ~(uintptr_t)(POOL_HUGE_PAGE - 1);
+    unsigned char *start = (unsigned char *)((data - sizeof(t_pool_header)) & ~(page - 1));
+    unsigned char *end = (unsigned char *)data + dataLength;
+    if (start > base)
+        munmap(base, start - base);
+    if (base + length > end)
+        munmap(end, base + length - end);
+
+    t_pool_header *header = (t_pool_header *)data - 1;
+
+    // Only a hint: without THP support the buffer simply keeps normal pages
+    header->info.huge = madvise((void *)data, dataLength, MADV_HUGEPAGE) == 0;
+    header->info.mapping = start;
+    header->info.mappingSize = (size_t)(end - start);
+    return header;
+}
+#endif
+
+
+static t_pool_header * pool_systemAlloc(size_t size, int hugePages)
+{
+#ifdef __linux__
+    if (hugePages && size >= POOL_HUGE_PAGE) {
+        t_pool_header *header = pool_hugeAlloc(size);
+        if (header)
+            return header;
+    }
+#else
+    (void)hugePages;
+#endif
+
+    t_pool_header *header;
+    size += sizeof(t_pool_header);
+#ifdef _WIN32
+    header = _aligned_malloc(size, POOL_ALIGN);
+#else
+    void *ptr = NULL;
+    header = posix_memalign(&ptr, POOL_ALIGN, size) == 0 ? ptr : NULL;
+#endif
+    if (header) {
+        header->info.mapping = NULL;
+        header->info.huge = 0;
+    }
+    return header;
+}
+
+
+static void pool_systemFree(t_pool_header *header)
+{
+#ifdef __linux__
+    if (header->info.mapping) {
+        munmap(header->info.mapping, header->info.mappingSize);
+        return;
+    }
+#endif
+#ifdef _WIN32
+    _aligned_free(header);
+#else
+    free(header);
+#endif
+}
+
+// ========================================
+// SIZE CLASSES
+// ========================================
+
+
+/**
+ * Class of a size, and the size of that class in *classSize.
+ * Above 4 KiB, each power of two range (2^k, 2^(k+1)] is split into four
+ * classes of 2^(k-2) bytes: 5, 6, 7 and 8 quarters of 2^k.
+ */
+static int pool_classOf(size_t size, size_t *classSize)
+{
+    if (size <= ((size_t)1 << POOL_MIN_SHIFT)) {
+        *classSize = (size_t)1 << POOL_MIN_SHIFT;
+        return 0;
+    }
+
+    int k = 0;   // Highest bit of size - 1
+    for (size_t v = size - 1; v > 1; v >>= 1)
+        k++;
+    size_t step = (size_t)1 << (k - 2);
+    size_t rounded = (size + step - 1) & ~(step - 1);
+    int cls = (k - POOL_MIN_SHIFT) * 4 + (int)(rounded >> (k - 2)) - 4;
+    if (cls >= POOL_CLASSES) {
+        *classSize = size;
+        return -1;
+    }
+    *classSize = rounded;
+    return cls;
+}
+
+
+// Free buffers until the free lists fit in limit; the largest classes go first
+static void pool_shrink(size_t limit)
+{
+    for (int cls = POOL_CLASSES - 1; cls >= 0 && pool_cached > limit; cls--) {
+        while (pool_lists[cls] && pool_cached > limit) {
+            t_pool_header *header = pool_lists[cls];
+            pool_lists[cls] = header->info.next;
+            pool_cached -= header->info.size;
+            pool_systemFree(header);
+        }
+    }
+}
+
+// ========================================
+// POOL FUNCTIONS
+// ========================================
+
+
+void * pool_alloc(size_t size)
+{
+    size_t classSize;
+    int cls = pool_classOf(size, &classSize);
+
+    pool_acquire();
+    t_pool_header *header = cls >= 0 ? pool_lists[cls] : NULL;
+    if (header) {
+        pool_lists[cls] = header->info.next;
+        pool_cached -= classSize;
+        pool_hits++;
+    } else {
+        pool_misses++;
+    }
+    pool_inUse += classSize;
+    int hugePages = pool_hugePages;
+    pool_releaseLock();
+
+    if (!header) {
+        header = pool_systemAlloc(classSize, hugePages);
+        pool_acquire();
+        if (!header)
+            pool_inUse -= classSize;
+        else if (header->info.huge)
+            pool_huge++;
+        pool_releaseLock();
+        if (!header)
+            return NULL;
+        header->info.size = classSize;
+        header->info.cls = cls;
+    }
+    return header + 1;
+}
+
+
+void pool_free(void *buffer)
+{
+    if (!buffer)
+        return;
+    t_pool_header *header = (t_pool_header *)buffer - 1;
+    size_t size = header->info.size;
+
+    pool_acquire();
+    pool_inUse -= size;
+    int keep = header->info.cls >= 0 && pool_cached + size <= pool_limit;
+    if (keep) {
+        header->info.next = pool_lists[header->info.cls];
+        pool_lists[header->info.cls] = header;
+        pool_cached += size;
+    }
+    pool_releaseLock();
+
+    if (!keep)
+        pool_systemFree(header);
+}
+
+
+void pool_setLimit(size_t bytes)
+{
+    pool_acquire();
+    pool_limit = bytes;
+    pool_shrink(bytes);
+    pool_releaseLock();
+}
+
+
+void pool_setHugePages(int enabled)
+{
+    pool_acquire();
+    pool_hugePages = enabled;
+    pool_releaseLock();
+}
+
+
+void pool_trim(void)
+{
+    pool_acquire();
+    pool_shrink(0);
+    pool_releaseLock();
+}
+
+
+t_pool_stats pool_getStats(void)
+{
+    t_pool_stats stats;
+    pool_acquire();
+    stats.inUse = pool_inUse;
+    stats.cached = pool_cached;
+    stats.limit = pool_limit;
+    stats.hits = pool_hits;
+    stats.misses = pool_misses;
+    stats.huge = pool_huge;
+    pool_releaseLock();
+    return stats;
+}
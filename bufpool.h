@@ -0,0 +1,108 @@
+/**
+ * @file bufpool.h
+ * @brief Size-class pool of pixel buffers
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines the pool that holds the pixel data of t_bmp8 and
+ * t_bmp24 images. Freed buffers are kept in free lists instead of going back
+ * to the system, so a batch of same-sized images reuses the same pages:
+ * - Sizes are rounded up to a size class (4 classes per power of two, so at
+ *   most 25% is wasted), and each class has its own free list
+ * - The most recently freed buffer is reused first, while still in cache
+ * - The memory kept in free lists is capped (pool_setLimit) and can be given
+ *   back at any time (pool_trim)
+ * - Optionally, buffers of 2 MiB and more start on a 2 MiB boundary and are
+ *   backed by transparent huge pages (pool_setHugePages, Linux only), so a
+ *   column walk through a large image needs far fewer TLB entries
+ *
+ * All functions are thread-safe.
+ */
+
+#ifndef BUFPOOL_H
+#define BUFPOOL_H
+
+#include <stddef.h>
+
+/* ============================================================================
+ * POOL CONSTANTS
+ * ============================================================================ */
+
+#define POOL_ALIGN          64                   /**< Alignment of every buffer (cache line) */
+#define POOL_MIN_SHIFT      12                   /**< Smallest class: 4 KiB */
+#define POOL_CLASSES        160                  /**< Classes up to 2^51 bytes */
+#define POOL_DEFAULT_LIMIT  ((size_t)512 << 20)  /**< Default cap of the free lists */
+#define POOL_HUGE_PAGE      ((size_t)2 << 20)    /**< Huge page size and alignment of large buffers */
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @struct t_pool_stats
+ * @brief Pool usage
+ */
+typedef struct {
+    size_t inUse;           /**< Bytes of buffers currently allocated */
+    size_t cached;          /**< Bytes of free buffers kept for reuse */
+    size_t limit;           /**< Maximum of cached */
+    unsigned long hits;     /**< Allocations served from a free list */
+    unsigned long misses;   /**< Allocations that needed new memory */
+    unsigned long huge;     /**< Buffers mapped with transparent huge pages */
+} t_pool_stats;
+
+/* ============================================================================
+ * POOL FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Allocate a buffer
+ * @param size Size in bytes
+ * @return Buffer aligned on POOL_ALIGN bytes, or NULL on failure
+ *
+ * The content is not initialized: a reused buffer holds its previous data.
+ */
+void *pool_alloc(size_t size);
+
+/**
+ * @brief Give a buffer back to the pool
+ * @param buffer Buffer returned by pool_alloc, or NULL
+ *
+ * The buffer is kept for reuse unless the free lists would exceed the limit.
+ */
+void pool_free(void *buffer);
+
+/**
+ * @brief Set the maximum memory kept in the free lists
+ * @param bytes New limit; 0 disables caching
+ *
+ * Free buffers above the new limit are released at once.
+ */
+void pool_setLimit(size_t bytes);
+
+/**
+ * @brief Back large buffers with transparent huge pages
+ * @param enabled Non-zero to map new buffers of POOL_HUGE_PAGE bytes or more
+ *                on a 2 MiB boundary with madvise(MADV_HUGEPAGE)
+ *
+ * Off by default. Applies to buffers taken from the system after the call;
+ * on other systems, or when the mapping fails, buffers come from the heap
+ * as usual. Whether huge pages are actually used depends on the kernel
+ * setting (/sys/kernel/mm/transparent_hugepage/enabled: "always" or "madvise").
+ */
+void pool_setHugePages(int enabled);
+
+/**
+ * @brief Release every free buffer to the system
+ *
+ * Buffers in use are not affected.
+ */
+void pool_trim(void);
+
+/**
+ * @brief Current pool usage
+ * @return Statistics
+ */
+t_pool_stats pool_getStats(void);
+
+#endif //BUFPOOL_H
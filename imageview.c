@@ -0,0 +1,660 @@
+/**
+ * @file imageview.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Zero-copy views of rectangles inside images
+ *
+ */
+
+#include "imageview.h"
+#include "scratch.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ========================================
+// VIEW CREATION FUNCTIONS
+// ========================================
+
+
+t_image_view view_fromBmp8(t_bmp8 *img)
+{
+    t_image_view view;
+    view.width = img->width;
+    view.height = img->height;
+    view.format = VIEW_GRAY8;
+
+    // The last row in memory is the top of the image
+    view.stride = -(ptrdiff_t)img->stride;
+    view.data = img->height ? img->data + (size_t)(img->height - 1) * img->stride : img->data;
+    return view;
+}
+
+
+t_image_view view_fromBmp24(t_bmp24 *img)
+{
+    t_image_view view;
+    view.data = (uint8_t *)img->data[0];
+    view.width = img->width;
+    view.height = img->height;
+
+    // Rows are evenly spaced, and packed both in pool blocks and in shared
+    // memory segments; the stride still comes from the row pointers
+    view.stride = img->height > 1 ? (uint8_t *)img->data[1] - (uint8_t *)img->data[0]
+                                  : (ptrdiff_t)img->width * (ptrdiff_t)sizeof(t_pixel);
+    view.format = VIEW_RGB24;
+    return view;
+}
+
+
+t_image_view view_sub(const t_image_view *view, unsigned int x, unsigned int y,
+                      unsigned int width, unsigned int height)
+{
+    t_image_view sub = *view;
+    if (x >= view->width || y >= view->height) {
+        sub.width = sub.height = 0;
+        return sub;
+    }
+    sub.width = width < view->width - x ? width : view->width - x;
+    sub.height = height < view->height - y ? height : view->height - y;
+    sub.data = view->data + (ptrdiff_t)y * view->stride + (size_t)x * view->format;
+    return sub;
+}
+
+
+uint8_t * view_row(const t_image_view *view, unsigned int y)
+{
+    return view->data + (ptrdiff_t)y * view->stride;
+}
+
+// ========================================
+// POINT OPERATIONS
+// ========================================
+
+
+void view_negative(t_image_view *view)
+{
+    size_t rowBytes = (size_t)view->width * view->format;
+    for (unsigned int y = 0; y < view->height; y++) {
+        uint8_t *row = view_row(view, y);
+        for (size_t i = 0; i < rowBytes; i++)
+            row[i] = 255 - row[i];   // Every channel is inverted the same way
+    }
+}
+
+
+void view_brightness(t_image_view *view, int value)
+{
+    size_t rowBytes = (size_t)view->width * view->format;
+    for (unsigned int y = 0; y < view->height; y++) {
+        uint8_t *row = view_row(view, y);
+        for (size_t i = 0; i < rowBytes; i++) {
+            // Clamp values to valid range [0, 255]
+            int v = row[i] + value;
+            row[i] = v > 255 ? 255 : (v < 0 ? 0 : v);
+        }
+    }
+}
+
+
+int view_threshold(t_image_view *view, int threshold)
+{
+    if (view->format != VIEW_GRAY8)
+        return 0;
+    for (unsigned int y = 0; y < view->height; y++) {
+        uint8_t *row = view_row(view, y);
+        for (unsigned int x = 0; x < view->width; x++)
+            row[x] = row[x] > threshold ? 255 : 0;
+    }
+    return 1;
+}
+
+
+int view_grayscale(t_image_view *view)
+{
+    if (view->format != VIEW_RGB24)
+        return 0;
+    for (unsigned int y = 0; y < view->height; y++) {
+        t_pixel *row = (t_pixel *)view_row(view, y);
+        for (unsigned int x = 0; x < view->width; x++) {
+            // Average of RGB values in all color channels
+            uint8_t gray = (row[x].blue + row[x].green + row[x].red) / 3;
+            row[x].red = row[x].green = row[x].blue = gray;
+        }
+    }
+    return 1;
+}
+
+
+int view_sepia(t_image_view *view)
+{
+    if (view->format != VIEW_RGB24)
+        return 0;
+    for (unsigned int y = 0; y < view->height; y++) {
+        t_pixel *row = (t_pixel *)view_row(view, y);
+        for (unsigned int x = 0; x < view->width; x++) {
+            // Conversion for RGB to sepia scale
+            unsigned int R = (int)round(row[x].red * 0.393 + row[x].green * 0.769 + row[x].blue * 0.189);
+            unsigned int G = (int)round(row[x].red * 0.349 + row[x].green * 0.686 + row[x].blue * 0.168);
+            unsigned int B = (int)round(row[x].red * 0.272 + row[x].green * 0.534 + row[x].blue * 0.131);
+
+            // Clamp RGB values to the [0, 255] range
+            row[x].red   = R > 255 ? 255 : R;
+            row[x].green = G > 255 ? 255 : G;
+            row[x].blue  = B > 255 ? 255 : B;
+        }
+    }
+    return 1;
+}
+
+void view_applyLut(t_image_view *view, const uint8_t *lut)
+{
+    size_t rowBytes = (size_t)view->width * view->format;
+    for (unsigned int y = 0; y < view->height; y++) {
+        uint8_t *row = view_row(view, y);
+        for (size_t i = 0; i < rowBytes; i++)
+            row[i] = lut[row[i]];
+    }
+}
+
+
+// Copy a row, mirrored if requested, through the lookup table
+static void view_remapRow(uint8_t *dst, const uint8_t *src, unsigned int width, int channels,
+                          int flipColumns, const uint8_t *lut)
+{
+    if (!flipColumns) {
+        size_t rowBytes = (size_t)width * channels;
+        if (lut)
+            for (size_t i = 0; i < rowBytes; i++)
+                dst[i] = lut[src[i]];
+        else
+            memcpy(dst, src, rowBytes);
+        return;
+    }
+    for (unsigned int x = 0; x < width; x++) {
+        const uint8_t *in = src + (size_t)(width - 1 - x) * channels;
+        for (int c = 0; c < channels; c++)
+            dst[(size_t)x * channels + c] = lut ? lut[in[c]] : in[c];
+    }
+}
+
+
+int view_remap(t_image_view *view, int flipRows, int flipColumns, const uint8_t *lut)
+{
+    if (!flipRows && !flipColumns) {
+        if (lut)
+            view_applyLut(view, lut);
+        return 1;
+    }
+
+    size_t mark = scratch_mark();
+    size_t rowBytes = (size_t)view->width * view->format;
+    uint8_t *top = scratch_alloc(rowBytes);
+    uint8_t *bottom = scratch_alloc(rowBytes);
+    if (!top || !bottom) {
+        printf("Error allocating scratch memory\n");
+        scratch_release(mark);
+        return 0;
+    }
+
+    // Row y and its mirror are read before either is written
+    for (unsigned int y = 0; y < (view->height + 1) / 2; y++) {
+        uint8_t *a = view_row(view, y);
+        uint8_t *b = view_row(view, flipRows ? view->height - 1 - y : y);
+        view_remapRow(top, a, view->width, view->format, flipColumns, lut);
+        if (b != a) {
+            view_remapRow(bottom, b, view->width, view->format, flipColumns, lut);
+            memcpy(a, bottom, rowBytes);
+            memcpy(b, top, rowBytes);
+        } else {
+            memcpy(a, top, rowBytes);
+        }
+    }
+
+    // Without a row flip only the top half was visited
+    for (unsigned int y = (view->height + 1) / 2; !flipRows && y < view->height; y++) {
+        uint8_t *a = view_row(view, y);
+        view_remapRow(top, a, view->width, view->format, flipColumns, lut);
+        memcpy(a, top, rowBytes);
+    }
+
+    scratch_release(mark);
+    return 1;
+}
+
+// ========================================
+// GEOMETRY FUNCTIONS
+// ========================================
+
+
+void view_flipRows(t_image_view *view)
+{
+    uint8_t temp[1024];
+    size_t rowBytes = (size_t)view->width * view->format;
+    for (unsigned int y = 0; y < view->height / 2; y++) {
+        uint8_t *a = view_row(view, y);
+        uint8_t *b = view_row(view, view->height - 1 - y);
+        for (size_t i = 0; i < rowBytes; i += sizeof(temp)) {
+            size_t n = rowBytes - i < sizeof(temp) ? rowBytes - i : sizeof(temp);
+            memcpy(temp, a + i, n);
+            memcpy(a + i, b + i, n);
+            memcpy(b + i, temp, n);
+        }
+    }
+}
+
+
+#if defined(__SSE2__)
+// Bytes of a 16-byte vector in reverse order
+static __m128i view_reverse16(__m128i v)
+{
+    v = _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));       // Reverse the 32-bit words
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));     // Then the 16-bit halves
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));   // Then the bytes
+}
+#endif
+
+
+static void view_reverseBytes(uint8_t *row, size_t width)
+{
+    size_t left = 0, right = width;
+#if defined(__SSE2__)
+    // 16 bytes from each end, reversed and exchanged
+    for (; right - left >= 32; left += 16, right -= 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(row + left));
+        __m128i b = _mm_loadu_si128((const __m128i *)(row + right - 16));
+        _mm_storeu_si128((__m128i *)(row + left), view_reverse16(b));
+        _mm_storeu_si128((__m128i *)(row + right - 16), view_reverse16(a));
+    }
+#endif
+    for (; right - left >= 2; left++, right--) {
+        uint8_t temp = row[left];
+        row[left] = row[right - 1];
+        row[right - 1] = temp;
+    }
+}
+
+
+static void view_reversePixels(t_pixel *row, size_t width)
+{
+    for (size_t left = 0, right = width; right - left >= 2; left++, right--) {
+        t_pixel temp = row[left];
+        row[left] = row[right - 1];
+        row[right - 1] = temp;
+    }
+}
+
+
+void view_flipColumns(t_image_view *view)
+{
+    for (unsigned int y = 0; y < view->height; y++) {
+        if (view->format == VIEW_GRAY8)
+            view_reverseBytes(view_row(view, y), view->width);
+        else
+            view_reversePixels((t_pixel *)view_row(view, y), view->width);
+    }
+}
+
+
+// Destination address of each source pixel: origin + x * stepX + y * stepY
+typedef struct {
+    uint8_t *origin;
+    ptrdiff_t stepX;
+    ptrdiff_t stepY;
+} t_view_mapping;
+
+
+static void view_transformBlock(const t_image_view *src, const t_view_mapping *map,
+                                unsigned int x0, unsigned int y0, unsigned int width, unsigned int height)
+{
+    // Split the longer side until the block is small enough to stay in cache
+    if (width > VIEW_BLOCK || height > VIEW_BLOCK) {
+        if (width >= height) {
+            view_transformBlock(src, map, x0, y0, width / 2, height);
+            view_transformBlock(src, map, x0 + width / 2, y0, width - width / 2, height);
+        } else {
+            view_transformBlock(src, map, x0, y0, width, height / 2);
+            view_transformBlock(src, map, x0, y0 + height / 2, width, height - height / 2);
+        }
+        return;
+    }
+
+    for (unsigned int y = y0; y < y0 + height; y++) {
+        uint8_t *out = map->origin + (ptrdiff_t)x0 * map->stepX + (ptrdiff_t)y * map->stepY;
+        if (src->format == VIEW_GRAY8) {
+            const uint8_t *in = view_row(src, y) + x0;
+            for (unsigned int x = 0; x < width; x++, out += map->stepX)
+                *out = in[x];
+        } else {
+            const t_pixel *in = (const t_pixel *)view_row(src, y) + x0;
+            for (unsigned int x = 0; x < width; x++, out += map->stepX)
+                *(t_pixel *)out = in[x];
+        }
+    }
+}
+
+
+int view_transform(const t_image_view *src, t_image_view *dst, int transpose, int flipRows, int flipColumns)
+{
+    unsigned int width = transpose ? src->height : src->width;
+    unsigned int height = transpose ? src->width : src->height;
+    if (dst->width != width || dst->height != height || dst->format != src->format)
+        return 0;
+    if (width == 0 || height == 0)
+        return 1;
+
+    // Moving along a source row moves along a destination row, or down a
+    // column when transposed; flips reverse the direction
+    ptrdiff_t stepColumn = flipColumns ? -(ptrdiff_t)dst->format : (ptrdiff_t)dst->format;
+    ptrdiff_t stepRow = flipRows ? -dst->stride : dst->stride;
+    t_view_mapping map;
+    map.origin = view_row(dst, flipRows ? height - 1 : 0) + (flipColumns ? (size_t)(width - 1) * dst->format : 0);
+    map.stepX = transpose ? stepRow : stepColumn;
+    map.stepY = transpose ? stepColumn : stepRow;
+
+    view_transformBlock(src, &map, 0, 0, src->width, src->height);
+    return 1;
+}
+
+
+// Swap the block at (x0, y0) with its mirror image across the diagonal
+static void view_swapBlock(t_image_view *view, unsigned int x0, unsigned int y0, unsigned int width, unsigned int height)
+{
+    if (width > VIEW_BLOCK || height > VIEW_BLOCK) {
+        if (width >= height) {
+            view_swapBlock(view, x0, y0, width / 2, height);
+            view_swapBlock(view, x0 + width / 2, y0, width - width / 2, height);
+        } else {
+            view_swapBlock(view, x0, y0, width, height / 2);
+            view_swapBlock(view, x0, y0 + height / 2, width, height - height / 2);
+        }
+        return;
+    }
+
+    int channels = view->format;
+    for (unsigned int y = y0; y < y0 + height; y++)
+        for (unsigned int x = x0; x < x0 + width; x++) {
+            uint8_t *a = view_row(view, y) + (size_t)x * channels;
+            uint8_t *b = view_row(view, x) + (size_t)y * channels;
+            for (int c = 0; c < channels; c++) {
+                uint8_t temp = a[c];
+                a[c] = b[c];
+                b[c] = temp;
+            }
+        }
+}
+
+
+// Transpose the square of side n starting at (start, start)
+static void view_transposeDiagonal(t_image_view *view, unsigned int start, unsigned int n)
+{
+    if (n > VIEW_BLOCK) {
+        unsigned int half = n / 2;
+        view_transposeDiagonal(view, start, half);
+        view_transposeDiagonal(view, start + half, n - half);
+        view_swapBlock(view, start + half, start, n - half, half);
+        return;
+    }
+    // Each row swaps the pixels on the left of the diagonal
+    for (unsigned int y = start; y < start + n; y++)
+        view_swapBlock(view, start, y, y - start, 1);
+}
+
+
+int view_transposeSquare(t_image_view *view)
+{
+    if (view->width != view->height)
+        return 0;
+    view_transposeDiagonal(view, 0, view->width);
+    return 1;
+}
+
+// ========================================
+// GEOMETRIC TRANSFORMATION FUNCTIONS
+// ========================================
+
+
+#define VIEW_FIXED_ONE  65536.0     // 16.16 fixed point
+
+// Channel c of pixel (x, y), or the fill value outside the view
+static int view_sampleAt(const t_image_view *src, int64_t x, int64_t y, int c, int fill)
+{
+    if (x < 0 || y < 0 || x >= src->width || y >= src->height)
+        return fill;
+    return view_row(src, (unsigned int)y)[x * src->format + c];
+}
+
+
+// Bilinear blend of 4 neighbours with 8-bit weights
+static inline uint8_t view_blend(int topLeft, int topRight, int bottomLeft, int bottomRight, int fx, int fy)
+{
+    int upper = topLeft * (256 - fx) + topRight * fx;
+    int lower = bottomLeft * (256 - fx) + bottomRight * fx;
+    return (uint8_t)((upper * (256 - fy) + lower * fy + 0x8000) >> 16);
+}
+
+
+// One row of a tile, nearest pixel: source position (u, v) in 16.16, stepped by (du, dv)
+static void view_warpNearest(const t_image_view *src, uint8_t *out, unsigned int count,
+                             int64_t u, int64_t v, int64_t du, int64_t dv, int fill)
+{
+    int64_t width = src->width, height = src->height;
+    for (unsigned int i = 0; i < count; i++, u += du, v += dv, out += src->format) {
+        int64_t x = (u + 0x8000) >> 16;
+        int64_t y = (v + 0x8000) >> 16;
+        if (x < 0 || y < 0 || x >= width || y >= height)
+            memset(out, fill, src->format);
+        else if (src->format == VIEW_GRAY8)
+            *out = view_row(src, (unsigned int)y)[x];
+        else
+            *(t_pixel *)out = ((const t_pixel *)view_row(src, (unsigned int)y))[x];
+    }
+}
+
+
+// One row of a tile, bilinear: same stepping, weights are the 8 bits below the point
+static void view_warpBilinear(const t_image_view *src, uint8_t *out, unsigned int count,
+                              int64_t u, int64_t v, int64_t du, int64_t dv, int fill)
+{
+    int64_t width = src->width, height = src->height;
+    for (unsigned int i = 0; i < count; i++, u += du, v += dv, out += src->format) {
+        int64_t x = u >> 16, y = v >> 16;
+        int fx = (int)((u >> 8) & 0xFF);
+        int fy = (int)((v >> 8) & 0xFF);
+
+        if (x >= 0 && y >= 0 && x + 1 < width && y + 1 < height) {
+            // Inside: the 4 neighbours are two pairs of adjacent pixels
+            const uint8_t *top = view_row(src, (unsigned int)y) + x * src->format;
+            const uint8_t *bottom = top + src->stride;
+            if (src->format == VIEW_GRAY8) {
+                *out = view_blend(top[0], top[1], bottom[0], bottom[1], fx, fy);
+            } else {
+                out[0] = view_blend(top[0], top[3], bottom[0], bottom[3], fx, fy);
+                out[1] = view_blend(top[1], top[4], bottom[1], bottom[4], fx, fy);
+                out[2] = view_blend(top[2], top[5], bottom[2], bottom[5], fx, fy);
+            }
+        } else if (x < -1 || y < -1 || x >= width || y >= height) {
+            memset(out, fill, src->format);
+        } else {
+            // On the edge: neighbours outside take the fill value
+            for (int c = 0; c < (int)src->format; c++)
+                out[c] = view_blend(view_sampleAt(src, x, y, c, fill), view_sampleAt(src, x + 1, y, c, fill),
+                                    view_sampleAt(src, x, y + 1, c, fill), view_sampleAt(src, x + 1, y + 1, c, fill),
+                                    fx, fy);
+        }
+    }
+}
+
+
+int view_warp(const t_image_view *src, t_image_view *dst, const t_affine *transform,
+              t_sampling sampling, uint8_t fill)
+{
+    t_affine inverse;
+    if (src->format != dst->format || sampling > SAMPLE_BILINEAR || !affine_invert(transform, &inverse))
+        return 0;
+
+    int tilesX = (int)((dst->width + VIEW_WARP_TILE - 1) / VIEW_WARP_TILE);
+    int tilesY = (int)((dst->height + VIEW_WARP_TILE - 1) / VIEW_WARP_TILE);
+    int64_t du = llround(inverse.a * VIEW_FIXED_ONE);
+    int64_t dv = llround(inverse.d * VIEW_FIXED_ONE);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int tile = 0; tile < tilesX * tilesY; tile++) {
+        unsigned int x0 = (unsigned int)(tile % tilesX) * VIEW_WARP_TILE;
+        unsigned int y0 = (unsigned int)(tile / tilesX) * VIEW_WARP_TILE;
+        unsigned int columns = dst->width - x0 < VIEW_WARP_TILE ? dst->width - x0 : VIEW_WARP_TILE;
+        unsigned int rows = dst->height - y0 < VIEW_WARP_TILE ? dst->height - y0 : VIEW_WARP_TILE;
+
+        for (unsigned int y = y0; y < y0 + rows; y++) {
+            // Exact start of each row, so errors do not build up along the tile
+            int64_t u = llround((inverse.a * x0 + inverse.b * y + inverse.c) * VIEW_FIXED_ONE);
+            int64_t v = llround((inverse.d * x0 + inverse.e * y + inverse.f) * VIEW_FIXED_ONE);
+            uint8_t *out = view_row(dst, y) + (size_t)x0 * dst->format;
+            if (sampling == SAMPLE_NEAREST)
+                view_warpNearest(src, out, columns, u, v, du, dv, fill);
+            else
+                view_warpBilinear(src, out, columns, u, v, du, dv, fill);
+        }
+    }
+    return 1;
+}
+
+// ========================================
+// CONVOLUTION FUNCTIONS
+// ========================================
+
+
+int view_convolve(const t_image_view *src, const t_image_view *dst, float **kernel, int kernelSize)
+{
+    if (src->width != dst->width || src->height != dst->height || src->format != dst->format)
+        return 0;
+
+    long n = kernelSize / 2;   // Half kernel size for centering
+    long width = src->width;
+    long height = src->height;
+    int channels = src->format;
+
+    // Process only pixels where full kernel fits
+    for (long y = n; y < height - n; y++) {
+        uint8_t *out = view_row(dst, (unsigned int)y);
+        for (long x = n; x < width - n; x++) {
+            float sum[3] = {0.0f, 0.0f, 0.0f};
+
+            // Multiply pixel values by kernel weights and accumulate
+            for (long i = 0; i < kernelSize; i++) {
+                const uint8_t *in = view_row(src, (unsigned int)(y + i - n)) + (x - n) * channels;
+                for (long j = 0; j < kernelSize; j++)
+                    for (int c = 0; c < channels; c++)
+                        sum[c] += in[j * channels + c] * kernel[i][j];
+            }
+
+            // Clamp result to valid pixel range [0, 255]
+            for (int c = 0; c < channels; c++)
+                out[x * channels + c] = (sum[c] > 255) ? 255 : ((sum[c] < 0) ? 0 : (uint8_t)sum[c]);
+        }
+    }
+    return 1;
+}
+
+
+int view_applyFilter(t_image_view *view, float **kernel, int kernelSize)
+{
+    // The convolution reads an unmodified copy, results are written in place
+    size_t mark = scratch_mark();
+    size_t rowBytes = (size_t)view->width * view->format;
+    t_image_view copy = *view;
+    copy.stride = (ptrdiff_t)rowBytes;
+    copy.data = scratch_alloc(rowBytes * view->height);
+    if (!copy.data)
+        return 0;
+    for (unsigned int y = 0; y < view->height; y++)
+        memcpy(view_row(&copy, y), view_row(view, y), rowBytes);
+
+    view_convolve(&copy, view, kernel, kernelSize);
+    scratch_release(mark);
+    return 1;
+}
+
+
+// Rows [y, y + rows) of a band buffer back into the view
+static void view_writeBand(t_image_view *view, const uint8_t *band, unsigned int y, unsigned int rows)
+{
+    size_t rowBytes = (size_t)view->width * view->format;
+    for (unsigned int i = 0; i < rows; i++)
+        memcpy(view_row(view, y + i), band + i * rowBytes, rowBytes);
+}
+
+
+int view_applyFilters(t_image_view *view, float ***kernels, const int *kernelSizes, int count)
+{
+    unsigned int halo = 0;
+    for (int i = 0; i < count; i++)
+        halo += kernelSizes[i] / 2;
+
+    // A band must not be read by the band after next
+    if (count == 1 || halo > VIEW_TILE_ROWS) {
+        for (int i = 0; i < count; i++)
+            if (!view_applyFilter(view, kernels[i], kernelSizes[i]))
+                return 0;
+        return 1;
+    }
+
+    size_t mark = scratch_mark();
+    int channels = view->format;
+    size_t rowBytes = (size_t)view->width * channels;
+    size_t tileBytes = (size_t)(VIEW_TILE_COLUMNS + 2 * halo) * (VIEW_TILE_ROWS + 2 * halo) * channels;
+    uint8_t *buffers[2] = {scratch_alloc(tileBytes), scratch_alloc(tileBytes)};
+    uint8_t *bands[2] = {scratch_alloc(rowBytes * VIEW_TILE_ROWS), scratch_alloc(rowBytes * VIEW_TILE_ROWS)};
+    if (!buffers[0] || !buffers[1] || !bands[0] || !bands[1]) {
+        scratch_release(mark);
+        return 0;
+    }
+
+    unsigned int band = 0, bandRows = 0;
+    for (unsigned int by = 0; by < view->height; by += VIEW_TILE_ROWS, band++) {
+        bandRows = view->height - by < VIEW_TILE_ROWS ? view->height - by : VIEW_TILE_ROWS;
+        uint8_t *out = bands[band & 1];
+
+        for (unsigned int bx = 0; bx < view->width; bx += VIEW_TILE_COLUMNS) {
+            unsigned int tileColumns = view->width - bx < VIEW_TILE_COLUMNS ? view->width - bx : VIEW_TILE_COLUMNS;
+
+            // Tile and halo, clipped to the image: at the image edges the
+            // filters leave pixels as they are, inside the halo absorbs them
+            unsigned int x0 = bx > halo ? bx - halo : 0;
+            unsigned int y0 = by > halo ? by - halo : 0;
+            t_image_view src = view_sub(view, x0, y0, bx + tileColumns + halo - x0, by + bandRows + halo - y0);
+            t_image_view a = src, b = src;
+            a.stride = b.stride = (ptrdiff_t)src.width * channels;
+            a.data = buffers[0];
+            b.data = buffers[1];
+            for (unsigned int y = 0; y < src.height; y++)
+                memcpy(view_row(&a, y), view_row(&src, y), (size_t)src.width * channels);
+
+            // Every filter runs on the cached tile; pixels it does not
+            // write keep the previous value
+            for (int i = 0; i < count; i++) {
+                memcpy(b.data, a.data, (size_t)a.height * a.stride);
+                view_convolve(&a, &b, kernels[i], kernelSizes[i]);
+                t_image_view swap = a;
+                a = b;
+                b = swap;
+            }
+
+            t_image_view tile = view_sub(&a, bx - x0, by - y0, tileColumns, bandRows);
+            for (unsigned int y = 0; y < bandRows; y++)
+                memcpy(out + y * rowBytes + (size_t)bx * channels, view_row(&tile, y), (size_t)tileColumns * channels);
+        }
+
+        // The previous band is no longer read by any tile
+        if (band > 0)
+            view_writeBand(view, bands[(band - 1) & 1], by - VIEW_TILE_ROWS, VIEW_TILE_ROWS);
+    }
+    if (band > 0)
+        view_writeBand(view, bands[(band - 1) & 1], (band - 1) * VIEW_TILE_ROWS, bandRows);
+
+    scratch_release(mark);
+    return 1;
+}
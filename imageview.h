@@ -0,0 +1,288 @@
+/**
+ * @file imageview.h
+ * @brief Zero-copy views of rectangles inside images
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines an image view: a pointer to the top-left pixel
+ * of a rectangle, its size, the distance between rows and the pixel format.
+ * A view references the pixels of a t_bmp8 or t_bmp24 without copying them:
+ * - A region of interest is processed in place by taking a sub-view
+ * - Tiles and bands for parallel processing are sub-views too
+ * - The stride is signed, so the bottom-up rows of a t_bmp8 are seen top-down
+ *
+ * The point operations and convolutions of bmp8 and bmp24 are implemented
+ * on views; the image functions build a view of the whole image and call them.
+ */
+
+#ifndef IMAGEVIEW_H
+#define IMAGEVIEW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bmp8.h"
+#include "bmp24.h"
+#include "affine.h"
+
+/* ============================================================================
+ * IMAGE VIEW CONSTANTS
+ * ============================================================================ */
+
+#define VIEW_TILE_COLUMNS   256     /**< Width of the tiles of fused filters */
+#define VIEW_TILE_ROWS      64      /**< Height of the tiles of fused filters */
+#define VIEW_BLOCK          16      /**< Side of the blocks copied directly by rotations */
+#define VIEW_WARP_TILE      64      /**< Side of the output tiles of affine warps */
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @enum t_view_format
+ * @brief Layout of one pixel
+ */
+typedef enum {
+    VIEW_GRAY8 = 1,     /**< One byte per pixel */
+    VIEW_RGB24 = 3      /**< Red, green and blue bytes (t_pixel) */
+} t_view_format;
+
+/**
+ * @struct t_image_view
+ * @brief Rectangle of pixels inside an image
+ *
+ * Pixel (x, y) starts at data + y * stride + x * format. The view does not
+ * own its pixels: it stays valid as long as the image it was taken from.
+ */
+typedef struct {
+    uint8_t *data;          /**< Top-left pixel */
+    unsigned int width;     /**< Width in pixels */
+    unsigned int height;    /**< Height in pixels */
+    ptrdiff_t stride;       /**< Bytes from a row to the row below, negative for bottom-up images */
+    t_view_format format;   /**< Pixel format, also the number of bytes per pixel */
+} t_image_view;
+
+/* ============================================================================
+ * VIEW CREATION FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief View of a whole 8-bit image
+ * @param img Source image
+ * @return View with row 0 at the top of the image (negative stride)
+ */
+t_image_view view_fromBmp8(t_bmp8 *img);
+
+/**
+ * @brief View of a whole 24-bit image
+ * @param img Source image, rows evenly spaced (as from bmp24_allocate)
+ * @return View of its pixels, row 0 at the top
+ */
+t_image_view view_fromBmp24(t_bmp24 *img);
+
+/**
+ * @brief View of a rectangle inside another view
+ * @param view Parent view
+ * @param x Left column of the rectangle
+ * @param y Top row of the rectangle
+ * @param width Width of the rectangle
+ * @param height Height of the rectangle
+ * @return Sub-view, clipped to the parent (empty if the rectangle is outside)
+ */
+t_image_view view_sub(const t_image_view *view, unsigned int x, unsigned int y,
+                      unsigned int width, unsigned int height);
+
+/**
+ * @brief Start of a row
+ * @param view View
+ * @param y Row index, 0 at the top
+ * @return Pointer to the first pixel of the row
+ */
+uint8_t *view_row(const t_image_view *view, unsigned int y);
+
+/* ============================================================================
+ * POINT OPERATIONS
+ * ============================================================================ */
+
+/**
+ * @brief Invert every channel
+ * @param view Pixels to modify
+ */
+void view_negative(t_image_view *view);
+
+/**
+ * @brief Add a value to every channel, clamped to [0, 255]
+ * @param view Pixels to modify
+ * @param value Value to add (may be negative)
+ */
+void view_brightness(t_image_view *view, int value);
+
+/**
+ * @brief Set pixels above a threshold to white, others to black
+ * @param view Pixels to modify
+ * @param threshold Threshold value
+ * @return 1 on success, 0 if the view is not VIEW_GRAY8
+ */
+int view_threshold(t_image_view *view, int threshold);
+
+/**
+ * @brief Replace each pixel by the average of its channels
+ * @param view Pixels to modify
+ * @return 1 on success, 0 if the view is not VIEW_RGB24
+ */
+int view_grayscale(t_image_view *view);
+
+/**
+ * @brief Apply the sepia tone matrix
+ * @param view Pixels to modify
+ * @return 1 on success, 0 if the view is not VIEW_RGB24
+ */
+int view_sepia(t_image_view *view);
+
+/**
+ * @brief Map every channel through a lookup table
+ * @param view Pixels to modify
+ * @param lut New value of each of the 256 channel values
+ */
+void view_applyLut(t_image_view *view, const uint8_t *lut);
+
+/**
+ * @brief Mirror a view and map its channels through a lookup table, in one pass
+ * @param view Pixels to modify
+ * @param flipRows Non-zero to swap the top and bottom rows (as bmp8_horizontalFlip)
+ * @param flipColumns Non-zero to swap the left and right columns (as bmp8_verticalFlip)
+ * @param lut Lookup table applied to every channel, or NULL to keep the values
+ * @return 1 on success, 0 if the row buffers could not be allocated
+ *
+ * Rows are processed by pairs (y, height - 1 - y) through two row buffers
+ * of the scratch arena, so flipping both ways costs a single pass.
+ */
+int view_remap(t_image_view *view, int flipRows, int flipColumns, const uint8_t *lut);
+
+/* ============================================================================
+ * GEOMETRY FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Swap the top and bottom rows, in place
+ * @param view Pixels to modify
+ *
+ * Rows are exchanged pairwise through a small buffer on the stack.
+ */
+void view_flipRows(t_image_view *view);
+
+/**
+ * @brief Swap the left and right columns, in place
+ * @param view Pixels to modify
+ *
+ * Each row is reversed by swapping pixels from both ends (16 bytes at a
+ * time with SSE2 for 8-bit views).
+ */
+void view_flipColumns(t_image_view *view);
+
+/**
+ * @brief Transpose, then mirror, a view into another one, in one pass
+ * @param src Source pixels (not modified)
+ * @param dst Destination, not overlapping src; width and height swapped
+ *            when transpose is set
+ * @param transpose Non-zero to exchange rows and columns: pixel (x, y) goes to (y, x)
+ * @param flipRows Non-zero to then swap the top and bottom rows of dst
+ * @param flipColumns Non-zero to then swap the left and right columns of dst
+ * @return 1 on success, 0 if the sizes or formats do not match
+ *
+ * These cover the 8 symmetries of a rectangle: rotation by 90 degrees
+ * clockwise is (transpose, flipColumns), by 270 degrees (transpose,
+ * flipRows). The source is split recursively along its longer side down
+ * to VIEW_BLOCK x VIEW_BLOCK blocks, so that the rows being read and the
+ * columns being written stay in cache whatever its size.
+ */
+int view_transform(const t_image_view *src, t_image_view *dst, int transpose, int flipRows, int flipColumns);
+
+/**
+ * @brief Transpose a square view in place
+ * @param view Pixels to modify, width equal to height
+ * @return 1 on success, 0 if the view is not square
+ *
+ * Blocks on both sides of the diagonal are swapped recursively, down to
+ * VIEW_BLOCK x VIEW_BLOCK blocks; no buffer is needed.
+ */
+int view_transposeSquare(t_image_view *view);
+
+/* ============================================================================
+ * GEOMETRIC TRANSFORMATION FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Draw a transformed view into another view
+ * @param src Source pixels (not modified)
+ * @param dst Destination, same format, not overlapping src; any size
+ * @param transform Where each source point goes in dst
+ * @param sampling SAMPLE_NEAREST or SAMPLE_BILINEAR
+ * @param fill Value of every channel of the destination pixels that come
+ *             from outside the source
+ * @return 1 on success, 0 if the formats differ, the sampling is not one of
+ *         the two above or transform is not invertible
+ *
+ * Each destination pixel is read from the source through the inverse
+ * transformation. The destination is walked in VIEW_WARP_TILE x
+ * VIEW_WARP_TILE tiles, so that the source pixels read by a tile stay in
+ * cache whatever the angle; tiles run in parallel with OpenMP. Along a row
+ * of a tile, source coordinates are stepped in 16.16 fixed point and the
+ * bilinear weights are their 8 fractional bits, so the inner loop only
+ * uses integer additions and multiplications. An identity transform gives
+ * back the source exactly.
+ */
+int view_warp(const t_image_view *src, t_image_view *dst, const t_affine *transform,
+              t_sampling sampling, uint8_t fill);
+
+/* ============================================================================
+ * CONVOLUTION FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Convolve a view into another view
+ * @param src Source pixels (not modified)
+ * @param dst Destination, same size and format as src, not overlapping it
+ * @param kernel Square kernel, kernel[0] applied to the row above
+ * @param kernelSize Size of the kernel (odd)
+ * @return 1 on success, 0 if the views do not match
+ *
+ * Only the pixels of dst where the kernel fits inside src are written; the
+ * kernelSize / 2 outer rows and columns of dst are left as they are. To
+ * split a filter into bands, give each band a source view that includes
+ * kernelSize / 2 extra rows above and below, and the matching destination:
+ * the bands then write disjoint rows.
+ */
+int view_convolve(const t_image_view *src, const t_image_view *dst, float **kernel, int kernelSize);
+
+/**
+ * @brief Convolve a view in place
+ * @param view Pixels to modify
+ * @param kernel Square kernel
+ * @param kernelSize Size of the kernel (odd)
+ * @return 1 on success, 0 if the scratch copy could not be allocated
+ *
+ * The view is copied into the scratch arena and convolved back into
+ * itself; pixels where the kernel does not fit inside the view keep their
+ * values.
+ */
+int view_applyFilter(t_image_view *view, float **kernel, int kernelSize);
+
+/**
+ * @brief Apply several filters one after the other, tile by tile
+ * @param view Pixels to modify
+ * @param kernels Square kernels, first applied first
+ * @param kernelSizes Size of each kernel (odd)
+ * @param count Number of filters
+ * @return 1 on success, 0 if the tile buffers could not be allocated
+ *
+ * Gives the same pixels as calling view_applyFilter for each kernel, but in
+ * a single pass over the image: each VIEW_TILE_COLUMNS x VIEW_TILE_ROWS
+ * tile is loaded with a halo of the sum of the kernel radii, every filter
+ * runs on it while it is in cache (the halo shrinks by one radius per
+ * filter), and only the tile itself is kept. Results of a band of tiles
+ * are written back once the next band, which still reads their original
+ * rows, is done.
+ */
+int view_applyFilters(t_image_view *view, float ***kernels, const int *kernelSizes, int count);
+
+#endif //IMAGEVIEW_H
@@ -0,0 +1,197 @@
+/**
+ * @file imgcache.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief In-memory LRU cache of decoded images
+ *
+ * Entries are kept in one doubly linked list, most recently used first.
+ * Lookups walk the list: the cache holds a few dozen large images at most,
+ * so the walk costs nothing next to a decode.
+ *
+ */
+
+#include "imgcache.h"
+#include "netpbm.h"
+#include "qoi.h"
+#include <string.h>
+#include <sys/stat.h>
+
+// Nanoseconds of the file times, where the system records them. Where
+// st_mtim exists, st_mtime is defined as its tv_sec
+#if defined(__APPLE__)
+#define IMGCACHE_MTIME_NSEC(info)   ((info)->st_mtimespec.tv_nsec)
+#define IMGCACHE_CTIME_NSEC(info)   ((info)->st_ctimespec.tv_nsec)
+#elif defined(st_mtime)
+#define IMGCACHE_MTIME_NSEC(info)   ((info)->st_mtim.tv_nsec)
+#define IMGCACHE_CTIME_NSEC(info)   ((info)->st_ctim.tv_nsec)
+#else
+#define IMGCACHE_MTIME_NSEC(info)   0L
+#define IMGCACHE_CTIME_NSEC(info)   0L
+#endif
+
+// ========================================
+// LIST FUNCTIONS
+// ========================================
+
+
+static void imgcache_unlink(t_image_cache *cache, t_cache_entry *entry)
+{
+    if (entry->prev) entry->prev->next = entry->next;
+    else cache->head = entry->next;
+    if (entry->next) entry->next->prev = entry->prev;
+    else cache->tail = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+
+static void imgcache_pushFront(t_image_cache *cache, t_cache_entry *entry)
+{
+    entry->prev = NULL;
+    entry->next = cache->head;
+    if (cache->head) cache->head->prev = entry;
+    else cache->tail = entry;
+    cache->head = entry;
+}
+
+
+static void imgcache_remove(t_image_cache *cache, t_cache_entry *entry)
+{
+    imgcache_unlink(cache, entry);
+    cache->count--;
+    cache->bytes -= entry->bytes;
+    if (entry->bmp8) bmp8_freeImage(entry->bmp8);
+    if (entry->bmp24) bmp24_free(entry->bmp24);
+    free(entry->path);
+    free(entry);
+}
+
+// ========================================
+// LOADING
+// ========================================
+
+
+/**
+ * Decode any supported file into entry->bmp8 or entry->bmp24.
+ * The format is taken from the extension for PGM/PPM and QOI, and from the
+ * bit count of the header for BMP. Returns 1 on success.
+ */
+static int imgcache_load(t_cache_entry *entry)
+{
+    const char *dot = strrchr(entry->path, '.');
+    const char *ext = dot ? dot + 1 : "";
+
+    if (strcmp(ext, "pgm") == 0 || strcmp(ext, "ppm") == 0 || strcmp(ext, "pnm") == 0) {
+        FILE *file = fopen(entry->path, "rb");
+        if (!file) return 0;
+        int gray = (getc(file), getc(file) == '5');
+        rewind(file);
+        if (gray) entry->bmp8 = bmp8_loadPGM(file);
+        else entry->bmp24 = bmp24_loadPPM(file);
+        fclose(file);
+    } else {
+        FILE *file = fopen(entry->path, "rb");
+        if (!file) return 0;
+        unsigned char header[30] = {0};
+        size_t n = fread(header, 1, sizeof(header), file);
+        fclose(file);
+
+        if (n >= 4 && memcmp(header, "qoig", 4) == 0)
+            entry->bmp8 = bmp8_loadQOI(entry->path);
+        else if (n >= 4 && memcmp(header, "qoif", 4) == 0)
+            entry->bmp24 = bmp24_loadQOI(entry->path);
+        else if (n == sizeof(header) && header[28] == 8)
+            entry->bmp8 = bmp8_loadImage(entry->path);
+        else
+            entry->bmp24 = bmp24_loadImage(entry->path);
+    }
+
+    if (entry->bmp8)
+        entry->bytes = entry->bmp8->dataSize;
+    else if (entry->bmp24)
+        entry->bytes = (size_t)entry->bmp24->width * entry->bmp24->height * sizeof(t_pixel);
+    return entry->bmp8 || entry->bmp24;
+}
+
+// ========================================
+// CACHE FUNCTIONS
+// ========================================
+
+
+t_image_cache * imgcache_create(size_t capacity)
+{
+    t_image_cache *cache = calloc(1, sizeof(t_image_cache));
+    if (!cache) {
+        printf("Error allocating memory for the cache\n");
+        return NULL;
+    }
+    cache->capacity = capacity;
+    return cache;
+}
+
+
+void imgcache_free(t_image_cache *cache)
+{
+    if (!cache) return;
+    while (cache->head)
+        imgcache_remove(cache, cache->head);
+    free(cache);
+}
+
+
+// Whether the file is still the one the entry was loaded from
+static int imgcache_unchanged(const t_cache_entry *entry, const struct stat *info)
+{
+    return entry->mtime == info->st_mtime && entry->mtimeNsec == (long)IMGCACHE_MTIME_NSEC(info)
+        && entry->ctime == info->st_ctime && entry->ctimeNsec == (long)IMGCACHE_CTIME_NSEC(info)
+        && entry->inode == (unsigned long long)info->st_ino
+        && entry->fileSize == (long long)info->st_size;
+}
+
+
+const t_cache_entry * imgcache_get(t_image_cache *cache, const char *path)
+{
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        printf("Error : Cannot access %s\n", path);
+        return NULL;
+    }
+
+    for (t_cache_entry *entry = cache->head; entry; entry = entry->next) {
+        if (strcmp(entry->path, path) != 0)
+            continue;
+        if (imgcache_unchanged(entry, &info)) {
+            cache->hits++;
+            imgcache_unlink(cache, entry);
+            imgcache_pushFront(cache, entry);
+            return entry;
+        }
+        imgcache_remove(cache, entry);   // The file changed: decode it again
+        break;
+    }
+
+    cache->misses++;
+    t_cache_entry *entry = calloc(1, sizeof(t_cache_entry));
+    if (!entry || !(entry->path = strdup(path))) {
+        printf("Error allocating memory for the cache\n");
+        free(entry);
+        return NULL;
+    }
+    entry->mtime = info.st_mtime;
+    entry->mtimeNsec = (long)IMGCACHE_MTIME_NSEC(&info);
+    entry->ctime = info.st_ctime;
+    entry->ctimeNsec = (long)IMGCACHE_CTIME_NSEC(&info);
+    entry->inode = (unsigned long long)info.st_ino;
+    entry->fileSize = (long long)info.st_size;
+    if (!imgcache_load(entry)) {
+        free(entry->path);
+        free(entry);
+        return NULL;
+    }
+
+    // Make room, but always keep the new image even if it is larger than the cap
+    while (cache->tail && cache->bytes + entry->bytes > cache->capacity)
+        imgcache_remove(cache, cache->tail);
+    imgcache_pushFront(cache, entry);
+    cache->count++;
+    cache->bytes += entry->bytes;
+    return entry;
+}
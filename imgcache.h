@@ -0,0 +1,93 @@
+/**
+ * @file imgcache.h
+ * @brief In-memory LRU cache of decoded images
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines a cache of images decoded from disk, keyed by
+ * path and checked against the file's inode, size, and modification and
+ * status change times, so that a long-running process decodes each
+ * reference image only once:
+ * - The memory used by the cached pixels is capped; the least recently
+ *   used images are evicted first
+ * - BMP (8 and 24-bit), PGM/PPM and QOI files are recognised
+ *
+ * Times are compared to the nanosecond on Linux, the BSDs and macOS. Other
+ * systems only record whole seconds: there, a file rewritten in place with
+ * an image of the same size within the same second is not noticed.
+ */
+
+#ifndef IMGCACHE_H
+#define IMGCACHE_H
+
+#include <time.h>
+#include "bmp8.h"
+#include "bmp24.h"
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @struct t_cache_entry
+ * @brief One decoded image, in a list ordered from most to least recently used
+ */
+typedef struct t_cache_entry {
+    char *path;                     /**< Path the image was loaded from */
+    time_t mtime;                   /**< Modification time of the file when loaded */
+    long mtimeNsec;                 /**< Nanoseconds of mtime, 0 if not recorded */
+    time_t ctime;                   /**< Status change time of the file when loaded */
+    long ctimeNsec;                 /**< Nanoseconds of ctime, 0 if not recorded */
+    unsigned long long inode;       /**< Inode of the file when loaded */
+    long long fileSize;             /**< Size of the file when loaded */
+    t_bmp8 *bmp8;                   /**< Decoded 8-bit image, or NULL */
+    t_bmp24 *bmp24;                 /**< Decoded 24-bit image, or NULL */
+    size_t bytes;                   /**< Memory used by the pixels */
+    struct t_cache_entry *prev;     /**< More recently used entry */
+    struct t_cache_entry *next;     /**< Less recently used entry */
+} t_cache_entry;
+
+/**
+ * @struct t_image_cache
+ * @brief LRU cache of decoded images
+ */
+typedef struct {
+    t_cache_entry *head;            /**< Most recently used entry */
+    t_cache_entry *tail;            /**< Least recently used entry */
+    int count;                      /**< Number of entries */
+    size_t bytes;                   /**< Memory used by all entries */
+    size_t capacity;                /**< Maximum of bytes */
+    unsigned long hits;             /**< Lookups answered from memory */
+    unsigned long misses;           /**< Lookups that decoded the file */
+} t_image_cache;
+
+/* ============================================================================
+ * CACHE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Create an empty cache
+ * @param capacity Maximum memory used by cached pixels, in bytes
+ * @return Pointer to the cache, or NULL on failure
+ */
+t_image_cache *imgcache_create(size_t capacity);
+
+/**
+ * @brief Free a cache and every image in it
+ * @param cache Cache to free
+ */
+void imgcache_free(t_image_cache *cache);
+
+/**
+ * @brief Get the decoded image of a file, loading it on a miss
+ * @param cache Cache to look in
+ * @param path Path of the image file
+ * @return Entry with bmp8 or bmp24 set, or NULL if the file cannot be loaded
+ *
+ * A cached image whose file changed since it was loaded is decoded again.
+ * The images belong to the cache and must not be modified: copy them with
+ * bmp8_copy or bmp24_copy first. The entry stays valid until the next call.
+ */
+const t_cache_entry *imgcache_get(t_image_cache *cache, const char *path);
+
+#endif //IMGCACHE_H
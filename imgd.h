@@ -0,0 +1,36 @@
+/**
+ * @file imgd.h
+ * @brief Protocol shared by the image daemon (imgd) and its client (imgc)
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * The daemon listens on a Unix domain socket. A connection carries any
+ * number of requests, each one a text line answered before the next is read:
+ *
+ *   JOB <source> <destination> [operation...]
+ *       source       path:<file>   image on the server's disk (BMP, PGM/PPM
+ *                                  or QOI), decoded once and kept in the cache
+ *                    data:<size>   <size> bytes of PGM/PPM follow the line
+ *       destination  path:<file>   written by the server, format taken from
+ *                                  the extension (.pgm/.ppm, .qoi, else BMP)
+ *                    data          result sent back as PGM/PPM
+ *       operations   as in pipe mode, e.g. negative brightness=30
+ *   STATS            cache statistics
+ *   SHUTDOWN         stop the daemon
+ *
+ * Answers: "OK <size>\n" followed by <size> bytes (0 unless the destination
+ * is data, text for STATS), or "ERR <message>\n".
+ *
+ * Paths are percent-encoded so that they stay single words: spaces, '%'
+ * and control characters are sent as %XX (hexadecimal byte value).
+ */
+
+#ifndef IMGD_H
+#define IMGD_H
+
+#define IMGD_SOCKET_PATH   "/tmp/imgd.sock"   /**< Default socket path */
+#define IMGD_LINE_MAX      4096               /**< Longest request or answer line */
+#define IMGD_CACHE_MB      256                /**< Default cache capacity in MiB */
+#define IMGD_RESULT_MB     1024               /**< Default result cache capacity in MiB (-r) */
+
+#endif //IMGD_H
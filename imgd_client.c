@@ -0,0 +1,172 @@
+/**
+ * @file imgd_client.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Command-line client of the image daemon
+ *
+ * Usage: imgc [-s socket] <input> <output> [operation...]
+ *        imgc [-s socket] stats | shutdown
+ *
+ * <input> is a file read by the daemon, or "-" to send a PGM/PPM image from
+ * stdin. <output> is a file written by the daemon, or "-" to receive the
+ * result as PGM/PPM on stdout. Relative paths are resolved here, since the
+ * daemon may run in another directory.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "imgd.h"
+
+
+// Read all of a stream into memory; *size receives the length
+static char * readAll(FILE *file, size_t *size)
+{
+    size_t capacity = 1 << 20;
+    char *data = malloc(capacity);
+    *size = 0;
+    while (data) {
+        *size += fread(data + *size, 1, capacity - *size, file);
+        if (*size < capacity)
+            break;
+        char *bigger = realloc(data, capacity * 2);
+        if (!bigger) free(data);
+        data = bigger;
+        capacity *= 2;
+    }
+    return data;
+}
+
+
+// Send " path:<path>", percent-encoded since the request is split on spaces
+static void sendPath(FILE *out, const char *path)
+{
+    fprintf(out, " path:");
+    for (const unsigned char *c = (const unsigned char *)path; *c; c++) {
+        if (*c <= ' ' || *c == '%' || *c == 0x7f)
+            fprintf(out, "%%%02X", *c);
+        else
+            putc(*c, out);
+    }
+}
+
+
+// Absolute form of an output path, which may not exist yet
+static int absolutePath(const char *path, char *dest, size_t size)
+{
+    if (path[0] == '/')
+        return snprintf(dest, size, "%s", path) < (int)size;
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd)))
+        return 0;
+    return snprintf(dest, size, "%s/%s", cwd, path) < (int)size;
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char *socketPath = IMGD_SOCKET_PATH;
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "-s") == 0) {
+        socketPath = argv[2];
+        first = 3;
+    }
+    if (argc - first < 1 || (argc - first < 2 && strcmp(argv[first], "stats") != 0
+                             && strcmp(argv[first], "shutdown") != 0)) {
+        fprintf(stderr, "Usage: %s [-s socket] <input> <output> [operation...]\n"
+                        "       %s [-s socket] stats | shutdown\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    struct sockaddr_un address = {0};
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", socketPath);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        perror("Error : Cannot connect to the daemon");
+        return 1;
+    }
+    FILE *in = fdopen(dup(fd), "rb");
+    FILE *out = fdopen(fd, "wb");
+    if (!in || !out) {
+        perror("Error : Cannot open the connection");
+        return 1;
+    }
+
+    // Build and send the request
+    char *data = NULL;
+    size_t dataSize = 0;
+    int toStdout = 0;
+    if (strcmp(argv[first], "stats") == 0) {
+        fprintf(out, "STATS\n");
+        toStdout = 1;
+    } else if (strcmp(argv[first], "shutdown") == 0) {
+        fprintf(out, "SHUTDOWN\n");
+    } else {
+        char path[PATH_MAX];
+        fprintf(out, "JOB");
+        if (strcmp(argv[first], "-") == 0) {
+            data = readAll(stdin, &dataSize);
+            if (!data) {
+                fprintf(stderr, "Error : Cannot read the image from stdin\n");
+                return 1;
+            }
+            fprintf(out, " data:%zu", dataSize);
+        } else if (realpath(argv[first], path)) {
+            sendPath(out, path);
+        } else {
+            perror(argv[first]);
+            return 1;
+        }
+
+        toStdout = strcmp(argv[first + 1], "-") == 0;
+        if (toStdout) {
+            fprintf(out, " data");
+        } else if (absolutePath(argv[first + 1], path, sizeof(path))) {
+            sendPath(out, path);
+        } else {
+            fprintf(stderr, "Error : Output path too long\n");
+            return 1;
+        }
+
+        for (int i = first + 2; i < argc; i++)
+            fprintf(out, " %s", argv[i]);
+        fprintf(out, "\n");
+        if (data)
+            fwrite(data, 1, dataSize, out);
+        free(data);
+    }
+    fflush(out);
+
+    // Read the answer
+    char line[IMGD_LINE_MAX];
+    if (!fgets(line, sizeof(line), in)) {
+        fprintf(stderr, "Error : No answer from the daemon\n");
+        return 1;
+    }
+    if (strncmp(line, "OK ", 3) != 0) {
+        fprintf(stderr, "%s", line);
+        return 1;
+    }
+
+    size_t size = (size_t)strtoull(line + 3, NULL, 10);
+    char buffer[65536];
+    while (size > 0) {
+        size_t n = fread(buffer, 1, size < sizeof(buffer) ? size : sizeof(buffer), in);
+        if (n == 0) {
+            fprintf(stderr, "Error : Truncated answer\n");
+            return 1;
+        }
+        if (toStdout)
+            fwrite(buffer, 1, n, stdout);
+        size -= n;
+    }
+
+    fclose(in);
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,393 @@
+/**
+ * @file imgd_server.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Image daemon: runs operation chains sent over a Unix domain socket
+ *
+ * Usage: imgd [-s socket] [-m cache_megabytes] [-r result_dir] [-R result_megabytes] [-H]
+ *
+ * The daemon keeps decoded images in an LRU cache, so repeated jobs on the
+ * same files skip loading entirely. With -r, job results are also kept on
+ * disk (see resultcache.h), so a repeated job skips processing as well.
+ * -H backs large image buffers with transparent huge pages (see bufpool.h).
+ *
+ * Connections are served one at a time; each one may send any number of
+ * requests (see imgd.h for the protocol).
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "imgd.h"
+#include "imgcache.h"
+#include "netpbm.h"
+#include "opchain.h"
+#include "qoi.h"
+#include "resultcache.h"
+#include "scratch.h"
+#include "bufpool.h"
+
+#define IMGD_MAX_WORDS  (OPCHAIN_MAX_OPS + 3)
+
+// Set by SHUTDOWN
+static int running = 1;
+
+// Disk cache of job results, NULL unless enabled with -r
+static t_result_cache *results = NULL;
+
+// ========================================
+// ANSWERS
+// ========================================
+
+
+static void answerError(FILE *out, const char *message)
+{
+    fprintf(out, "ERR %s\n", message);
+    fflush(out);
+}
+
+
+static void answerData(FILE *out, const char *data, size_t size)
+{
+    fprintf(out, "OK %zu\n", size);
+    if (size > 0)
+        fwrite(data, 1, size, out);
+    fflush(out);
+}
+
+// ========================================
+// JOBS
+// ========================================
+
+
+/**
+ * Decode size bytes of PGM/PPM read from the connection.
+ * Returns 1 with *gray or *color set, 0 on failure.
+ */
+static int readInlineImage(FILE *in, size_t size, t_bmp8 **gray, t_bmp24 **color)
+{
+    char *data = malloc(size ? size : 1);
+    if (!data || fread(data, 1, size, in) != size) {
+        free(data);
+        return 0;
+    }
+    FILE *stream = fmemopen(data, size, "rb");
+    if (stream) {
+        int kind = (getc(stream), getc(stream));
+        rewind(stream);
+        if (kind == '5') *gray = bmp8_loadPGM(stream);
+        else *color = bmp24_loadPPM(stream);
+        fclose(stream);
+    }
+    free(data);
+    return *gray || *color;
+}
+
+
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+
+// Decode a percent-encoded path in place (see imgd.h); 0 if it is malformed
+static int decodePath(char *path)
+{
+    char *to = path;
+    for (const char *from = path; *from; from++) {
+        if (*from != '%') {
+            *to++ = *from;
+            continue;
+        }
+        int high = hexDigit(from[1]);
+        int low = high < 0 ? -1 : hexDigit(from[2]);
+        if (low < 0 || (high == 0 && low == 0))
+            return 0;
+        *to++ = (char)(high * 16 + low);
+        from += 2;
+    }
+    *to = '\0';
+    return to != path;
+}
+
+
+// Save to a file of the server, the format being chosen by the extension.
+// The file is written under a temporary name and renamed, so a failed save
+// leaves an existing destination untouched
+static int saveToPath(const char *path, t_bmp8 *gray, t_bmp24 *color)
+{
+    const char *dot = strrchr(path, '.');
+    const char *ext = dot ? dot + 1 : "";
+    char temp[PATH_MAX];
+    if (snprintf(temp, sizeof(temp), "%s.tmp", path) >= (int)sizeof(temp))
+        return 0;
+
+    int ok;
+    if (strcmp(ext, "pgm") == 0 || strcmp(ext, "ppm") == 0 || strcmp(ext, "pnm") == 0) {
+        FILE *file = fopen(temp, "wb");
+        if (!file) return 0;
+        ok = gray ? bmp8_savePGM(file, gray) : bmp24_savePPM(file, color);
+        ok = fclose(file) == 0 && ok;
+    } else {
+        // The savers only print their errors: check that the file was written
+        unlink(temp);
+        if (strcmp(ext, "qoi") == 0) {
+            if (gray) bmp8_saveQOI(temp, gray);
+            else bmp24_saveQOI(color, temp);
+        } else {
+            if (gray) bmp8_saveImage(temp, gray);
+            else bmp24_saveImage(color, temp);
+        }
+        ok = access(temp, F_OK) == 0;
+    }
+
+    if (ok && rename(temp, path) == 0)
+        return 1;
+    unlink(temp);
+    return 0;
+}
+
+
+static void runJob(FILE *in, FILE *out, t_image_cache *cache, int argc, char **argv)
+{
+    if (argc < 2) {
+        answerError(out, "JOB expects a source and a destination");
+        return;
+    }
+    char *source = argv[0];
+    char *destination = argv[1];
+    int destinationOk = strncmp(destination, "path:", 5) != 0 || decodePath(destination + 5);
+    if (strncmp(source, "path:", 5) == 0 && !decodePath(source + 5)) {
+        // Not data:<size>, so nothing follows the line
+        answerError(out, "malformed source path");
+        return;
+    }
+
+    // Parse everything before reading inline data, but the data must still
+    // be consumed to keep the connection in sync
+    t_opchain chain;
+    int chainOk = opchain_parse(&chain, argc - 2, argv + 2);
+
+    t_bmp8 *srcGray = NULL;
+    t_bmp24 *srcColor = NULL;
+    int ownedSource = 0;
+    if (strncmp(source, "data:", 5) == 0) {
+        char *end;
+        unsigned long long size = strtoull(source + 5, &end, 10);
+        if (*end != '\0' || !readInlineImage(in, (size_t)size, &srcGray, &srcColor)) {
+            answerError(out, "cannot read the inline image");
+            return;
+        }
+        ownedSource = 1;
+    } else if (strncmp(source, "path:", 5) == 0) {
+        const t_cache_entry *entry = chainOk ? imgcache_get(cache, source + 5) : NULL;
+        if (entry) {
+            srcGray = entry->bmp8;
+            srcColor = entry->bmp24;
+        }
+        if (chainOk && !srcGray && !srcColor) {
+            answerError(out, "cannot load the source image");
+            return;
+        }
+    } else {
+        answerError(out, "source must be path:<file> or data:<size>");
+        return;
+    }
+
+    // The result is a new image: cached images stay untouched for the next jobs
+    t_bmp8 *gray = NULL;
+    t_bmp24 *color = NULL;
+    if (chainOk && results) {
+        if (srcGray) gray = rcache_run8(results, &chain, srcGray);
+        else color = rcache_run24(results, &chain, srcColor);
+    } else if (chainOk) {
+        if (srcGray) gray = ownedSource ? srcGray : bmp8_copy(srcGray);
+        else color = ownedSource ? srcColor : bmp24_copy(srcColor);
+        if (gray && !opchain_apply8(&chain, gray)) {
+            bmp8_freeImage(gray);
+            gray = NULL;
+        } else if (color && !opchain_apply24(&chain, color)) {
+            bmp24_free(color);
+            color = NULL;
+        }
+        if (ownedSource) srcGray = NULL, srcColor = NULL;
+    }
+    if (ownedSource) {
+        if (srcGray) bmp8_freeImage(srcGray);
+        if (srcColor) bmp24_free(srcColor);
+    }
+
+    if (!gray && !color) {
+        answerError(out, "invalid operation chain for this image");
+    } else if (strcmp(destination, "data") == 0) {
+        char *data = NULL;
+        size_t size = 0;
+        FILE *stream = open_memstream(&data, &size);
+        int ok = stream && (gray ? bmp8_savePGM(stream, gray) : bmp24_savePPM(stream, color));
+        if (stream) fclose(stream);
+        if (ok) answerData(out, data, size);
+        else answerError(out, "cannot encode the result");
+        free(data);
+    } else if (strncmp(destination, "path:", 5) == 0) {
+        if (!destinationOk) answerError(out, "malformed destination path");
+        else if (saveToPath(destination + 5, gray, color)) answerData(out, NULL, 0);
+        else answerError(out, "cannot write the destination");
+    } else {
+        answerError(out, "destination must be path:<file> or data");
+    }
+
+    if (gray) bmp8_freeImage(gray);
+    if (color) bmp24_free(color);
+}
+
+
+static void runStats(FILE *out, const t_image_cache *cache)
+{
+    char text[512];
+    int length = snprintf(text, sizeof(text),
+                          "hits=%lu misses=%lu images=%d bytes=%zu capacity=%zu\n",
+                          cache->hits, cache->misses, cache->count, cache->bytes, cache->capacity);
+    if (results)
+        length += snprintf(text + length, sizeof(text) - length, "result_hits=%lu result_misses=%lu\n",
+                           results->hits, results->misses);
+    t_scratch_stats scratch = scratch_getStats();
+    length += snprintf(text + length, sizeof(text) - length, "scratch_reserved=%zu scratch_high=%zu\n",
+                       scratch.reserved, scratch.highWater);
+    t_pool_stats pool = pool_getStats();
+    length += snprintf(text + length, sizeof(text) - length, "pool_in_use=%zu pool_cached=%zu pool_hits=%lu pool_misses=%lu pool_huge=%lu\n",
+                       pool.inUse, pool.cached, pool.hits, pool.misses, pool.huge);
+    answerData(out, text, (size_t)length);
+}
+
+// ========================================
+// CONNECTIONS
+// ========================================
+
+
+static void serveConnection(int fd, t_image_cache *cache)
+{
+    // Separate streams for each direction of the socket
+    FILE *in = fdopen(dup(fd), "rb");
+    FILE *out = fdopen(fd, "wb");
+    if (!in || !out) {
+        if (in) fclose(in);
+        if (out) fclose(out);
+        else close(fd);
+        return;
+    }
+
+    char line[IMGD_LINE_MAX];
+    while (running && fgets(line, sizeof(line), in)) {
+        if (!strchr(line, '\n')) {
+            answerError(out, "request line too long");
+            break;
+        }
+
+        char *words[IMGD_MAX_WORDS];
+        int count = 0;
+        char *save;
+        for (char *word = strtok_r(line, " \r\n", &save); word; word = strtok_r(NULL, " \r\n", &save)) {
+            if (count == IMGD_MAX_WORDS) {
+                count = -1;
+                break;
+            }
+            words[count++] = word;
+        }
+        if (count < 0) {
+            answerError(out, "too many operations");
+            break;   // Inline data may follow: the connection is out of sync
+        }
+        if (count == 0)
+            continue;
+
+        if (strcmp(words[0], "JOB") == 0) {
+            runJob(in, out, cache, count - 1, words + 1);
+        } else if (strcmp(words[0], "STATS") == 0) {
+            runStats(out, cache);
+        } else if (strcmp(words[0], "SHUTDOWN") == 0) {
+            answerData(out, NULL, 0);
+            running = 0;
+        } else {
+            answerError(out, "unknown request");
+        }
+    }
+    fclose(in);
+    fclose(out);
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char *socketPath = IMGD_SOCKET_PATH;
+    size_t capacity = (size_t)IMGD_CACHE_MB << 20;
+    const char *resultDir = NULL;
+    unsigned long long resultCapacity = (unsigned long long)IMGD_RESULT_MB << 20;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            capacity = (size_t)strtoull(argv[++i], NULL, 10) << 20;
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            resultDir = argv[++i];
+        } else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc) {
+            resultCapacity = strtoull(argv[++i], NULL, 10) << 20;
+        } else if (strcmp(argv[i], "-H") == 0) {
+            pool_setHugePages(1);
+        } else {
+            fprintf(stderr, "Usage: %s [-s socket] [-m cache_megabytes] [-r result_dir] [-R result_megabytes] [-H]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    struct sockaddr_un address = {0};
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Error : Socket path too long\n");
+        return 1;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    // A client that disconnects early must not kill the daemon
+    signal(SIGPIPE, SIG_IGN);
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath);   // Left behind by a previous run
+    if (server < 0 || bind(server, (struct sockaddr *)&address, sizeof(address)) != 0
+        || listen(server, 16) != 0) {
+        perror("Error : Cannot listen on the socket");
+        return 1;
+    }
+
+    t_image_cache *cache = imgcache_create(capacity);
+    if (!cache) return 1;
+    if (resultDir) {
+        results = rcache_open(resultDir, resultCapacity);
+        if (!results) return 1;
+        rcache_trim(results);   // The capacity may be lower than last time
+    }
+    printf("Listening on %s (cache: %zu MiB)\n", socketPath, capacity >> 20);
+    fflush(stdout);
+
+    while (running) {
+        int client = accept(server, NULL, NULL);
+        if (client >= 0)
+            serveConnection(client, cache);
+    }
+
+    close(server);
+    unlink(socketPath);
+    imgcache_free(cache);
+    if (results) rcache_close(results);
+    printf("Daemon stopped\n");
+    return 0;
+}
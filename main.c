@@ -2,9 +2,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include <locale.h>
+#ifdef _WIN32
 #include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#endif
 #include "bmp8.h"
 #include "bmp24.h"
+#include "opchain.h"
+#include "imageview.h"
+#include "undo.h"
+#include "bufpool.h"
 #define PATH "..//"
 
 
@@ -20,13 +28,24 @@ void handleBMP8();
 void handleBMP24();
 void applyFiltersBMP8(t_bmp8* img);
 void applyFiltersBMP24(t_bmp24* img);
+void resetHistoryBMP8();
+void resetHistoryBMP24();
+void recordBMP8(const char* label);
+void recordBMP24(const char* label);
+void undoBMP8();
+void undoBMP24();
 void clearScreen();
 void pauseScreen();
+int runPipe(int argc, char *argv[]);
 
 // Global variables for the loaded images
 t_bmp8* imageBMP8 = NULL;
 t_bmp24* imageBMP24 = NULL;
 
+// Undo histories of the loaded images
+t_undo_history* historyBMP8 = NULL;
+t_undo_history* historyBMP24 = NULL;
+
 // Function to clear the screen
 void clearScreen() {
 #ifdef _WIN32
@@ -43,6 +62,66 @@ void pauseScreen() {
     while (getchar() != '\n'); // Vider le buffer
 }
 
+// Start the undo history of a newly loaded 8-bit image
+void resetHistoryBMP8() {
+    undo_free(historyBMP8);
+    historyBMP8 = NULL;
+    if (imageBMP8) {
+        t_image_view view = view_fromBmp8(imageBMP8);
+        historyBMP8 = undo_create(&view, UNDO_DEFAULT_DEPTH);
+    }
+}
+
+// Start the undo history of a newly loaded 24-bit image
+void resetHistoryBMP24() {
+    undo_free(historyBMP24);
+    historyBMP24 = NULL;
+    if (imageBMP24) {
+        t_image_view view = view_fromBmp24(imageBMP24);
+        historyBMP24 = undo_create(&view, UNDO_DEFAULT_DEPTH);
+    }
+}
+
+// Record the tiles changed by the last operation on the 8-bit image
+void recordBMP8(const char* label) {
+    if (imageBMP8 && historyBMP8) {
+        t_image_view view = view_fromBmp8(imageBMP8);
+        undo_commit(historyBMP8, &view, label);
+    }
+}
+
+// Record the tiles changed by the last operation on the 24-bit image
+void recordBMP24(const char* label) {
+    if (imageBMP24 && historyBMP24) {
+        t_image_view view = view_fromBmp24(imageBMP24);
+        undo_commit(historyBMP24, &view, label);
+    }
+}
+
+// Undo the last operation on the 8-bit image
+void undoBMP8() {
+    const char* label = historyBMP8 ? undo_lastLabel(historyBMP8) : NULL;
+    if (!imageBMP8 || !label) {
+        printf("Nothing to undo!\n");
+        return;
+    }
+    printf("%s undone!\n", label);
+    t_image_view view = view_fromBmp8(imageBMP8);
+    undo_revert(historyBMP8, &view);
+}
+
+// Undo the last operation on the 24-bit image
+void undoBMP24() {
+    const char* label = historyBMP24 ? undo_lastLabel(historyBMP24) : NULL;
+    if (!imageBMP24 || !label) {
+        printf("Nothing to undo!\n");
+        return;
+    }
+    printf("%s undone!\n", label);
+    t_image_view view = view_fromBmp24(imageBMP24);
+    undo_revert(historyBMP24, &view);
+}
+
 // Main menu
 void displayMainMenu() {
     printf("*========================================*\n");
@@ -71,6 +150,7 @@ void displayBMP8Menu() {
     printf("|  9. Apply filters                      |\n");
     printf("| 10. Histogram equalization             |\n");
     printf("| 11. Compute histogram                  |\n");
+    printf("| 12. Undo                               |\n");
     printf("|  0. Back to main menu                  |\n");
     printf("*========================================*\n");
     printf("Your choice: ");
@@ -91,6 +171,7 @@ void displayBMP24Menu() {
     printf("|  8. Flip vertically                    |\n");
     printf("|  9. Apply filters                      |\n");
     printf("| 10. Histogram equalization             |\n");
+    printf("| 11. Undo                               |\n");
     printf("|  0. Back to main menu                  |\n");
     printf("*========================================*\n");
     printf("Your choice: ");
@@ -162,6 +243,7 @@ void handleBMP8() {
                     bmp8_freeImage(imageBMP8);
                 }
                 imageBMP8 = bmp8_loadImage(path);
+                resetHistoryBMP8();
 
                 if (imageBMP8) {
                     printf("Image successfully loaded!\n");
@@ -199,6 +281,7 @@ void handleBMP8() {
                     printf("No image loaded!\n");
                 } else {
                     bmp8_negative(imageBMP8);
+                    recordBMP8("Negative");
                     printf("Negative applied successfully!\n");
                 }
                 pauseScreen();
@@ -213,6 +296,7 @@ void handleBMP8() {
                 printf("Brightness value (-255 to 255): ");
                 scanf("%d", &valeur);
                 bmp8_brightness(imageBMP8, valeur);
+                recordBMP8("Brightness");
                 printf("Brightness adjusted by %d units!\n", valeur);
                 pauseScreen();
                 break;
@@ -226,6 +310,7 @@ void handleBMP8() {
                 printf("Threshold value (0-255): ");
                 scanf("%d", &valeur);
                 bmp8_threshold(imageBMP8, valeur);
+                recordBMP8("Threshold");
                 printf("Threshold applied with value %d!\n", valeur);
                 pauseScreen();
                 break;
@@ -237,6 +322,7 @@ void handleBMP8() {
                     break;
                 }
                 bmp8_horizontalFlip(imageBMP8);
+                recordBMP8("Horizontal flip");
                 printf("Horizontal Flip applied");
                 pauseScreen();
                 break;
@@ -248,6 +334,7 @@ void handleBMP8() {
                     break;
                 }
                 bmp8_verticalFlip(imageBMP8);
+                recordBMP8("Vertical flip");
                 printf("Vertical Flip applied");
                 pauseScreen();
                 break;
@@ -265,6 +352,7 @@ void handleBMP8() {
                     printf("No image loaded!\n");
                 } else {
                     bmp8_equalize(imageBMP8);
+                    recordBMP8("Histogram equalization");
                     printf("Histogram equalization applied!\n");
                 }
                 pauseScreen();
@@ -274,16 +362,21 @@ void handleBMP8() {
                 if (!imageBMP8) {
                     printf("No image loaded!\n");
                 } else {
-                    unsigned int* hist = bmp8_computeHistogram(imageBMP8);
+                    size_t* hist = bmp8_computeHistogram(imageBMP8);
                     printf("Histogram calculated. Here are the first 10 values:\n");
                     for (int i = 0; i < 10; i++) {
-                        printf("Niveau %d: %u pixels\n", i, hist[i]);
+                        printf("Niveau %d: %llu pixels\n", i, (unsigned long long)hist[i]);
                     }
                     free(hist);
                 }
                 pauseScreen();
                 break;
 
+            case 12: // Undo
+                undoBMP8();
+                pauseScreen();
+                break;
+
             case 0:
                 break;
 
@@ -314,6 +407,7 @@ void applyFiltersBMP8(t_bmp8* img) {
                 }
                 bmp8_applyFilter(img, kernel, 3);
                 freeKernel(kernel, 3);
+                recordBMP8("Box blur");
                 printf("Box blur applied!\n");
                 pauseScreen();
                 break;
@@ -330,6 +424,7 @@ void applyFiltersBMP8(t_bmp8* img) {
                 }
                 bmp8_applyFilter(img, kernel, 3);
                 freeKernel(kernel, 3);
+                recordBMP8("Gaussian blur");
                 printf("Gaussian blur applied!\n");
                 pauseScreen();
                 break;
@@ -344,6 +439,7 @@ void applyFiltersBMP8(t_bmp8* img) {
                 }
                 bmp8_applyFilter(img, kernel, 3);
                 freeKernel(kernel, 3);
+                recordBMP8("Sharpen");
                 printf("Sharpening applied!\n");
                 pauseScreen();
                 break;
@@ -358,6 +454,7 @@ void applyFiltersBMP8(t_bmp8* img) {
                 }
                 bmp8_applyFilter(img, kernel, 3);
                 freeKernel(kernel, 3);
+                recordBMP8("Emboss");
                 printf("Emboss effect applied!\n");
                 pauseScreen();
                 break;
@@ -372,6 +469,7 @@ void applyFiltersBMP8(t_bmp8* img) {
                 }
                 bmp8_applyFilter(img, kernel, 3);
                 freeKernel(kernel, 3);
+                recordBMP8("Outline");
                 printf("Outline detection applied!\n");
                 pauseScreen();
                 break;
@@ -416,6 +514,7 @@ void handleBMP24() {
                     bmp24_free(imageBMP24);
                 }
                 imageBMP24 = bmp24_loadImage(path);
+                resetHistoryBMP24();
 
                 if (imageBMP24) {
                     printf("Image loaded successfully!\n");
@@ -453,6 +552,7 @@ void handleBMP24() {
                     printf("No image loaded!\n");
                 } else {
                     bmp24_negative(imageBMP24);
+                    recordBMP24("Negative");
                     printf("Negative applied successfully!\n");
                 }
                 pauseScreen();
@@ -463,6 +563,7 @@ void handleBMP24() {
                     printf("No image loaded!\n");
                 } else {
                     bmp24_grayscale(imageBMP24);
+                    recordBMP24("Grayscale");
                     printf("Converted to grayscale successfully!\n");
                 }
                 pauseScreen();
@@ -477,6 +578,7 @@ void handleBMP24() {
                 printf("Brightness value (-255 to 255): ");
                 scanf("%d", &valeur);
                 bmp24_brightness(imageBMP24, valeur);
+                recordBMP24("Brightness");
                 printf("Brightness adjusted by %d units!\n", valeur);
                 pauseScreen();
                 break;
@@ -488,6 +590,7 @@ void handleBMP24() {
                     break;
                 }
                 bmp24_horizontalFlip(imageBMP24);
+                recordBMP24("Horizontal flip");
                 printf("Horizontal flip applied successfully");
                 pauseScreen();
                 break;
@@ -499,6 +602,7 @@ void handleBMP24() {
                 break;
             }
             bmp24_verticalFlip(imageBMP24);
+            recordBMP24("Vertical flip");
             printf("Vertical flip applied successfully");
             pauseScreen();
             break;
@@ -518,11 +622,17 @@ void handleBMP24() {
                     printf("No image loaded!\n");
                 } else {
                     bmp24_equalize(imageBMP24);
+                    recordBMP24("Histogram equalization");
                     printf("Histogram equalization applied!\n");
                 }
                 pauseScreen();
                 break;
 
+            case 11: // Undo
+                undoBMP24();
+                pauseScreen();
+                break;
+
             case 0:
                 break;
 
@@ -545,53 +655,62 @@ void applyFiltersBMP24(t_bmp24* img) {
         switch(choix) {
             case 1: // Box Blur
                 bmp24_boxBlur(img);
+                recordBMP24("Box blur");
                 printf("Box blur applied!\n");
                 pauseScreen();
                 break;
 
             case 2: // Gaussian Blur
                 bmp24_gaussianBlur(img);
+                recordBMP24("Gaussian blur");
                 printf("Gaussian blur applied!\n");
                 pauseScreen();
                 break;
 
             case 3: // Sharpen
                 bmp24_sharpen(img);
+                recordBMP24("Sharpen");
                 printf("Sharpening applied!\n");
                 pauseScreen();
                 break;
 
             case 4: // Emboss
                 bmp24_emboss(img);
+                recordBMP24("Emboss");
                 printf("Emboss effect applied!\n");
                 pauseScreen();
                 break;
 
             case 5: // Outline
                 bmp24_outline(img);
+                recordBMP24("Outline");
                 printf("Outline detection applied!\n");
                 pauseScreen();
                 break;
 
             case 6: // Sepia tone
                 bmp24_sepia(img);
+                recordBMP24("Sepia");
                 printf("Sepia tone effect applied!\n");
                 pauseScreen();
                 break;
             case 7:
                 bmp24_sobelX(img);
+                recordBMP24("Sobel X");
                 printf("SobelX applied!\n");
                 pauseScreen();
                 break;
 
             case 8 :
                 bmp24_sobelY(img);
+                recordBMP24("Sobel Y");
                 printf("SobelY applied!\n");
                 pauseScreen();
                 break;
 
             case 9:
                 bmp24_motionBlur(img);
+                recordBMP24("Motion blur");
                 printf("Motion blur applied!\n");
                 pauseScreen();
                 break;
@@ -606,9 +725,42 @@ void applyFiltersBMP24(t_bmp24* img) {
     } while (choix != 0);
 }
 
+// Pipe mode: read a PGM/PPM image on stdin, apply the operations given as
+// arguments and write the result on stdout
+int runPipe(int argc, char *argv[]) {
+    t_opchain chain;
+    if (!opchain_parse(&chain, argc, argv)) {
+        fprintf(stderr, "Usage: Image_Processing_C [-H] <operation>... < input.pgm > output.pgm\n");
+        opchain_printUsage(stderr);
+        return 1;
+    }
+
+#ifdef _WIN32
+    // Image data must not go through newline translation
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    return opchain_runPipe(stdin, stdout, &chain) ? 0 : 1;
+}
+
 // Main function
-int main() {
+int main(int argc, char *argv[]) {
+    // -H backs large image buffers with huge pages, in both modes
+    int first = 1;
+    if (argc > 1 && strcmp(argv[1], "-H") == 0) {
+        pool_setHugePages(1);
+        first = 2;
+    }
+
+    // With arguments the program is a filter in a pipeline, not a menu
+    if (argc > first) {
+        return runPipe(argc - first, argv + first);
+    }
+
+#ifdef _WIN32
     SetConsoleOutputCP(CP_UTF8);
+#endif
     setlocale(LC_ALL, "");
     int choix;
 
@@ -645,6 +797,8 @@ int main() {
     if (imageBMP24) {
         bmp24_free(imageBMP24);
     }
+    undo_free(historyBMP8);
+    undo_free(historyBMP24);
 
     printf("Program completed successfully!\n");
     return 0;
@@ -0,0 +1,266 @@
+/**
+ * @file morph.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Morphological operations on 8-bit image views
+ *
+ */
+
+#include "morph.h"
+#include "scratch.h"
+#include "bufpool.h"
+#include <stdio.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ========================================
+// VAN HERK / GIL-WERMAN
+// ========================================
+
+
+// dst = min(a, b), or max(a, b) with dilate, byte by byte
+static void morph_combine(uint8_t *dst, const uint8_t *a, const uint8_t *b, int bytes, int dilate)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    if (dilate) {
+        for (; i + 16 <= bytes; i += 16)
+            _mm_storeu_si128((__m128i *)(dst + i), _mm_max_epu8(_mm_loadu_si128((const __m128i *)(a + i)),
+                                                                 _mm_loadu_si128((const __m128i *)(b + i))));
+    } else {
+        for (; i + 16 <= bytes; i += 16)
+            _mm_storeu_si128((__m128i *)(dst + i), _mm_min_epu8(_mm_loadu_si128((const __m128i *)(a + i)),
+                                                                 _mm_loadu_si128((const __m128i *)(b + i))));
+    }
+#endif
+    for (; i < bytes; i++)
+        dst[i] = (a[i] < b[i]) == !dilate ? a[i] : b[i];
+}
+
+
+// Element x of a line, or the identity outside of it
+static const uint8_t *morph_element(const uint8_t *line, ptrdiff_t step, int count, int x,
+                                    const uint8_t *identity)
+{
+    return x >= 0 && x < count ? line + x * step : identity;
+}
+
+
+// Output element x = minimum (maximum with dilate) of input elements
+// x - before to x - before + size - 1, for the count elements of a line.
+// Elements are vectors of bytes, step bytes apart; each window is the
+// suffix of one block of size elements and the prefix of the next one
+static void morph_line(const uint8_t *in, ptrdiff_t inStep, uint8_t *out, ptrdiff_t outStep,
+                       int count, int bytes, int size, int before, int dilate,
+                       uint8_t *suffixes, uint8_t *prefix, const uint8_t *identity)
+{
+    for (int start = 0; start < count; start += size) {
+        // suffixes[j] covers the block from element start + j to its end
+        int first = start - before;
+        uint8_t *suffix = suffixes + (size_t)(size - 1) * bytes;
+        memcpy(suffix, morph_element(in, inStep, count, first + size - 1, identity), bytes);
+        for (int j = size - 2; j >= 0; j--, suffix -= bytes)
+            morph_combine(suffix - bytes, suffix, morph_element(in, inStep, count, first + j, identity),
+                          bytes, dilate);
+
+        // The prefix of the next block grows by one element per output
+        int end = count - start < size ? count - start : size;
+        memcpy(out + start * outStep, suffixes, bytes);
+        for (int j = 1; j < end; j++) {
+            const uint8_t *element = morph_element(in, inStep, count, first + size + j - 1, identity);
+            if (j == 1)
+                memcpy(prefix, element, bytes);
+            else
+                morph_combine(prefix, prefix, element, bytes, dilate);
+            morph_combine(out + (start + j) * outStep, suffixes + (size_t)j * bytes, prefix, bytes, dilate);
+        }
+    }
+}
+
+// ========================================
+// PASSES
+// ========================================
+
+
+// Columns x0 to x1 - 1 of src into dst, element of the given height
+static int morph_stripe(const t_image_view *src, t_image_view *dst, unsigned int x0, unsigned int x1,
+                        int size, int dilate)
+{
+    int bytes = (int)(x1 - x0);
+    size_t mark = scratch_mark();
+    uint8_t *suffixes = scratch_alloc((size_t)(size + 2) * bytes);
+    if (!suffixes) {
+        scratch_release(mark);
+        return 0;
+    }
+    uint8_t *prefix = suffixes + (size_t)size * bytes;
+    uint8_t *identity = prefix + bytes;
+    memset(identity, dilate ? 0 : 255, bytes);
+
+    morph_line(view_row(src, 0) + x0, src->stride, view_row(dst, 0) + x0, dst->stride,
+               (int)src->height, bytes, size, dilate ? size / 2 : (size - 1) / 2, dilate,
+               suffixes, prefix, identity);
+    scratch_release(mark);
+    return 1;
+}
+
+
+// 16 x 16 bytes: dst[c][r] = src[r][c]
+static void morph_transpose(const uint8_t *const *src, uint8_t *const *dst)
+{
+#if defined(__SSE2__)
+    // Four rounds of interleaving transpose the block when the rows come
+    // in bit-reversed order
+    static const int order[16] = {0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15};
+    __m128i a[16], b[16];
+    for (int r = 0; r < 16; r++)
+        a[r] = _mm_loadu_si128((const __m128i *)src[order[r]]);
+    for (int i = 0; i < 8; i++) {
+        b[2 * i] = _mm_unpacklo_epi8(a[i], a[i + 8]);
+        b[2 * i + 1] = _mm_unpackhi_epi8(a[i], a[i + 8]);
+    }
+    for (int i = 0; i < 8; i++) {
+        a[2 * i] = _mm_unpacklo_epi16(b[i], b[i + 8]);
+        a[2 * i + 1] = _mm_unpackhi_epi16(b[i], b[i + 8]);
+    }
+    for (int i = 0; i < 8; i++) {
+        b[2 * i] = _mm_unpacklo_epi32(a[i], a[i + 8]);
+        b[2 * i + 1] = _mm_unpackhi_epi32(a[i], a[i + 8]);
+    }
+    for (int i = 0; i < 8; i++) {
+        _mm_storeu_si128((__m128i *)dst[2 * i], _mm_unpacklo_epi64(b[i], b[i + 8]));
+        _mm_storeu_si128((__m128i *)dst[2 * i + 1], _mm_unpackhi_epi64(b[i], b[i + 8]));
+    }
+#else
+    for (int r = 0; r < 16; r++)
+        for (int c = 0; c < 16; c++)
+            dst[c][r] = src[r][c];
+#endif
+}
+
+
+// Rows y0 to y0 + count - 1 of view, in place, element of the given width.
+// Column x of the band becomes the 16 bytes of lines[x]
+static int morph_band(t_image_view *view, unsigned int y0, int count, int size, int dilate)
+{
+    int width = (int)view->width;
+    size_t mark = scratch_mark();
+    uint8_t *lines = scratch_alloc(((size_t)2 * width + size + 3) * MORPH_BAND_ROWS);
+    if (!lines) {
+        scratch_release(mark);
+        return 0;
+    }
+    uint8_t *results = lines + (size_t)width * MORPH_BAND_ROWS;
+    uint8_t *suffixes = results + (size_t)width * MORPH_BAND_ROWS;
+    uint8_t *prefix = suffixes + (size_t)size * MORPH_BAND_ROWS;
+    uint8_t *identity = prefix + MORPH_BAND_ROWS;
+    uint8_t *unused = identity + MORPH_BAND_ROWS;      // Written instead of missing rows
+    memset(identity, dilate ? 0 : 255, MORPH_BAND_ROWS);
+
+    // Missing rows of the last band repeat its last row when read
+    uint8_t *rows[MORPH_BAND_ROWS];
+    for (int r = 0; r < MORPH_BAND_ROWS; r++)
+        rows[r] = view_row(view, y0 + (unsigned int)(r < count ? r : count - 1));
+
+    const uint8_t *from[MORPH_BAND_ROWS];
+    uint8_t *to[MORPH_BAND_ROWS];
+    int x = 0;
+    for (; x + MORPH_BAND_ROWS <= width; x += MORPH_BAND_ROWS) {
+        for (int r = 0; r < MORPH_BAND_ROWS; r++) {
+            from[r] = rows[r] + x;
+            to[r] = lines + (size_t)(x + r) * MORPH_BAND_ROWS;
+        }
+        morph_transpose(from, to);
+    }
+    for (; x < width; x++)
+        for (int r = 0; r < MORPH_BAND_ROWS; r++)
+            lines[(size_t)x * MORPH_BAND_ROWS + r] = rows[r][x];
+
+    morph_line(lines, MORPH_BAND_ROWS, results, MORPH_BAND_ROWS, width, MORPH_BAND_ROWS, size,
+               dilate ? size / 2 : (size - 1) / 2, dilate, suffixes, prefix, identity);
+
+    for (x = 0; x + MORPH_BAND_ROWS <= width; x += MORPH_BAND_ROWS) {
+        for (int r = 0; r < MORPH_BAND_ROWS; r++) {
+            from[r] = results + (size_t)(x + r) * MORPH_BAND_ROWS;
+            to[r] = r < count ? rows[r] + x : unused;
+        }
+        morph_transpose(from, to);
+    }
+    for (; x < width; x++)
+        for (int r = 0; r < count; r++)
+            rows[r][x] = results[(size_t)x * MORPH_BAND_ROWS + r];
+
+    scratch_release(mark);
+    return 1;
+}
+
+
+// Erosion or dilation of src into dst: vertical pass from src to dst, then
+// horizontal pass in place in dst
+static int morph_pass(const t_image_view *src, t_image_view *dst, unsigned int width,
+                      unsigned int height, int dilate)
+{
+    int failed = 0;
+    int stripes = (int)((src->width + MORPH_STRIPE_COLUMNS - 1) / MORPH_STRIPE_COLUMNS);
+    #pragma omp parallel for schedule(dynamic) reduction(|:failed)
+    for (int stripe = 0; stripe < stripes; stripe++) {
+        unsigned int x0 = (unsigned int)stripe * MORPH_STRIPE_COLUMNS;
+        unsigned int x1 = src->width - x0 < MORPH_STRIPE_COLUMNS ? src->width : x0 + MORPH_STRIPE_COLUMNS;
+        failed |= !morph_stripe(src, dst, x0, x1, (int)height, dilate);
+    }
+    if (failed || width == 1)
+        return !failed;
+
+    int bands = (int)((dst->height + MORPH_BAND_ROWS - 1) / MORPH_BAND_ROWS);
+    #pragma omp parallel for schedule(dynamic) reduction(|:failed)
+    for (int band = 0; band < bands; band++) {
+        unsigned int y0 = (unsigned int)band * MORPH_BAND_ROWS;
+        int count = dst->height - y0 < MORPH_BAND_ROWS ? (int)(dst->height - y0) : MORPH_BAND_ROWS;
+        failed |= !morph_band(dst, y0, count, (int)width, dilate);
+    }
+    return !failed;
+}
+
+// ========================================
+// MORPHOLOGICAL OPERATIONS
+// ========================================
+
+
+int view_morphology(const t_image_view *src, t_image_view *dst, t_morph_op op,
+                    unsigned int width, unsigned int height)
+{
+    if (src->format != VIEW_GRAY8 || dst->format != VIEW_GRAY8 || src->width != dst->width
+        || src->height != dst->height || src->width == 0 || src->height == 0
+        || width == 0 || height == 0 || op > MORPH_BLACKHAT)
+        return 0;
+
+    int dilate = op == MORPH_DILATE || op == MORPH_CLOSE || op == MORPH_BLACKHAT;
+    int ok;
+    if (op == MORPH_ERODE || op == MORPH_DILATE) {
+        ok = morph_pass(src, dst, width, height, dilate);
+    } else {
+        // Opening and closing go through a second image
+        uint8_t *data = pool_alloc((size_t)src->width * src->height);
+        t_image_view between = *src;
+        between.data = data;
+        between.stride = (ptrdiff_t)src->width;
+        ok = data && morph_pass(src, &between, width, height, dilate)
+             && morph_pass(&between, dst, width, height, !dilate);
+        pool_free(data);
+    }
+
+    // Opening never brightens and closing never darkens a pixel
+    if (ok && (op == MORPH_TOPHAT || op == MORPH_BLACKHAT)) {
+        for (unsigned int y = 0; y < src->height; y++) {
+            const uint8_t *image = view_row(src, y);
+            uint8_t *row = view_row(dst, y);
+            for (unsigned int x = 0; x < src->width; x++)
+                row[x] = op == MORPH_TOPHAT ? (uint8_t)(image[x] - row[x]) : (uint8_t)(row[x] - image[x]);
+        }
+    }
+
+    if (!ok)
+        printf("Error: Not enough memory for the morphological operation\n");
+    return ok;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file morph.h
+ * @brief Morphological operations on 8-bit image views
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines erosion, dilation and the operations built on
+ * them, with a rectangular structuring element of any size. They are meant
+ * for cleaning up thresholded documents: opening removes specks smaller
+ * than the element, closing fills holes and gaps, top-hat keeps the small
+ * bright details that opening removes.
+ *
+ * A rectangle is a row of pixels followed by a column of pixels, so each
+ * operation is a vertical pass and a horizontal pass, both computed with
+ * the van Herk / Gil-Werman algorithm:
+ * - The line is cut into blocks of the element size; every window covers
+ *   the end of one block and the start of the next
+ * - The minimum (or maximum) of each block suffix and of each block prefix
+ *   is computed once, and a window is the minimum of one suffix and one
+ *   prefix: three comparisons per pixel whatever the element size
+ * - The vertical pass works on whole rows, 16 pixels at a time with SSE2
+ * - The horizontal pass transposes bands of MORPH_BAND_ROWS rows so that
+ *   each column of the band is one SSE2 register, runs the same algorithm
+ *   along the band and transposes the result back
+ *
+ * Stripes of the vertical pass and bands of the horizontal pass run in
+ * parallel with OpenMP. Pixels beyond the edges are ignored (they count as
+ * white for an erosion and black for a dilation).
+ */
+
+#ifndef MORPH_H
+#define MORPH_H
+
+#include "imageview.h"
+
+/* ============================================================================
+ * MORPHOLOGY CONSTANTS
+ * ============================================================================ */
+
+#define MORPH_BAND_ROWS         16      /**< Rows transposed together (bytes of an SSE2 register) */
+#define MORPH_STRIPE_COLUMNS    256     /**< Columns of a stripe of the vertical pass */
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @enum t_morph_op
+ * @brief Morphological operations
+ */
+typedef enum {
+    MORPH_ERODE,        /**< Minimum over the element: dark areas grow */
+    MORPH_DILATE,       /**< Maximum over the element: bright areas grow */
+    MORPH_OPEN,         /**< Erosion then dilation: removes bright specks */
+    MORPH_CLOSE,        /**< Dilation then erosion: fills dark holes */
+    MORPH_TOPHAT,       /**< Image minus its opening: the bright specks alone */
+    MORPH_BLACKHAT      /**< Closing minus the image: the dark holes alone */
+} t_morph_op;
+
+/* ============================================================================
+ * MORPHOLOGY FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Draw a view through a morphological operation
+ * @param src Source pixels (not modified), VIEW_GRAY8
+ * @param dst Destination of the same size and format, not overlapping src
+ * @param op Operation to apply
+ * @param width Width of the rectangular element, at least 1
+ * @param height Height of the rectangular element, at least 1
+ * @return 1 on success, 0 if the views do not match, are not VIEW_GRAY8,
+ *         the element is empty or memory is missing
+ *
+ * The element is centred on the pixel; when a side is even, erosion reaches
+ * one pixel further towards the bottom right and dilation towards the top
+ * left, so that opening and closing do not shift the image.
+ */
+int view_morphology(const t_image_view *src, t_image_view *dst, t_morph_op op,
+                    unsigned int width, unsigned int height);
+
+#endif //MORPH_H
@@ -0,0 +1,204 @@
+/**
+ * @file netpbm.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Binary PGM and PPM reading and writing on streams
+ *
+ * These functions are used on stdin and stdout in pipe mode, so they never
+ * print on stdout: every message goes to stderr.
+ *
+ */
+
+#include "netpbm.h"
+#include <ctype.h>
+
+// ========================================
+// HEADER FUNCTIONS
+// ========================================
+
+
+/**
+ * Skip whitespace and '#' comments in a header.
+ * Returns the next character (left in the stream), or EOF.
+ */
+static int pnm_skipSpace(FILE *file)
+{
+    int c = getc(file);
+    while (c != EOF) {
+        if (c == '#') {
+            while (c != EOF && c != '\n')
+                c = getc(file);
+        } else if (!isspace(c)) {
+            break;
+        }
+        c = getc(file);
+    }
+    if (c != EOF)
+        ungetc(c, file);
+    return c;
+}
+
+
+static int pnm_readNumber(FILE *file, unsigned int *value)
+{
+    int c = pnm_skipSpace(file);
+    if (c == EOF || !isdigit(c))
+        return 0;
+
+    unsigned long number = 0;
+    while ((c = getc(file)) != EOF && isdigit(c)) {
+        number = number * 10 + (c - '0');
+        if (number > 0xFFFFFFFFul)
+            return 0;
+    }
+    if (c != EOF)
+        ungetc(c, file);
+    *value = (unsigned int)number;
+    return 1;
+}
+
+
+int pnm_readHeader(FILE *file, t_pnm_info *info)
+{
+    int p = getc(file);
+    int kind = getc(file);
+    if (p != 'P' || (kind != '5' && kind != '6')) {
+        fprintf(stderr, "Error : Input is not a binary PGM (P5) or PPM (P6) image\n");
+        return 0;
+    }
+    info->channels = kind == '5' ? 1 : 3;
+
+    if (!pnm_readNumber(file, &info->width) || !pnm_readNumber(file, &info->height)
+        || !pnm_readNumber(file, &info->maxval)) {
+        fprintf(stderr, "Error : Invalid Netpbm header\n");
+        return 0;
+    }
+    if (info->width == 0 || info->height == 0 || info->width > INT32_MAX || info->height > INT32_MAX
+        || info->maxval == 0 || info->maxval > 255) {
+        fprintf(stderr, "Error : Unsupported Netpbm image (%ux%u, maxval %u)\n",
+                info->width, info->height, info->maxval);
+        return 0;
+    }
+
+    // Exactly one whitespace character separates the header from the samples
+    if (!isspace(getc(file))) {
+        fprintf(stderr, "Error : Invalid Netpbm header\n");
+        return 0;
+    }
+    return 1;
+}
+
+
+int pnm_writeHeader(FILE *file, unsigned int width, unsigned int height, int channels)
+{
+    return fprintf(file, "P%c\n%u %u\n255\n", channels == 1 ? '5' : '6', width, height) > 0;
+}
+
+// ========================================
+// ROW FUNCTIONS
+// ========================================
+
+
+int pnm_readRows(FILE *file, const t_pnm_info *info, uint8_t *rows, unsigned int count)
+{
+    size_t size = (size_t)info->width * info->channels * count;
+    if (fread(rows, 1, size, file) != size) {
+        fprintf(stderr, "Error : Netpbm data is truncated\n");
+        return 0;
+    }
+
+    // Stretch samples to the full 0-255 range
+    if (info->maxval != 255) {
+        for (size_t i = 0; i < size; i++) {
+            unsigned int v = rows[i] > info->maxval ? info->maxval : rows[i];
+            rows[i] = (uint8_t)((v * 255 + info->maxval / 2) / info->maxval);
+        }
+    }
+    return 1;
+}
+
+
+int pnm_writeRows(FILE *file, const uint8_t *rows, unsigned int width, int channels, unsigned int count)
+{
+    size_t size = (size_t)width * channels * count;
+    if (fwrite(rows, 1, size, file) != size) {
+        fprintf(stderr, "Error : Writing of the Netpbm data failed\n");
+        return 0;
+    }
+    return 1;
+}
+
+// ========================================
+// IMAGE FUNCTIONS
+// ========================================
+
+
+t_bmp8 * bmp8_loadPGM(FILE *file)
+{
+    t_pnm_info info;
+    if (!pnm_readHeader(file, &info))
+        return NULL;
+    if (info.channels != 1) {
+        fprintf(stderr, "Error : Expected a grayscale (P5) image\n");
+        return NULL;
+    }
+
+    t_bmp8 *img = bmp8_allocate(info.width, info.height);
+    if (!img)
+        return NULL;
+
+    // PGM stores the top row first, 8-bit data starts with the bottom row
+    for (size_t y = img->height; y-- > 0;) {
+        if (!pnm_readRows(file, &info, img->data + y * img->stride, 1)) {
+            bmp8_freeImage(img);
+            return NULL;
+        }
+    }
+    return img;
+}
+
+
+int bmp8_savePGM(FILE *file, t_bmp8 *img)
+{
+    if (!pnm_writeHeader(file, img->width, img->height, 1))
+        return 0;
+    for (size_t y = img->height; y-- > 0;)
+        if (!pnm_writeRows(file, img->data + y * img->stride, img->width, 1, 1))
+            return 0;
+    return fflush(file) == 0;
+}
+
+
+t_bmp24 * bmp24_loadPPM(FILE *file)
+{
+    t_pnm_info info;
+    if (!pnm_readHeader(file, &info))
+        return NULL;
+    if (info.channels != 3) {
+        fprintf(stderr, "Error : Expected a color (P6) image\n");
+        return NULL;
+    }
+
+    t_bmp24 *img = bmp24_allocate(info.width, info.height, DEFAULT_DEPTH);
+    if (!img)
+        return NULL;
+
+    // t_pixel is packed R, G, B: rows are read straight into the image
+    for (int y = 0; y < img->height; y++) {
+        if (!pnm_readRows(file, &info, (uint8_t *)img->data[y], 1)) {
+            bmp24_free(img);
+            return NULL;
+        }
+    }
+    return img;
+}
+
+
+int bmp24_savePPM(FILE *file, t_bmp24 *img)
+{
+    if (!pnm_writeHeader(file, img->width, img->height, 3))
+        return 0;
+    for (int y = 0; y < img->height; y++)
+        if (!pnm_writeRows(file, (const uint8_t *)img->data[y], img->width, 3, 1))
+            return 0;
+    return fflush(file) == 0;
+}
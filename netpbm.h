@@ -0,0 +1,121 @@
+/**
+ * @file netpbm.h
+ * @brief Binary PGM (P5) and PPM (P6) reading and writing on streams
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines readers and writers for the binary Netpbm
+ * formats, working on FILE* streams so they can be used on stdin and stdout:
+ * - P5 (PGM) maps to t_bmp8, P6 (PPM) maps to t_bmp24
+ * - Rows can be read and written a few at a time, so a pipeline only needs
+ *   to hold one strip of the image in memory
+ * - Nothing is printed on stdout; errors go to stderr
+ *
+ * Only 8-bit samples are supported (maxval up to 255). Files with a maxval
+ * below 255 are rescaled to 0-255 on read; files are always written with
+ * maxval 255.
+ */
+
+#ifndef NETPBM_H
+#define NETPBM_H
+
+#include "bmp8.h"
+#include "bmp24.h"
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @struct t_pnm_info
+ * @brief Header of a binary Netpbm image
+ */
+typedef struct {
+    unsigned int width;     /**< Image width in pixels */
+    unsigned int height;    /**< Image height in pixels */
+    int channels;           /**< 1 for P5 (gray), 3 for P6 (RGB) */
+    unsigned int maxval;    /**< Largest sample value (1-255) */
+} t_pnm_info;
+
+/* ============================================================================
+ * STREAMING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Read the header of a P5 or P6 image
+ * @param file Stream positioned at the start of the image
+ * @param info Receives width, height, channels and maxval
+ * @return 1 on success, 0 if the stream does not start with a valid header
+ *
+ * On success the stream is positioned on the first sample.
+ */
+int pnm_readHeader(FILE *file, t_pnm_info *info);
+
+/**
+ * @brief Write the header of a P5 or P6 image (maxval 255)
+ * @param file Output stream
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param channels 1 for P5, 3 for P6
+ * @return 1 on success, 0 on write error
+ */
+int pnm_writeHeader(FILE *file, unsigned int width, unsigned int height, int channels);
+
+/**
+ * @brief Read the next rows of samples, top row first
+ * @param file Stream positioned after the header or previous rows
+ * @param info Header returned by pnm_readHeader
+ * @param rows Destination of count * width * channels bytes
+ * @param count Number of rows to read
+ * @return 1 on success, 0 if the data is truncated
+ */
+int pnm_readRows(FILE *file, const t_pnm_info *info, uint8_t *rows, unsigned int count);
+
+/**
+ * @brief Write rows of samples, top row first
+ * @param file Output stream
+ * @param rows count * width * channels bytes (R, G, B order for P6)
+ * @param width Image width in pixels
+ * @param channels 1 or 3
+ * @param count Number of rows to write
+ * @return 1 on success, 0 on write error
+ */
+int pnm_writeRows(FILE *file, const uint8_t *rows, unsigned int width, int channels, unsigned int count);
+
+/* ============================================================================
+ * IMAGE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Load an 8-bit image from a P5 stream
+ * @param file Input stream
+ * @return Pointer to the loaded image (identity gray palette), or NULL on failure
+ */
+t_bmp8 *bmp8_loadPGM(FILE *file);
+
+/**
+ * @brief Write an 8-bit image as P5
+ * @param file Output stream
+ * @param img Pointer to the image to write
+ * @return 1 on success, 0 on write error
+ *
+ * Pixel values are written as they are; the color table is ignored.
+ */
+int bmp8_savePGM(FILE *file, t_bmp8 *img);
+
+/**
+ * @brief Load a 24-bit image from a P6 stream
+ * @param file Input stream
+ * @return Pointer to the loaded image, or NULL on failure
+ */
+t_bmp24 *bmp24_loadPPM(FILE *file);
+
+/**
+ * @brief Write a 24-bit image as P6
+ * @param file Output stream
+ * @param img Pointer to the image to write
+ * @return 1 on success, 0 on write error
+ */
+int bmp24_savePPM(FILE *file, t_bmp24 *img);
+
+#endif //NETPBM_H
@@ -0,0 +1,622 @@
+/**
+ * @file opchain.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Parsing and application of operation chains
+ *
+ * A chain is first planned: point operations and flips are merged into
+ * remapping passes run on an image view, the other operations are carried
+ * out by the existing bmp8_* and bmp24_* functions. In streaming mode the
+ * plan is run on a strip: a t_bmp8 or t_bmp24 whose data only covers
+ * OPCHAIN_STRIP_ROWS rows of the image.
+ *
+ */
+
+#include "opchain.h"
+#include "netpbm.h"
+#include "scratch.h"
+#include "imageview.h"
+#include "rank.h"
+#include <string.h>
+
+// ========================================
+// OPERATION TABLE
+// ========================================
+
+typedef struct {
+    const char *name;   // Name on the command line
+    int hasValue;       // Takes "=<value>"
+    int minValue;       // Range of the value
+    int maxValue;
+    int rowLocal;       // Each output row only depends on the same input row
+    int gray;           // Available for 8-bit images
+    int color;          // Available for 24-bit images
+} t_op_desc;
+
+static const t_op_desc opchain_ops[OP_COUNT] = {
+    [OP_NEGATIVE]      = {"negative",      0, 0,    0,   1, 1, 1},
+    [OP_BRIGHTNESS]    = {"brightness",    1, -255, 255, 1, 1, 1},
+    [OP_THRESHOLD]     = {"threshold",     1, -255, 255, 1, 1, 0},
+    [OP_GRAYSCALE]     = {"grayscale",     0, 0,    0,   1, 1, 1},
+    [OP_SEPIA]         = {"sepia",         0, 0,    0,   1, 0, 1},
+    [OP_HFLIP]         = {"hflip",         0, 0,    0,   0, 1, 1},
+    [OP_VFLIP]         = {"vflip",         0, 0,    0,   1, 1, 1},
+    [OP_ROT90]         = {"rot90",         0, 0,    0,   0, 1, 1},
+    [OP_ROT180]        = {"rot180",        0, 0,    0,   0, 1, 1},
+    [OP_ROT270]        = {"rot270",        0, 0,    0,   0, 1, 1},
+    [OP_ROTATE]        = {"rotate",        1, -360, 360, 0, 1, 1},
+    [OP_SCALE]         = {"scale",         1, 1,    400, 0, 1, 1},
+    [OP_BOX_BLUR]      = {"box-blur",      0, 0,    0,   0, 1, 1},
+    [OP_GAUSSIAN_BLUR] = {"gaussian-blur", 0, 0,    0,   0, 1, 1},
+    [OP_SHARPEN]       = {"sharpen",       0, 0,    0,   0, 1, 1},
+    [OP_EMBOSS]        = {"emboss",        0, 0,    0,   0, 1, 1},
+    [OP_OUTLINE]       = {"outline",       0, 0,    0,   0, 1, 1},
+    [OP_SOBEL_X]       = {"sobel-x",       0, 0,    0,   0, 1, 1},
+    [OP_SOBEL_Y]       = {"sobel-y",       0, 0,    0,   0, 1, 1},
+    [OP_MOTION_BLUR]   = {"motion-blur",   0, 0,    0,   0, 1, 1},
+    [OP_EQUALIZE]      = {"equalize",      0, 0,    0,   0, 1, 1},
+    [OP_MEDIAN]        = {"median",        1, 1,    RANK_MAX_RADIUS, 0, 1, 1},
+    [OP_ERODE]         = {"erode",         1, 1,    255, 0, 1, 0},
+    [OP_DILATE]        = {"dilate",        1, 1,    255, 0, 1, 0},
+    [OP_OPEN]          = {"open",          1, 1,    255, 0, 1, 0},
+    [OP_CLOSE]         = {"close",         1, 1,    255, 0, 1, 0},
+    [OP_TOPHAT]        = {"tophat",        1, 1,    255, 0, 1, 0},
+    [OP_BLACKHAT]      = {"blackhat",      1, 1,    255, 0, 1, 0},
+};
+
+// 3x3 kernels of the filter operations, same values as the filter menus
+static const float opchain_kernels[OP_MOTION_BLUR - OP_BOX_BLUR + 1][3][3] = {
+    [OP_BOX_BLUR - OP_BOX_BLUR]      = {{1/9.0f, 1/9.0f, 1/9.0f}, {1/9.0f, 1/9.0f, 1/9.0f}, {1/9.0f, 1/9.0f, 1/9.0f}},
+    [OP_GAUSSIAN_BLUR - OP_BOX_BLUR] = {{1/16.0f, 1/8.0f, 1/16.0f}, {1/8.0f, 1/4.0f, 1/8.0f}, {1/16.0f, 1/8.0f, 1/16.0f}},
+    [OP_SHARPEN - OP_BOX_BLUR]       = {{0, -1, 0}, {-1, 5, -1}, {0, -1, 0}},
+    [OP_EMBOSS - OP_BOX_BLUR]        = {{-2, -1, 0}, {-1, 1, 1}, {0, 1, 2}},
+    [OP_OUTLINE - OP_BOX_BLUR]       = {{-1, -1, -1}, {-1, 8, -1}, {-1, -1, -1}},
+    [OP_SOBEL_X - OP_BOX_BLUR]       = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}},
+    [OP_SOBEL_Y - OP_BOX_BLUR]       = {{-1, -2, -1}, {0, 0, 0}, {1, 2, 1}},
+    [OP_MOTION_BLUR - OP_BOX_BLUR]   = {{1/3.0f, 0, 0}, {0, 1/3.0f, 0}, {0, 0, 1/3.0f}},
+};
+
+// ========================================
+// PARSING FUNCTIONS
+// ========================================
+
+
+int opchain_parse(t_opchain *chain, int argc, char **argv)
+{
+    chain->count = 0;
+    for (int i = 0; i < argc; i++) {
+        if (chain->count == OPCHAIN_MAX_OPS) {
+            fprintf(stderr, "Error : More than %d operations\n", OPCHAIN_MAX_OPS);
+            return 0;
+        }
+
+        const char *arg = argv[i];
+        const char *equal = strchr(arg, '=');
+        size_t length = equal ? (size_t)(equal - arg) : strlen(arg);
+
+        int type = 0;
+        while (type < OP_COUNT && (strlen(opchain_ops[type].name) != length
+                                   || strncmp(opchain_ops[type].name, arg, length) != 0))
+            type++;
+        if (type == OP_COUNT) {
+            fprintf(stderr, "Error : Unknown operation '%s'\n", arg);
+            return 0;
+        }
+
+        t_op *op = &chain->ops[chain->count++];
+        op->type = type;
+        op->value = 0;
+        if (opchain_ops[type].hasValue) {
+            char *end;
+            long value = equal ? strtol(equal + 1, &end, 10) : 0;
+            if (!equal || end == equal + 1 || *end != '\0'
+                || value < opchain_ops[type].minValue || value > opchain_ops[type].maxValue) {
+                fprintf(stderr, "Error : '%s' expects %s=<%d..%d>\n", arg, opchain_ops[type].name,
+                        opchain_ops[type].minValue, opchain_ops[type].maxValue);
+                return 0;
+            }
+            op->value = (int)value;
+        } else if (equal) {
+            fprintf(stderr, "Error : '%s' takes no value\n", opchain_ops[type].name);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+int opchain_toString(const t_opchain *chain, char *buffer, size_t size)
+{
+    size_t length = 0;
+    buffer[0] = '\0';
+    for (int i = 0; i < chain->count; i++) {
+        const t_op *op = &chain->ops[i];
+        int n = opchain_ops[op->type].hasValue
+                ? snprintf(buffer + length, size - length, "%s%s=%d", i ? " " : "", opchain_ops[op->type].name, op->value)
+                : snprintf(buffer + length, size - length, "%s%s", i ? " " : "", opchain_ops[op->type].name);
+        if (n < 0 || (size_t)n >= size - length)
+            return 0;
+        length += n;
+    }
+    return 1;
+}
+
+
+void opchain_printUsage(FILE *file)
+{
+    fprintf(file, "Operations:");
+    for (int type = 0; type < OP_COUNT; type++)
+        fprintf(file, " %s%s", opchain_ops[type].name, opchain_ops[type].hasValue ? "=<value>" : "");
+    fprintf(file, "\n");
+}
+
+
+// Side of an image after scale=<percent>, at least one pixel
+static unsigned int opchain_scaledSize(unsigned int size, int percent)
+{
+    unsigned long long scaled = ((unsigned long long)size * percent + 50) / 100;
+    return scaled ? (unsigned int)scaled : 1;
+}
+
+
+void opchain_outputSize(const t_opchain *chain, unsigned int width, unsigned int height,
+                        unsigned int *outWidth, unsigned int *outHeight)
+{
+    for (int i = 0; i < chain->count; i++) {
+        const t_op *op = &chain->ops[i];
+        if (op->type == OP_ROT90 || op->type == OP_ROT270) {
+            unsigned int swap = width;
+            width = height;
+            height = swap;
+        } else if (op->type == OP_SCALE) {
+            width = opchain_scaledSize(width, op->value);
+            height = opchain_scaledSize(height, op->value);
+        }
+    }
+    *outWidth = width;
+    *outHeight = height;
+}
+
+
+int opchain_isRowLocal(const t_opchain *chain)
+{
+    for (int i = 0; i < chain->count; i++)
+        if (!opchain_ops[chain->ops[i].type].rowLocal)
+            return 0;
+    return 1;
+}
+
+
+// Check that every operation exists for the image depth before touching pixels
+static int opchain_supports(const t_opchain *chain, int gray)
+{
+    for (int i = 0; i < chain->count; i++) {
+        const t_op_desc *desc = &opchain_ops[chain->ops[i].type];
+        if (gray ? !desc->gray : !desc->color) {
+            fprintf(stderr, "Error : '%s' is not available for %s images\n",
+                    desc->name, gray ? "8-bit" : "24-bit");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// ========================================
+// PLANNING FUNCTIONS
+// ========================================
+
+
+// Compose the lookup table with one point operation applied after it
+static void opchain_composeLut(uint8_t *lut, const t_op *op)
+{
+    for (int i = 0; i < 256; i++) {
+        int v = lut[i];
+        switch (op->type) {
+            case OP_NEGATIVE:   v = 255 - v; break;
+            case OP_BRIGHTNESS: v += op->value; v = v > 255 ? 255 : (v < 0 ? 0 : v); break;
+            case OP_THRESHOLD:  v = v > op->value ? 255 : 0; break;
+            default: break;
+        }
+        lut[i] = (uint8_t)v;
+    }
+}
+
+
+static void opchain_resetLut(t_opstage *stage)
+{
+    for (int i = 0; i < 256; i++)
+        stage->lut[i] = (uint8_t)i;
+}
+
+
+static int opchain_isIdentity(const uint8_t *lut)
+{
+    for (int i = 0; i < 256; i++)
+        if (lut[i] != i)
+            return 0;
+    return 1;
+}
+
+
+// Add the pending remapping to the plan if it changes anything
+static void opchain_flush(t_opplan *plan, t_opstage *pending, int withFlips)
+{
+    pending->hasLut = !opchain_isIdentity(pending->lut);
+    int transpose = withFlips && pending->transpose;
+    int flipRows = withFlips && pending->flipRows;
+    int flipColumns = withFlips && pending->flipColumns;
+    if (pending->hasLut || transpose || flipRows || flipColumns) {
+        t_opstage *stage = &plan->stages[plan->count++];
+        *stage = *pending;
+        stage->transpose = transpose;
+        stage->flipRows = flipRows;
+        stage->flipColumns = flipColumns;
+    }
+
+    // Symmetries not flushed stay pending past the next operation
+    opchain_resetLut(pending);
+    if (withFlips)
+        pending->transpose = pending->flipRows = pending->flipColumns = 0;
+}
+
+
+int opchain_plan(const t_opchain *chain, int gray, t_opplan *plan)
+{
+    if (!opchain_supports(chain, gray))
+        return 0;
+
+    t_opstage pending = {0};
+    pending.type = STAGE_REMAP;
+    opchain_resetLut(&pending);
+    int isGray = gray;   // Every pixel has equal channels
+    plan->count = 0;
+
+    for (int i = 0; i < chain->count; i++) {
+        const t_op *op = &chain->ops[i];
+        switch (op->type) {
+            case OP_NEGATIVE:
+            case OP_BRIGHTNESS:
+            case OP_THRESHOLD:
+                opchain_composeLut(pending.lut, op);
+                break;
+            case OP_HFLIP:
+                pending.flipRows = !pending.flipRows;
+                break;
+            case OP_VFLIP:
+                pending.flipColumns = !pending.flipColumns;
+                break;
+            case OP_ROT180:
+                pending.flipRows = !pending.flipRows;
+                pending.flipColumns = !pending.flipColumns;
+                break;
+            case OP_ROT90:
+            case OP_ROT270: {
+                // Transposing after a flip is flipping the other axis after
+                // transposing; a quarter turn is a transposition then a flip
+                int flipRows = pending.flipRows;
+                pending.transpose = !pending.transpose;
+                pending.flipRows = pending.flipColumns;
+                pending.flipColumns = flipRows;
+                if (op->type == OP_ROT90)
+                    pending.flipColumns = !pending.flipColumns;
+                else
+                    pending.flipRows = !pending.flipRows;
+                break;
+            }
+            case OP_GRAYSCALE:
+            case OP_SEPIA:
+                // Per-pixel operations: flips are carried past them
+                if (op->type == OP_GRAYSCALE && isGray)
+                    break;
+                opchain_flush(plan, &pending, 0);
+                plan->stages[plan->count].type = STAGE_OP;
+                plan->stages[plan->count++].op = *op;
+                isGray = op->type == OP_GRAYSCALE;
+                break;
+            case OP_MEDIAN:
+                // The square is the same after any symmetry, so symmetries
+                // are carried past it as well
+                opchain_flush(plan, &pending, 0);
+                plan->stages[plan->count].type = STAGE_OP;
+                plan->stages[plan->count++].op = *op;
+                break;
+            case OP_SCALE:
+                if (op->value == 100)
+                    break;
+                // fall through
+            case OP_ROTATE:
+            case OP_EQUALIZE:
+            case OP_ERODE:
+            case OP_DILATE:
+            case OP_OPEN:
+            case OP_CLOSE:
+            case OP_TOPHAT:
+            case OP_BLACKHAT:
+                opchain_flush(plan, &pending, 1);
+                plan->stages[plan->count].type = STAGE_OP;
+                plan->stages[plan->count++].op = *op;
+                if (op->type == OP_EQUALIZE)
+                    isGray = gray;
+                break;
+            default: {
+                // Filters keep equal channels equal; consecutive ones share a pass
+                opchain_flush(plan, &pending, 1);
+                t_opstage *last = plan->count ? &plan->stages[plan->count - 1] : NULL;
+                if (!last || last->type != STAGE_FILTERS) {
+                    last = &plan->stages[plan->count++];
+                    last->type = STAGE_FILTERS;
+                    last->filterCount = 0;
+                }
+                last->filters[last->filterCount++] = op->type;
+                break;
+            }
+        }
+    }
+    opchain_flush(plan, &pending, 1);
+    return 1;
+}
+
+
+// Whether every pass of a plan works on rows independently
+static int opchain_planIsRowLocal(const t_opplan *plan)
+{
+    for (int i = 0; i < plan->count; i++) {
+        const t_opstage *stage = &plan->stages[i];
+        if (stage->type == STAGE_FILTERS
+            || (stage->type == STAGE_REMAP ? stage->transpose || stage->flipRows
+                                           : !opchain_ops[stage->op.type].rowLocal))
+            return 0;
+    }
+    return 1;
+}
+
+// ========================================
+// APPLICATION FUNCTIONS
+// ========================================
+
+
+static float ** opchain_createKernel(t_op_type type)
+{
+    float **kernel = createScratchKernel(3);
+    if (!kernel)
+        return NULL;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            kernel[i][j] = opchain_kernels[type - OP_BOX_BLUR][i][j];
+    return kernel;
+}
+
+
+// Kernels of a STAGE_FILTERS pass, in the scratch arena
+static float *** opchain_createKernels(const t_opstage *stage, int *sizes)
+{
+    float ***kernels = scratch_alloc(stage->filterCount * sizeof(float **));
+    if (!kernels)
+        return NULL;
+    for (int i = 0; i < stage->filterCount; i++) {
+        kernels[i] = opchain_createKernel(stage->filters[i]);
+        sizes[i] = 3;
+        if (!kernels[i])
+            return NULL;
+    }
+    return kernels;
+}
+
+
+int opchain_apply8(const t_opchain *chain, t_bmp8 *img)
+{
+    t_opplan plan;
+    if (!opchain_plan(chain, 1, &plan))
+        return 0;
+
+    for (int i = 0; i < plan.count; i++) {
+        const t_opstage *stage = &plan.stages[i];
+        if (stage->type == STAGE_REMAP) {
+            int flipRows = stage->flipRows, flipColumns = stage->flipColumns;
+            if (stage->transpose) {
+                // Quarter turns are (transpose, flip columns) and (transpose,
+                // flip rows); the two diagonal mirrors need one more flip
+                bmp8_rotate(img, stage->flipRows ? 3 : 1);
+                flipColumns = stage->flipRows == stage->flipColumns;
+                flipRows = 0;
+            }
+            t_image_view view = view_fromBmp8(img);
+            if (!view_remap(&view, flipRows, flipColumns, stage->hasLut ? stage->lut : NULL))
+                return 0;
+            continue;
+        }
+        if (stage->type == STAGE_FILTERS) {
+            int sizes[OPCHAIN_MAX_OPS];
+            size_t mark = scratch_mark();
+            float ***kernels = opchain_createKernels(stage, sizes);
+            if (kernels) bmp8_applyFilters(img, kernels, sizes, stage->filterCount);
+            scratch_release(mark);
+            if (!kernels) return 0;
+            continue;
+        }
+        switch (stage->op.type) {
+            case OP_ROTATE:     bmp8_rotateAngle(img, stage->op.value); break;
+            case OP_EQUALIZE:   bmp8_equalize(img); break;
+            case OP_MEDIAN:     bmp8_median(img, stage->op.value); break;
+            case OP_ERODE:      bmp8_erode(img, stage->op.value, stage->op.value); break;
+            case OP_DILATE:     bmp8_dilate(img, stage->op.value, stage->op.value); break;
+            case OP_OPEN:       bmp8_opening(img, stage->op.value, stage->op.value); break;
+            case OP_CLOSE:      bmp8_closing(img, stage->op.value, stage->op.value); break;
+            case OP_TOPHAT:     bmp8_topHat(img, stage->op.value, stage->op.value); break;
+            case OP_BLACKHAT:   bmp8_blackHat(img, stage->op.value, stage->op.value); break;
+            case OP_SCALE: {
+                unsigned int width = opchain_scaledSize(img->width, stage->op.value);
+                unsigned int height = opchain_scaledSize(img->height, stage->op.value);
+                bmp8_resize(img, width, height, stage->op.value < 100 ? SAMPLE_AREA : SAMPLE_BICUBIC);
+                if (img->width != width || img->height != height)
+                    return 0;
+                break;
+            }
+            default: break;
+        }
+    }
+    return 1;
+}
+
+
+int opchain_apply24(const t_opchain *chain, t_bmp24 *img)
+{
+    t_opplan plan;
+    if (!opchain_plan(chain, 0, &plan))
+        return 0;
+
+    for (int i = 0; i < plan.count; i++) {
+        const t_opstage *stage = &plan.stages[i];
+        if (stage->type == STAGE_REMAP) {
+            int flipRows = stage->flipRows, flipColumns = stage->flipColumns;
+            if (stage->transpose) {
+                // Quarter turns are (transpose, flip columns) and (transpose,
+                // flip rows); the two diagonal mirrors need one more flip
+                bmp24_rotate(img, stage->flipRows ? 3 : 1);
+                flipColumns = stage->flipRows == stage->flipColumns;
+                flipRows = 0;
+            }
+            t_image_view view = view_fromBmp24(img);
+            if (!view_remap(&view, flipRows, flipColumns, stage->hasLut ? stage->lut : NULL))
+                return 0;
+            continue;
+        }
+        if (stage->type == STAGE_FILTERS) {
+            int sizes[OPCHAIN_MAX_OPS];
+            size_t mark = scratch_mark();
+            float ***kernels = opchain_createKernels(stage, sizes);
+            if (kernels) bmp24_applyFilters(img, kernels, sizes, stage->filterCount);
+            scratch_release(mark);
+            if (!kernels) return 0;
+            continue;
+        }
+        switch (stage->op.type) {
+            case OP_GRAYSCALE:  bmp24_grayscale(img); break;
+            case OP_SEPIA:      bmp24_sepia(img); break;
+            case OP_ROTATE:     bmp24_rotateAngle(img, stage->op.value); break;
+            case OP_EQUALIZE:   bmp24_equalize(img); break;
+            case OP_MEDIAN:     bmp24_median(img, stage->op.value); break;
+            case OP_SCALE: {
+                unsigned int width = opchain_scaledSize(img->width, stage->op.value);
+                unsigned int height = opchain_scaledSize(img->height, stage->op.value);
+                bmp24_resize(img, (int)width, (int)height, stage->op.value < 100 ? SAMPLE_AREA : SAMPLE_BICUBIC);
+                if ((unsigned int)img->width != width || (unsigned int)img->height != height)
+                    return 0;
+                break;
+            }
+            default: break;
+        }
+    }
+    return 1;
+}
+
+// ========================================
+// PIPE MODE
+// ========================================
+
+
+static int opchain_streamGray(FILE *in, FILE *out, const t_pnm_info *info, const t_opchain *chain)
+{
+    uint8_t *rows = malloc((size_t)info->width * OPCHAIN_STRIP_ROWS);
+    if (!rows) {
+        fprintf(stderr, "Error allocating memory for the strip\n");
+        return 0;
+    }
+
+    // The strip is seen as a small image; row order does not matter here
+    t_bmp8 strip = {0};
+    strip.data = rows;
+    strip.width = info->width;
+    strip.stride = info->width;
+    strip.colorDepth = 8;
+
+    int ok = 1;
+    for (unsigned int y = 0; ok && y < info->height; y += strip.height) {
+        strip.height = info->height - y < OPCHAIN_STRIP_ROWS ? info->height - y : OPCHAIN_STRIP_ROWS;
+        strip.dataSize = (size_t)strip.stride * strip.height;
+        ok = pnm_readRows(in, info, rows, strip.height)
+             && opchain_apply8(chain, &strip)
+             && pnm_writeRows(out, rows, info->width, 1, strip.height);
+    }
+    free(rows);
+    return ok;
+}
+
+
+static int opchain_streamColor(FILE *in, FILE *out, const t_pnm_info *info, const t_opchain *chain)
+{
+    t_bmp24 *strip = bmp24_allocate(info->width, OPCHAIN_STRIP_ROWS, DEFAULT_DEPTH);
+    if (!strip)
+        return 0;
+
+    int ok = 1;
+    for (unsigned int y = 0; ok && y < info->height; y += strip->height) {
+        strip->height = info->height - y < OPCHAIN_STRIP_ROWS ? info->height - y : OPCHAIN_STRIP_ROWS;
+        for (int row = 0; ok && row < strip->height; row++)
+            ok = pnm_readRows(in, info, (uint8_t *)strip->data[row], 1);
+        ok = ok && opchain_apply24(chain, strip);
+        for (int row = 0; ok && row < strip->height; row++)
+            ok = pnm_writeRows(out, (const uint8_t *)strip->data[row], info->width, 3, 1);
+    }
+
+    bmp24_free(strip);
+    return ok;
+}
+
+
+static int opchain_wholeGray(FILE *in, FILE *out, const t_pnm_info *info, const t_opchain *chain)
+{
+    t_bmp8 *img = bmp8_allocate(info->width, info->height);
+    if (!img)
+        return 0;
+
+    int ok = 1;
+    for (size_t y = img->height; ok && y-- > 0;)
+        ok = pnm_readRows(in, info, img->data + y * img->stride, 1);
+    ok = ok && opchain_apply8(chain, img);
+    for (size_t y = img->height; ok && y-- > 0;)
+        ok = pnm_writeRows(out, img->data + y * img->stride, img->width, 1, 1);
+    bmp8_freeImage(img);
+    return ok;
+}
+
+
+static int opchain_wholeColor(FILE *in, FILE *out, const t_pnm_info *info, const t_opchain *chain)
+{
+    t_bmp24 *img = bmp24_allocate(info->width, info->height, DEFAULT_DEPTH);
+    if (!img)
+        return 0;
+
+    int ok = 1;
+    for (int y = 0; ok && y < img->height; y++)
+        ok = pnm_readRows(in, info, (uint8_t *)img->data[y], 1);
+    ok = ok && opchain_apply24(chain, img);
+    for (int y = 0; ok && y < img->height; y++)
+        ok = pnm_writeRows(out, (const uint8_t *)img->data[y], img->width, 3, 1);
+    bmp24_free(img);
+    return ok;
+}
+
+
+int opchain_runPipe(FILE *in, FILE *out, const t_opchain *chain)
+{
+    t_pnm_info info;
+    if (!pnm_readHeader(in, &info))
+        return 0;
+
+    int gray = info.channels == 1;
+    unsigned int width, height;
+    opchain_outputSize(chain, info.width, info.height, &width, &height);
+    if (!opchain_supports(chain, gray) || !pnm_writeHeader(out, width, height, info.channels))
+        return 0;
+
+    t_opplan plan;
+    opchain_plan(chain, gray, &plan);
+
+    int ok;
+    if (opchain_planIsRowLocal(&plan))
+        ok = gray ? opchain_streamGray(in, out, &info, chain) : opchain_streamColor(in, out, &info, chain);
+    else
+        ok = gray ? opchain_wholeGray(in, out, &info, chain) : opchain_wholeColor(in, out, &info, chain);
+
+    return ok && fflush(out) == 0;
+}
@@ -0,0 +1,234 @@
+/**
+ * @file opchain.h
+ * @brief Sequences of image operations given on the command line
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines an operation chain: a list of the processing
+ * functions of bmp8 and bmp24, parsed from arguments such as
+ * "negative brightness=30 gaussian-blur", and applied in order:
+ * - To a whole t_bmp8 or t_bmp24 image
+ * - To a PGM/PPM stream (pipe mode), strip by strip when every operation
+ *   only looks at one row at a time
+ *
+ * A chain is not run operation by operation: it is first turned into a plan
+ * with as few passes over the pixels as possible (see opchain_plan).
+ */
+
+#ifndef OPCHAIN_H
+#define OPCHAIN_H
+
+#include <stdint.h>
+#include "bmp8.h"
+#include "bmp24.h"
+
+/* ============================================================================
+ * OPERATION CHAIN CONSTANTS
+ * ============================================================================ */
+
+#define OPCHAIN_MAX_OPS     32    /**< Maximum number of operations in a chain */
+#define OPCHAIN_STRIP_ROWS  64    /**< Rows held in memory when streaming */
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @enum t_op_type
+ * @brief Operations available in a chain
+ */
+typedef enum {
+    OP_NEGATIVE,        /**< "negative" */
+    OP_BRIGHTNESS,      /**< "brightness=<value>" */
+    OP_THRESHOLD,       /**< "threshold=<value>" (8-bit only) */
+    OP_GRAYSCALE,       /**< "grayscale" (no effect on 8-bit images) */
+    OP_SEPIA,           /**< "sepia" (24-bit only) */
+    OP_HFLIP,           /**< "hflip": mirror on the x axis, top row becomes bottom row */
+    OP_VFLIP,           /**< "vflip": mirror on the y axis, left column becomes right column */
+    OP_ROT90,           /**< "rot90": quarter turn clockwise */
+    OP_ROT180,          /**< "rot180": half turn */
+    OP_ROT270,          /**< "rot270": quarter turn counterclockwise */
+    OP_ROTATE,          /**< "rotate=<degrees>": any angle, clockwise, same size */
+    OP_SCALE,           /**< "scale=<percent>": resize, area when shrinking, bicubic when enlarging */
+    OP_BOX_BLUR,        /**< "box-blur" */
+    OP_GAUSSIAN_BLUR,   /**< "gaussian-blur" */
+    OP_SHARPEN,         /**< "sharpen" */
+    OP_EMBOSS,          /**< "emboss" */
+    OP_OUTLINE,         /**< "outline" */
+    OP_SOBEL_X,         /**< "sobel-x" */
+    OP_SOBEL_Y,         /**< "sobel-y" */
+    OP_MOTION_BLUR,     /**< "motion-blur" */
+    OP_EQUALIZE,        /**< "equalize" */
+    OP_MEDIAN,          /**< "median=<radius>": median of the square of side 2 * radius + 1 */
+    OP_ERODE,           /**< "erode=<side>": erosion with a square (8-bit only) */
+    OP_DILATE,          /**< "dilate=<side>": dilation with a square (8-bit only) */
+    OP_OPEN,            /**< "open=<side>": opening with a square (8-bit only) */
+    OP_CLOSE,           /**< "close=<side>": closing with a square (8-bit only) */
+    OP_TOPHAT,          /**< "tophat=<side>": white top-hat with a square (8-bit only) */
+    OP_BLACKHAT,        /**< "blackhat=<side>": black top-hat with a square (8-bit only) */
+    OP_COUNT
+} t_op_type;
+
+/**
+ * @struct t_op
+ * @brief One operation and its parameter
+ */
+typedef struct {
+    t_op_type type;     /**< Operation to apply */
+    int value;          /**< Parameter of brightness, threshold, rotate, scale, median and morphology, 0 otherwise */
+} t_op;
+
+/**
+ * @struct t_opchain
+ * @brief Operations applied in order
+ */
+typedef struct {
+    t_op ops[OPCHAIN_MAX_OPS];  /**< Operations, first applied first */
+    int count;                  /**< Number of operations */
+} t_opchain;
+
+/**
+ * @enum t_stage_type
+ * @brief Kinds of passes in a plan
+ */
+typedef enum {
+    STAGE_REMAP,        /**< Mirror and lookup table applied in one pass */
+    STAGE_FILTERS,      /**< Consecutive filters run tile by tile in one pass */
+    STAGE_OP            /**< One operation of the chain, run as is */
+} t_stage_type;
+
+/**
+ * @struct t_opstage
+ * @brief One pass over the pixels
+ */
+typedef struct {
+    t_stage_type type;  /**< Kind of pass */
+    t_op op;            /**< STAGE_OP: operation to run */
+    t_op_type filters[OPCHAIN_MAX_OPS]; /**< STAGE_FILTERS: filters, first applied first */
+    int filterCount;    /**< STAGE_FILTERS: number of filters */
+    int transpose;      /**< STAGE_REMAP: exchange rows and columns first */
+    int flipRows;       /**< STAGE_REMAP: swap the top and bottom rows */
+    int flipColumns;    /**< STAGE_REMAP: swap the left and right columns */
+    int hasLut;         /**< STAGE_REMAP: lut is not the identity */
+    uint8_t lut[256];   /**< STAGE_REMAP: new value of each channel value */
+} t_opstage;
+
+/**
+ * @struct t_opplan
+ * @brief Passes equivalent to a chain, first run first
+ */
+typedef struct {
+    t_opstage stages[OPCHAIN_MAX_OPS];  /**< Passes */
+    int count;                          /**< Number of passes */
+} t_opplan;
+
+/* ============================================================================
+ * PARSING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Build a chain from a list of operation names
+ * @param chain Chain to fill
+ * @param argc Number of names
+ * @param argv Names such as "negative" or "brightness=30"
+ * @return 1 on success, 0 if a name or parameter is invalid (message on stderr)
+ */
+int opchain_parse(t_opchain *chain, int argc, char **argv);
+
+/**
+ * @brief Canonical text form of a chain
+ * @param chain Chain to describe
+ * @param buffer Destination string
+ * @param size Size of buffer
+ * @return 1 on success, 0 if buffer is too small
+ *
+ * Operation names separated by single spaces, values in decimal: two chains
+ * doing the same operations always give the same string, which parses back
+ * to the chain.
+ */
+int opchain_toString(const t_opchain *chain, char *buffer, size_t size);
+
+/**
+ * @brief Print the list of operation names
+ * @param file Stream to print to
+ */
+void opchain_printUsage(FILE *file);
+
+/**
+ * @brief Size of the image a chain gives
+ * @param chain Chain to check
+ * @param width Width of the input image
+ * @param height Height of the input image
+ * @param outWidth Width after the chain
+ * @param outHeight Height after the chain
+ *
+ * Quarter turns exchange the width and the height, scale changes both.
+ */
+void opchain_outputSize(const t_opchain *chain, unsigned int width, unsigned int height,
+                        unsigned int *outWidth, unsigned int *outHeight);
+
+/**
+ * @brief Check whether every operation works on rows independently
+ * @param chain Chain to check
+ * @return 1 if the chain can be applied to one strip of rows at a time
+ */
+int opchain_isRowLocal(const t_opchain *chain);
+
+/**
+ * @brief Turn a chain into the fewest passes giving the same pixels
+ * @param chain Chain to plan
+ * @param gray 1 for an 8-bit image, 0 for a 24-bit image
+ * @param plan Plan to fill
+ * @return 1 on success, 0 if an operation is not available for the depth
+ *
+ * - Consecutive negative, brightness and threshold operations are composed
+ *   into one lookup table; a table that maps every value to itself is dropped,
+ *   so "negative negative" costs nothing (clamping is kept: "brightness=200
+ *   brightness=-200" is not the identity and still runs)
+ * - Flips and rotations are composed into one of the 8 symmetries of the
+ *   image (a transposition or not, then flips): "rot90 rot270" or "hflip
+ *   hflip" cancel, "hflip vflip" is a half turn done in one pass
+ * - Symmetries commute with every operation that treats pixels independently
+ *   of their position (point operations, grayscale, sepia) or through a
+ *   symmetric neighbourhood (median), so they are carried past them;
+ *   filters, rotate, scale, equalization and morphology are barriers
+ * - Grayscale on an image already gray (8-bit, or after grayscale) is dropped
+ * - Consecutive filters become one pass computed tile by tile, each tile
+ *   going through every filter while it is in cache (view_applyFilters)
+ */
+int opchain_plan(const t_opchain *chain, int gray, t_opplan *plan);
+
+/* ============================================================================
+ * APPLICATION FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Apply a chain to an 8-bit image
+ * @param chain Chain to apply
+ * @param img Image to modify
+ * @return 1 on success, 0 if an operation is not available for 8-bit images
+ */
+int opchain_apply8(const t_opchain *chain, t_bmp8 *img);
+
+/**
+ * @brief Apply a chain to a 24-bit image
+ * @param chain Chain to apply
+ * @param img Image to modify
+ * @return 1 on success, 0 if an operation is not available for 24-bit images
+ */
+int opchain_apply24(const t_opchain *chain, t_bmp24 *img);
+
+/**
+ * @brief Read a PGM or PPM image, apply a chain and write the result
+ * @param in Input stream (P5 or P6)
+ * @param out Output stream, same format as the input
+ * @param chain Chain to apply
+ * @return 1 on success, 0 on failure (message on stderr)
+ *
+ * Chains whose plan is row-local are applied to OPCHAIN_STRIP_ROWS rows at
+ * a time, so memory does not depend on the image height ("hflip hflip" streams). Other chains (flip on the x
+ * axis, filters, equalization) need the whole image and load it first.
+ */
+int opchain_runPipe(FILE *in, FILE *out, const t_opchain *chain);
+
+#endif //OPCHAIN_H
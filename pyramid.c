@@ -0,0 +1,314 @@
+/**
+ * @file pyramid.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Gaussian and Laplacian pyramids of an image
+ *
+ */
+
+#include "pyramid.h"
+#include "bufpool.h"
+#include "scratch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ========================================
+// FILTER FUNCTIONS
+// ========================================
+
+
+// Index i of a row or column of n pixels, mirrored at the edges (-1 -> 1)
+static int pyramid_mirror(int i, int n)
+{
+    if (n == 1)
+        return 0;
+    while (i < 0 || i >= n)
+        i = i < 0 ? -i : 2 * n - 2 - i;
+    return i;
+}
+
+
+// Output row y of a reduction: the 5 source rows are combined with weights
+// 1 4 6 4 1 into sums (16 times the values), then every second column
+// is filtered the same way
+static void pyramid_reduceRow(const t_image_view *src, t_image_view *dst, unsigned int y, uint16_t *sums)
+{
+    int height = (int)src->height, width = (int)src->width, channels = src->format;
+    const uint8_t *r0 = view_row(src, (unsigned int)pyramid_mirror(2 * (int)y - 2, height));
+    const uint8_t *r1 = view_row(src, (unsigned int)pyramid_mirror(2 * (int)y - 1, height));
+    const uint8_t *r2 = view_row(src, (unsigned int)pyramid_mirror(2 * (int)y, height));
+    const uint8_t *r3 = view_row(src, (unsigned int)pyramid_mirror(2 * (int)y + 1, height));
+    const uint8_t *r4 = view_row(src, (unsigned int)pyramid_mirror(2 * (int)y + 2, height));
+    size_t count = (size_t)width * channels;
+    for (size_t i = 0; i < count; i++)
+        sums[i] = (uint16_t)(r0[i] + 4 * (r1[i] + r3[i]) + 6 * r2[i] + r4[i]);
+
+    uint8_t *out = view_row(dst, y);
+    for (int x = 0; x < (int)dst->width; x++) {
+        int c0, c1, c2, c3, c4;
+        if (2 * x - 2 >= 0 && 2 * x + 2 < width) {
+            c0 = 2 * x - 2; c1 = c0 + 1; c2 = c0 + 2; c3 = c0 + 3; c4 = c0 + 4;
+        } else {
+            c0 = pyramid_mirror(2 * x - 2, width);
+            c1 = pyramid_mirror(2 * x - 1, width);
+            c2 = pyramid_mirror(2 * x, width);
+            c3 = pyramid_mirror(2 * x + 1, width);
+            c4 = pyramid_mirror(2 * x + 2, width);
+        }
+        for (int c = 0; c < channels; c++) {
+            int sum = sums[c0 * channels + c] + 4 * (sums[c1 * channels + c] + sums[c3 * channels + c])
+                      + 6 * sums[c2 * channels + c] + sums[c4 * channels + c];
+            out[x * channels + c] = (uint8_t)((sum + 128) >> 8);
+        }
+    }
+}
+
+
+// Row y of the expansion of coarse to a level width pixels wide: new rows and
+// columns fall between two coarse ones (weights 4 4), the others on one
+// (weights 1 6 1); sums holds 8 times the values of the interpolated row
+static void pyramid_expandRow(const t_image_view *coarse, unsigned int width, unsigned int y,
+                              uint16_t *sums, uint8_t *out)
+{
+    int rows = (int)coarse->height, columns = (int)coarse->width, channels = coarse->format;
+    int i = (int)y / 2;
+    size_t count = (size_t)columns * channels;
+    const uint8_t *center = view_row(coarse, (unsigned int)i);
+    const uint8_t *below = view_row(coarse, (unsigned int)pyramid_mirror(i + 1, rows));
+    if (y % 2 == 0) {
+        const uint8_t *above = view_row(coarse, (unsigned int)pyramid_mirror(i - 1, rows));
+        for (size_t k = 0; k < count; k++)
+            sums[k] = (uint16_t)(above[k] + 6 * center[k] + below[k]);
+    } else {
+        for (size_t k = 0; k < count; k++)
+            sums[k] = (uint16_t)(4 * (center[k] + below[k]));
+    }
+
+    for (int x = 0; x < (int)width; x++) {
+        int j = x / 2;
+        int next = pyramid_mirror(j + 1, columns);
+        for (int c = 0; c < channels; c++) {
+            int value;
+            if (x % 2 == 0)
+                value = sums[pyramid_mirror(j - 1, columns) * channels + c] + 6 * sums[j * channels + c]
+                        + sums[next * channels + c];
+            else
+                value = 4 * (sums[j * channels + c] + sums[next * channels + c]);
+            out[x * channels + c] = (uint8_t)((value + 32) >> 6);
+        }
+    }
+}
+
+
+static int pyramid_expandsTo(const t_image_view *coarse, unsigned int width, unsigned int height)
+{
+    return (width + 1) / 2 == coarse->width && (height + 1) / 2 == coarse->height;
+}
+
+// ========================================
+// PYRAMID FUNCTIONS
+// ========================================
+
+
+t_pyramid * pyramid_create(const t_image_view *base)
+{
+    t_pyramid *pyramid = calloc(1, sizeof(t_pyramid));
+    if (!pyramid) {
+        printf("Error: Failed to allocate the pyramid\n");
+        return NULL;
+    }
+
+    // Sizes of every level are known now, their pixels come later
+    pyramid->levels[0] = *base;
+    pyramid->count = 1;
+    while (pyramid->count < PYRAMID_MAX_LEVELS) {
+        const t_image_view *above = &pyramid->levels[pyramid->count - 1];
+        if (above->width <= 1 && above->height <= 1)
+            break;
+        t_image_view *level = &pyramid->levels[pyramid->count++];
+        level->data = NULL;
+        level->width = (above->width + 1) / 2;
+        level->height = (above->height + 1) / 2;
+        level->stride = (ptrdiff_t)level->width * base->format;
+        level->format = base->format;
+    }
+    return pyramid;
+}
+
+
+t_pyramid * pyramid_createBmp8(t_bmp8 *img)
+{
+    t_image_view view = view_fromBmp8(img);
+    return pyramid_create(&view);
+}
+
+
+t_pyramid * pyramid_createBmp24(t_bmp24 *img)
+{
+    t_image_view view = view_fromBmp24(img);
+    return pyramid_create(&view);
+}
+
+
+const t_image_view * pyramid_level(t_pyramid *pyramid, int level)
+{
+    if (level < 0 || level >= pyramid->count)
+        return NULL;
+    t_image_view *view = &pyramid->levels[level];
+    if (view->data)
+        return view;
+
+    const t_image_view *above = pyramid_level(pyramid, level - 1);
+    if (!above)
+        return NULL;
+    size_t bytes = (size_t)view->stride * view->height;
+    uint8_t *data = pool_alloc(bytes);
+    if (!data) {
+        printf("Error: Failed to allocate pyramid level %d\n", level);
+        return NULL;
+    }
+    view->data = data;
+
+    int bands = (int)((view->height + PYRAMID_BAND_ROWS - 1) / PYRAMID_BAND_ROWS);
+    int failed = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(|:failed)
+    for (int band = 0; band < bands; band++) {
+        size_t mark = scratch_mark();
+        uint16_t *sums = scratch_alloc((size_t)above->width * above->format * sizeof(uint16_t));
+        if (!sums) {
+            failed = 1;
+        } else {
+            unsigned int y0 = (unsigned int)band * PYRAMID_BAND_ROWS;
+            unsigned int y1 = view->height - y0 < PYRAMID_BAND_ROWS ? view->height : y0 + PYRAMID_BAND_ROWS;
+            for (unsigned int y = y0; y < y1; y++)
+                pyramid_reduceRow(above, view, y, sums);
+        }
+        scratch_release(mark);
+    }
+
+    if (failed) {
+        printf("Error: Failed to allocate pyramid level %d\n", level);
+        pool_free(data);
+        view->data = NULL;
+        return NULL;
+    }
+    pyramid->bytes += bytes;
+    return view;
+}
+
+
+void pyramid_invalidate(t_pyramid *pyramid)
+{
+    for (int i = 1; i < pyramid->count; i++) {
+        pool_free(pyramid->levels[i].data);
+        pyramid->levels[i].data = NULL;
+    }
+    pyramid->bytes = 0;
+}
+
+
+void pyramid_free(t_pyramid *pyramid)
+{
+    if (!pyramid)
+        return;
+    pyramid_invalidate(pyramid);
+    free(pyramid);
+}
+
+// ========================================
+// EXPANSION AND LAPLACIAN FUNCTIONS
+// ========================================
+
+
+int pyramid_expand(const t_image_view *coarse, t_image_view *dst)
+{
+    if (coarse->format != dst->format || !pyramid_expandsTo(coarse, dst->width, dst->height))
+        return 0;
+
+    int bands = (int)((dst->height + PYRAMID_BAND_ROWS - 1) / PYRAMID_BAND_ROWS);
+    int failed = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(|:failed)
+    for (int band = 0; band < bands; band++) {
+        size_t mark = scratch_mark();
+        uint16_t *sums = scratch_alloc((size_t)coarse->width * coarse->format * sizeof(uint16_t));
+        if (!sums) {
+            failed = 1;
+        } else {
+            unsigned int y0 = (unsigned int)band * PYRAMID_BAND_ROWS;
+            unsigned int y1 = dst->height - y0 < PYRAMID_BAND_ROWS ? dst->height : y0 + PYRAMID_BAND_ROWS;
+            for (unsigned int y = y0; y < y1; y++)
+                pyramid_expandRow(coarse, dst->width, y, sums, view_row(dst, y));
+        }
+        scratch_release(mark);
+    }
+    return !failed;
+}
+
+
+int pyramid_laplacian(t_pyramid *pyramid, int level, int16_t *laplacian)
+{
+    if (level < 0 || level >= pyramid->count - 1)
+        return 0;
+    const t_image_view *fine = pyramid_level(pyramid, level);
+    const t_image_view *coarse = pyramid_level(pyramid, level + 1);
+    if (!fine || !coarse)
+        return 0;
+
+    size_t rowValues = (size_t)fine->width * fine->format;
+    int bands = (int)((fine->height + PYRAMID_BAND_ROWS - 1) / PYRAMID_BAND_ROWS);
+    int failed = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(|:failed)
+    for (int band = 0; band < bands; band++) {
+        size_t mark = scratch_mark();
+        uint16_t *sums = scratch_alloc((size_t)coarse->width * coarse->format * sizeof(uint16_t));
+        uint8_t *expanded = scratch_alloc(rowValues);
+        if (!sums || !expanded) {
+            failed = 1;
+        } else {
+            unsigned int y0 = (unsigned int)band * PYRAMID_BAND_ROWS;
+            unsigned int y1 = fine->height - y0 < PYRAMID_BAND_ROWS ? fine->height : y0 + PYRAMID_BAND_ROWS;
+            for (unsigned int y = y0; y < y1; y++) {
+                pyramid_expandRow(coarse, fine->width, y, sums, expanded);
+                const uint8_t *row = view_row(fine, y);
+                int16_t *out = laplacian + y * rowValues;
+                for (size_t i = 0; i < rowValues; i++)
+                    out[i] = (int16_t)(row[i] - expanded[i]);
+            }
+        }
+        scratch_release(mark);
+    }
+    return !failed;
+}
+
+
+int pyramid_reconstruct(const t_image_view *coarse, const int16_t *laplacian, t_image_view *dst)
+{
+    if (coarse->format != dst->format || !pyramid_expandsTo(coarse, dst->width, dst->height))
+        return 0;
+
+    size_t rowValues = (size_t)dst->width * dst->format;
+    int bands = (int)((dst->height + PYRAMID_BAND_ROWS - 1) / PYRAMID_BAND_ROWS);
+    int failed = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(|:failed)
+    for (int band = 0; band < bands; band++) {
+        size_t mark = scratch_mark();
+        uint16_t *sums = scratch_alloc((size_t)coarse->width * coarse->format * sizeof(uint16_t));
+        if (!sums) {
+            failed = 1;
+        } else {
+            unsigned int y0 = (unsigned int)band * PYRAMID_BAND_ROWS;
+            unsigned int y1 = dst->height - y0 < PYRAMID_BAND_ROWS ? dst->height : y0 + PYRAMID_BAND_ROWS;
+            for (unsigned int y = y0; y < y1; y++) {
+                uint8_t *out = view_row(dst, y);
+                const int16_t *differences = laplacian + y * rowValues;
+                pyramid_expandRow(coarse, dst->width, y, sums, out);
+                for (size_t i = 0; i < rowValues; i++) {
+                    int value = out[i] + differences[i];
+                    out[i] = (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+                }
+            }
+        }
+        scratch_release(mark);
+    }
+    return !failed;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file pyramid.h
+ * @brief Gaussian and Laplacian pyramids of an image
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines an image pyramid: the image at full size (level
+ * 0), then at half size (level 1), quarter size (level 2)... down to one
+ * pixel. It is meant for work that looks at the same image at several
+ * scales: previews, coarse-to-fine searches, blending.
+ * - Level 0 is a view of the image itself, no copy is made
+ * - A level is computed the first time it is asked for, from the level
+ *   above, with the 5-tap [1 4 6 4 1] / 16 filter in both directions
+ *   (Burt and Adelson), then kept: the pyramid holds at most 1/3 of the
+ *   image in addition to the image, so about 4/3 of the image in total
+ * - A Laplacian level is the difference between a level and the expansion
+ *   of the next one; adding it back to that expansion gives the level
+ *   exactly (pyramid_reconstruct), so modified Laplacian levels (blending)
+ *   can be collapsed back into an image
+ *
+ * Levels computed from an image that changed since are dropped with
+ * pyramid_invalidate. A pyramid must only be used by one thread at a time.
+ *
+ * Usage:
+ * @code
+ *     t_pyramid *pyramid = pyramid_createBmp24(img);
+ *     const t_image_view *preview = pyramid_level(pyramid, 3);   // 1/8 size
+ *     pyramid_free(pyramid);
+ * @endcode
+ */
+
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "imageview.h"
+
+/* ============================================================================
+ * PYRAMID CONSTANTS
+ * ============================================================================ */
+
+#define PYRAMID_MAX_LEVELS  32      /**< Levels of the largest possible image */
+#define PYRAMID_BAND_ROWS   32      /**< Rows of a level computed by one band */
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @struct t_pyramid
+ * @brief Levels of an image, computed on demand
+ */
+typedef struct {
+    t_image_view levels[PYRAMID_MAX_LEVELS];    /**< Level views; data is NULL until computed */
+    int count;                                  /**< Number of levels, down to 1 x 1 */
+    size_t bytes;                               /**< Bytes held by the computed levels */
+} t_pyramid;
+
+/* ============================================================================
+ * PYRAMID FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start the pyramid of an image
+ * @param base Whole image; it must outlive the pyramid
+ * @return Pointer to the pyramid, or NULL on allocation failure
+ *
+ * No level is computed yet.
+ */
+t_pyramid *pyramid_create(const t_image_view *base);
+
+/**
+ * @brief Start the pyramid of an 8-bit image
+ * @param img Image; it must outlive the pyramid
+ * @return Pointer to the pyramid, or NULL on allocation failure
+ */
+t_pyramid *pyramid_createBmp8(t_bmp8 *img);
+
+/**
+ * @brief Start the pyramid of a 24-bit image
+ * @param img Image; it must outlive the pyramid
+ * @return Pointer to the pyramid, or NULL on allocation failure
+ */
+t_pyramid *pyramid_createBmp24(t_bmp24 *img);
+
+/**
+ * @brief Get a level, computing it and the levels above if needed
+ * @param pyramid Pyramid of the image
+ * @param level 0 for the image, 1 for half size...
+ * @return View of the level (owned by the pyramid), or NULL if level is out
+ *         of range or memory is missing
+ *
+ * Level n + 1 is ((width + 1) / 2) x ((height + 1) / 2) of level n. Edges
+ * are mirrored.
+ */
+const t_image_view *pyramid_level(t_pyramid *pyramid, int level);
+
+/**
+ * @brief Drop the computed levels
+ * @param pyramid Pyramid of the image
+ *
+ * Call it after the image changed; levels are computed again when asked for.
+ */
+void pyramid_invalidate(t_pyramid *pyramid);
+
+/**
+ * @brief Free a pyramid and its levels
+ * @param pyramid Pyramid to free, or NULL
+ *
+ * The image itself is not freed.
+ */
+void pyramid_free(t_pyramid *pyramid);
+
+/* ============================================================================
+ * EXPANSION AND LAPLACIAN FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Enlarge a level to the size of the level above
+ * @param coarse Level to enlarge
+ * @param dst Destination, same format, (2 * width - 1 or 2 * width) x
+ *            (2 * height - 1 or 2 * height) of coarse
+ * @return 1 on success, 0 if the sizes or formats do not match
+ *
+ * Interpolates with the same 5-tap filter as the reduction.
+ */
+int pyramid_expand(const t_image_view *coarse, t_image_view *dst);
+
+/**
+ * @brief Compute a Laplacian level
+ * @param pyramid Pyramid of the image
+ * @param level Level, from 0 to count - 2
+ * @param laplacian Destination: width x height x channels values of the
+ *                  level, rows packed, top row first
+ * @return 1 on success, 0 if level is out of range or memory is missing
+ *
+ * Each value is the level minus the expansion of the next level, between
+ * -255 and 255. The last level of a Laplacian pyramid is the last level
+ * of the Gaussian one.
+ */
+int pyramid_laplacian(t_pyramid *pyramid, int level, int16_t *laplacian);
+
+/**
+ * @brief Rebuild a level from the next one and its Laplacian
+ * @param coarse Next level (or a modified version of it)
+ * @param laplacian Values from pyramid_laplacian (or modified ones)
+ * @param dst Destination of the size of the level, same format as coarse
+ * @return 1 on success, 0 if the sizes or formats do not match
+ *
+ * Gives back the level exactly when nothing was modified. Going from the
+ * last level up to level 0 collapses a whole Laplacian pyramid.
+ */
+int pyramid_reconstruct(const t_image_view *coarse, const int16_t *laplacian, t_image_view *dst);
+
+#endif //PYRAMID_H
@@ -0,0 +1,475 @@
+/**
+ * @file qoi.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Streaming QOI encoder and decoder for 8-bit and 24-bit images
+ *
+ * This file implements the QOI format (https://qoiformat.org) for RGB images
+ * and a single-channel variant of it for grayscale images. Both directions
+ * work one row at a time, so only the I/O buffer and one row are needed on
+ * top of the image itself.
+ *
+ * Grayscale variant ("qoig"), one byte tag per pixel:
+ * - 0x00..0x7F  DIFF     value = previous + (tag - 64)
+ * - 0x80..0xBF  INDEX    value = index[tag & 63]
+ * - 0xC0..0xFD  RUN      previous value repeated (tag & 63) + 1 times
+ * - 0xFE        LITERAL  value in the next byte
+ *
+ */
+
+#include "qoi.h"
+#include <string.h>
+
+// Tags of the standard QOI operations
+#define QOI_OP_INDEX  0x00
+#define QOI_OP_DIFF   0x40
+#define QOI_OP_LUMA   0x80
+#define QOI_OP_RUN    0xC0
+#define QOI_OP_RGB    0xFE
+#define QOI_OP_RGBA   0xFF
+#define QOI_MASK_2    0xC0
+
+// Tags of the grayscale variant
+#define QOIG_OP_DIFF     0x00
+#define QOIG_OP_INDEX    0x80
+#define QOIG_OP_RUN      0xC0
+#define QOIG_OP_LITERAL  0xFE
+
+#define QOI_RUN_MAX   62
+
+#define QOI_HASH(p)   (((p)[0] * 3 + (p)[1] * 5 + (p)[2] * 7 + (p)[3] * 11) & 63)
+#define QOIG_HASH(v)  (((v) * 7) & 63)
+
+static const uint8_t qoi_padding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+// ========================================
+// BUFFERED I/O
+// ========================================
+
+
+static int qoi_flush(t_qoi_encoder *enc)
+{
+    size_t written = fwrite(enc->buffer, 1, enc->length, enc->file);
+    int ok = written == enc->length;
+    enc->length = 0;
+    return ok;
+}
+
+
+/**
+ * Append n bytes to the output buffer. Called with at most 5 bytes at a
+ * time, so flushing when fewer than 8 bytes are left is enough.
+ */
+static void qoi_put(t_qoi_encoder *enc, const uint8_t *bytes, size_t n)
+{
+    if (enc->length + n > QOI_BUFFER_SIZE)
+        qoi_flush(enc);
+    memcpy(enc->buffer + enc->length, bytes, n);
+    enc->length += n;
+}
+
+
+static void qoi_putByte(t_qoi_encoder *enc, uint8_t byte)
+{
+    if (enc->length == QOI_BUFFER_SIZE)
+        qoi_flush(enc);
+    enc->buffer[enc->length++] = byte;
+}
+
+
+/**
+ * Next byte of the input, refilling the buffer when it is empty.
+ * Returns -1 at the end of the file.
+ */
+static int qoi_getByte(t_qoi_decoder *dec)
+{
+    if (dec->position == dec->length) {
+        dec->length = fread(dec->buffer, 1, QOI_BUFFER_SIZE, dec->file);
+        dec->position = 0;
+        if (dec->length == 0)
+            return -1;
+    }
+    return dec->buffer[dec->position++];
+}
+
+
+static void qoi_write32(uint8_t *out, uint32_t value)
+{
+    // QOI header fields are big-endian
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+
+static uint32_t qoi_read32(const uint8_t *in)
+{
+    return (uint32_t)in[0] << 24 | (uint32_t)in[1] << 16 | (uint32_t)in[2] << 8 | in[3];
+}
+
+// ========================================
+// ENCODER
+// ========================================
+
+
+t_qoi_encoder * qoi_encoderOpen(const char *filename, unsigned int width, unsigned int height, int channels)
+{
+    if (channels != 3 && channels != 1) {
+        printf("Error : QOI supports 3 or 1 channels, not %d\n", channels);
+        return NULL;
+    }
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        printf("Error: Opening of the file impossible %s\n", filename);
+        return NULL;
+    }
+
+    t_qoi_encoder *enc = calloc(1, sizeof(t_qoi_encoder));
+    if (!enc) {
+        printf("Error allocating memory for the encoder\n");
+        fclose(file);
+        return NULL;
+    }
+    enc->file = file;
+    enc->width = width;
+    enc->height = height;
+    enc->channels = channels;
+    enc->prev[3] = 255;   // Initial pixel is opaque black
+
+    uint8_t header[QOI_HEADER_SIZE];
+    memcpy(header, channels == 3 ? "qoif" : "qoig", 4);
+    qoi_write32(header + 4, width);
+    qoi_write32(header + 8, height);
+    header[12] = channels;
+    header[13] = 0;       // sRGB with linear alpha
+    qoi_put(enc, header, QOI_HEADER_SIZE);
+    return enc;
+}
+
+
+static void qoi_flushRun(t_qoi_encoder *enc)
+{
+    if (enc->run > 0) {
+        qoi_putByte(enc, QOI_OP_RUN | (enc->run - 1));
+        enc->run = 0;
+    }
+}
+
+
+static void qoi_encodeRGB(t_qoi_encoder *enc, const uint8_t *row)
+{
+    for (unsigned int x = 0; x < enc->width; x++) {
+        uint8_t px[4] = {row[x * 3], row[x * 3 + 1], row[x * 3 + 2], 255};
+
+        if (memcmp(px, enc->prev, 4) == 0) {
+            if (++enc->run == QOI_RUN_MAX)
+                qoi_flushRun(enc);
+            continue;
+        }
+        qoi_flushRun(enc);
+
+        int hash = QOI_HASH(px);
+        if (memcmp(enc->index[hash], px, 4) == 0) {
+            qoi_putByte(enc, QOI_OP_INDEX | hash);
+        } else {
+            memcpy(enc->index[hash], px, 4);
+
+            // Alpha is always 255, so only the color differences matter
+            int dr = px[0] - enc->prev[0];
+            int dg = px[1] - enc->prev[1];
+            int db = px[2] - enc->prev[2];
+            int dr_dg = dr - dg;
+            int db_dg = db - dg;
+
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                qoi_putByte(enc, QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+            } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                uint8_t luma[2] = {QOI_OP_LUMA | (dg + 32), (dr_dg + 8) << 4 | (db_dg + 8)};
+                qoi_put(enc, luma, 2);
+            } else {
+                uint8_t rgb[4] = {QOI_OP_RGB, px[0], px[1], px[2]};
+                qoi_put(enc, rgb, 4);
+            }
+        }
+        memcpy(enc->prev, px, 4);
+    }
+}
+
+
+static void qoi_encodeGray(t_qoi_encoder *enc, const uint8_t *row)
+{
+    for (unsigned int x = 0; x < enc->width; x++) {
+        uint8_t v = row[x];
+
+        if (v == enc->prev[0]) {
+            if (++enc->run == QOI_RUN_MAX)
+                qoi_flushRun(enc);
+            continue;
+        }
+        qoi_flushRun(enc);
+
+        int hash = QOIG_HASH(v);
+        int diff = v - enc->prev[0];
+        if (enc->index[hash][0] == v) {
+            qoi_putByte(enc, QOIG_OP_INDEX | hash);
+        } else {
+            enc->index[hash][0] = v;
+            if (diff >= -64 && diff <= 63) {
+                qoi_putByte(enc, QOIG_OP_DIFF | (diff + 64));
+            } else {
+                uint8_t literal[2] = {QOIG_OP_LITERAL, v};
+                qoi_put(enc, literal, 2);
+            }
+        }
+        enc->prev[0] = v;
+    }
+}
+
+
+int qoi_encodeRow(t_qoi_encoder *enc, const uint8_t *row)
+{
+    if (enc->rowsDone >= enc->height)
+        return 0;
+    if (enc->channels == 3)
+        qoi_encodeRGB(enc, row);
+    else
+        qoi_encodeGray(enc, row);
+    enc->rowsDone++;
+    return 1;
+}
+
+
+int qoi_encoderClose(t_qoi_encoder *enc)
+{
+    qoi_flushRun(enc);
+    qoi_put(enc, qoi_padding, sizeof(qoi_padding));
+    int ok = qoi_flush(enc) && enc->rowsDone == enc->height;
+    if (fclose(enc->file) != 0)
+        ok = 0;
+    free(enc);
+    return ok;
+}
+
+// ========================================
+// DECODER
+// ========================================
+
+
+t_qoi_decoder * qoi_decoderOpen(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        printf("Error : Opening of the file impossible %s\n", filename);
+        return NULL;
+    }
+
+    uint8_t header[QOI_HEADER_SIZE];
+    if (fread(header, 1, QOI_HEADER_SIZE, file) != QOI_HEADER_SIZE) {
+        printf("Error : File is not a QOI file\n");
+        fclose(file);
+        return NULL;
+    }
+    int gray = memcmp(header, "qoig", 4) == 0;
+    if (!gray && memcmp(header, "qoif", 4) != 0) {
+        printf("Error : File is not a QOI file\n");
+        fclose(file);
+        return NULL;
+    }
+    if ((gray && header[12] != 1) || (!gray && header[12] != 3 && header[12] != 4)) {
+        printf("Error : Invalid QOI channel count %d\n", header[12]);
+        fclose(file);
+        return NULL;
+    }
+
+    t_qoi_decoder *dec = calloc(1, sizeof(t_qoi_decoder));
+    if (!dec) {
+        printf("Error allocating memory for the decoder\n");
+        fclose(file);
+        return NULL;
+    }
+    dec->file = file;
+    dec->width = qoi_read32(header + 4);
+    dec->height = qoi_read32(header + 8);
+    dec->gray = gray;
+    dec->channels = gray ? 1 : 3;
+    dec->prev[3] = 255;
+    return dec;
+}
+
+
+static int qoi_decodeRGB(t_qoi_decoder *dec, uint8_t *row)
+{
+    uint8_t *px = dec->prev;
+
+    for (unsigned int x = 0; x < dec->width; x++) {
+        if (dec->run > 0) {
+            dec->run--;
+        } else {
+            int b1 = qoi_getByte(dec);
+            if (b1 < 0) return 0;
+
+            if (b1 == QOI_OP_RGB || b1 == QOI_OP_RGBA) {
+                for (int c = 0; c < (b1 == QOI_OP_RGB ? 3 : 4); c++) {
+                    int v = qoi_getByte(dec);
+                    if (v < 0) return 0;
+                    px[c] = v;
+                }
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+                memcpy(px, dec->index[b1], 4);
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+                px[0] += ((b1 >> 4) & 3) - 2;
+                px[1] += ((b1 >> 2) & 3) - 2;
+                px[2] += (b1 & 3) - 2;
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+                int b2 = qoi_getByte(dec);
+                if (b2 < 0) return 0;
+                int dg = (b1 & 0x3F) - 32;
+                px[0] += dg - 8 + ((b2 >> 4) & 0x0F);
+                px[1] += dg;
+                px[2] += dg - 8 + (b2 & 0x0F);
+            } else {
+                dec->run = b1 & 0x3F;   // QOI_OP_RUN: this pixel plus (run) more
+            }
+            memcpy(dec->index[QOI_HASH(px)], px, 4);
+        }
+
+        row[x * 3]     = px[0];
+        row[x * 3 + 1] = px[1];
+        row[x * 3 + 2] = px[2];
+    }
+    return 1;
+}
+
+
+static int qoi_decodeGray(t_qoi_decoder *dec, uint8_t *row)
+{
+    uint8_t *v = dec->prev;
+
+    for (unsigned int x = 0; x < dec->width; x++) {
+        if (dec->run > 0) {
+            dec->run--;
+        } else {
+            int tag = qoi_getByte(dec);
+            if (tag < 0) return 0;
+
+            if (tag == QOIG_OP_LITERAL) {
+                int literal = qoi_getByte(dec);
+                if (literal < 0) return 0;
+                v[0] = literal;
+            } else if (tag < QOIG_OP_INDEX) {
+                v[0] += tag - 64;
+            } else if (tag < QOIG_OP_RUN) {
+                v[0] = dec->index[tag & 63][0];
+            } else {
+                dec->run = tag & 0x3F;
+            }
+            dec->index[QOIG_HASH(v[0])][0] = v[0];
+        }
+        row[x] = v[0];
+    }
+    return 1;
+}
+
+
+int qoi_decodeRow(t_qoi_decoder *dec, uint8_t *row)
+{
+    return dec->gray ? qoi_decodeGray(dec, row) : qoi_decodeRGB(dec, row);
+}
+
+
+void qoi_decoderClose(t_qoi_decoder *dec)
+{
+    if (dec) {
+        fclose(dec->file);
+        free(dec);
+    }
+}
+
+// ========================================
+// IMAGE FUNCTIONS
+// ========================================
+
+
+void bmp24_saveQOI(t_bmp24 *img, const char *filename)
+{
+    t_qoi_encoder *enc = qoi_encoderOpen(filename, img->width, img->height, 3);
+    if (!enc) return;
+
+    // t_pixel is packed R, G, B: each row is already in QOI order
+    for (int y = 0; y < img->height; y++)
+        qoi_encodeRow(enc, (const uint8_t *)img->data[y]);
+
+    if (qoi_encoderClose(enc))
+        printf("Image successfully saved\n");
+    else
+        printf("Error: Writing of the file %s failed\n", filename);
+}
+
+
+t_bmp24 * bmp24_loadQOI(const char *filename)
+{
+    t_qoi_decoder *dec = qoi_decoderOpen(filename);
+    if (!dec) return NULL;
+    if (dec->gray) {
+        printf("Error : File is a grayscale QOI file\n");
+        qoi_decoderClose(dec);
+        return NULL;
+    }
+
+    t_bmp24 *img = bmp24_allocate(dec->width, dec->height, DEFAULT_DEPTH);
+    if (!img) {
+        qoi_decoderClose(dec);
+        return NULL;
+    }
+    for (int y = 0; y < img->height; y++) {
+        if (!qoi_decodeRow(dec, (uint8_t *)img->data[y])) {
+            printf("Error : QOI data is truncated\n");
+            break;
+        }
+    }
+    qoi_decoderClose(dec);
+    return img;
+}
+
+
+void bmp8_saveQOI(const char *filename, t_bmp8 *img)
+{
+    t_qoi_encoder *enc = qoi_encoderOpen(filename, img->width, img->height, 1);
+    if (!enc) return;
+
+    // QOI stores the top row first; 8-bit data is bottom row first
+    for (size_t y = img->height; y-- > 0;)
+        qoi_encodeRow(enc, img->data + y * img->stride);
+
+    if (qoi_encoderClose(enc))
+        printf("Image enregistree sous : %s\n", filename);
+    else
+        printf("Erreur : Impossible d'ecrire dans le fichier %s\n", filename);
+}
+
+
+t_bmp8 * bmp8_loadQOI(const char *filename)
+{
+    t_qoi_decoder *dec = qoi_decoderOpen(filename);
+    if (!dec) return NULL;
+    if (!dec->gray) {
+        printf("Erreur : Le fichier QOI n'est pas en niveaux de gris\n");
+        qoi_decoderClose(dec);
+        return NULL;
+    }
+
+    t_bmp8 *img = bmp8_allocate(dec->width, dec->height);
+    if (!img) {
+        qoi_decoderClose(dec);
+        return NULL;
+    }
+    for (size_t y = img->height; y-- > 0;) {
+        if (!qoi_decodeRow(dec, img->data + y * img->stride)) {
+            printf("Erreur : Donnees QOI incompletes\n");
+            break;
+        }
+    }
+    qoi_decoderClose(dec);
+    return img;
+}
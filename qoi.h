@@ -0,0 +1,157 @@
+/**
+ * @file qoi.h
+ * @brief Fast lossless codec for intermediate images (QOI format)
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines a streaming encoder and decoder for the QOI
+ * ("Quite OK Image") format, used as a compressed scratch format between
+ * processing steps instead of uncompressed BMP:
+ * - 24-bit images are stored as standard QOI files (magic "qoif", 3 channels)
+ * - 8-bit grayscale images use a single-channel variant (magic "qoig")
+ * - Encoding and decoding work one row at a time through a small buffer
+ *
+ * No external library is needed. Each pixel costs a handful of byte
+ * operations, and photos typically shrink to a third to a half of their BMP size.
+ */
+
+#ifndef QOI_H
+#define QOI_H
+
+#include "bmp8.h"
+#include "bmp24.h"
+
+/* ============================================================================
+ * QOI FORMAT CONSTANTS
+ * ============================================================================ */
+
+#define QOI_HEADER_SIZE  14        /**< Magic, width, height, channels, colorspace */
+#define QOI_BUFFER_SIZE  65536     /**< Size of the encoder and decoder I/O buffers */
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @struct t_qoi_encoder
+ * @brief State of a row-by-row QOI encoder
+ */
+typedef struct {
+    FILE *file;                       /**< Output file */
+    unsigned int width;               /**< Image width in pixels */
+    unsigned int height;              /**< Image height in pixels */
+    int channels;                     /**< 3 (RGB, "qoif") or 1 (gray, "qoig") */
+    unsigned int rowsDone;            /**< Rows encoded so far */
+    uint8_t index[64][4];             /**< Recently seen pixels, indexed by hash */
+    uint8_t prev[4];                  /**< Previous pixel (RGBA or gray) */
+    int run;                          /**< Length of the current run of equal pixels */
+    size_t length;                    /**< Bytes waiting in buffer */
+    uint8_t buffer[QOI_BUFFER_SIZE];  /**< Output buffer */
+} t_qoi_encoder;
+
+/**
+ * @struct t_qoi_decoder
+ * @brief State of a row-by-row QOI decoder
+ */
+typedef struct {
+    FILE *file;                       /**< Input file */
+    unsigned int width;               /**< Image width in pixels */
+    unsigned int height;              /**< Image height in pixels */
+    int channels;                     /**< Channels of each output row: 3 or 1 */
+    int gray;                         /**< Non-zero for the grayscale variant */
+    uint8_t index[64][4];             /**< Recently seen pixels, indexed by hash */
+    uint8_t prev[4];                  /**< Previous pixel (RGBA or gray) */
+    int run;                          /**< Remaining repetitions of prev */
+    size_t position;                  /**< Next byte to read in buffer */
+    size_t length;                    /**< Bytes available in buffer */
+    uint8_t buffer[QOI_BUFFER_SIZE];  /**< Input buffer */
+} t_qoi_decoder;
+
+/* ============================================================================
+ * STREAMING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Create a QOI file and write its header
+ * @param filename Path of the file to create
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param channels 3 for RGB rows, 1 for grayscale rows
+ * @return Encoder to feed with qoi_encodeRow, or NULL on failure
+ */
+t_qoi_encoder *qoi_encoderOpen(const char *filename, unsigned int width, unsigned int height, int channels);
+
+/**
+ * @brief Encode the next row of the image
+ * @param enc Encoder returned by qoi_encoderOpen
+ * @param row width * channels bytes (R, G, B order for color), top row first
+ * @return 1 on success, 0 on failure
+ */
+int qoi_encodeRow(t_qoi_encoder *enc, const uint8_t *row);
+
+/**
+ * @brief Finish the file and free the encoder
+ * @param enc Encoder returned by qoi_encoderOpen
+ * @return 1 if every row was encoded and written, 0 otherwise
+ */
+int qoi_encoderClose(t_qoi_encoder *enc);
+
+/**
+ * @brief Open a QOI file and read its header
+ * @param filename Path of the file to read
+ * @return Decoder with width, height and channels filled in, or NULL on failure
+ *
+ * Standard 4-channel files are accepted; alpha is dropped from the rows.
+ */
+t_qoi_decoder *qoi_decoderOpen(const char *filename);
+
+/**
+ * @brief Decode the next row of the image
+ * @param dec Decoder returned by qoi_decoderOpen
+ * @param row Destination of width * channels bytes, top row first
+ * @return 1 on success, 0 if the data is truncated
+ */
+int qoi_decodeRow(t_qoi_decoder *dec, uint8_t *row);
+
+/**
+ * @brief Close the file and free the decoder
+ * @param dec Decoder returned by qoi_decoderOpen
+ */
+void qoi_decoderClose(t_qoi_decoder *dec);
+
+/* ============================================================================
+ * IMAGE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Save a 24-bit image as a QOI file
+ * @param img Pointer to the image to save
+ * @param filename Path where to save the file
+ */
+void bmp24_saveQOI(t_bmp24 *img, const char *filename);
+
+/**
+ * @brief Load a 24-bit image from a QOI file
+ * @param filename Path of the QOI file
+ * @return Pointer to the loaded image, or NULL on failure
+ */
+t_bmp24 *bmp24_loadQOI(const char *filename);
+
+/**
+ * @brief Save an 8-bit grayscale image in the single-channel QOI variant
+ * @param filename Path where to save the file
+ * @param img Pointer to the image to save
+ *
+ * Only pixel values are stored; the image is read back with an identity
+ * grayscale color table.
+ */
+void bmp8_saveQOI(const char *filename, t_bmp8 *img);
+
+/**
+ * @brief Load an 8-bit grayscale image from a single-channel QOI file
+ * @param filename Path of the QOI file
+ * @return Pointer to the loaded image, or NULL on failure
+ */
+t_bmp8 *bmp8_loadQOI(const char *filename);
+
+#endif //QOI_H
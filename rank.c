@@ -0,0 +1,208 @@
+/**
+ * @file rank.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Median and rank filters of image views
+ *
+ */
+
+#include "rank.h"
+#include "scratch.h"
+#include <stdio.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define RANK_VALUES     256
+#define RANK_COARSE     16
+#define RANK_SEGMENT    (RANK_VALUES / RANK_COARSE)     // Fine bins per coarse bin
+#define RANK_BINS       (RANK_VALUES + RANK_COARSE)     // Fine bins, then coarse bins
+
+// ========================================
+// HISTOGRAMS
+// ========================================
+
+
+static unsigned int rank_clamp(int position, int size)
+{
+    if (position < 0)
+        return 0;
+    return position >= size ? (unsigned int)(size - 1) : (unsigned int)position;
+}
+
+
+static void rank_count(uint16_t *histogram, uint8_t value, int delta)
+{
+    histogram[value] = (uint16_t)(histogram[value] + delta);
+    histogram[RANK_VALUES + (value >> 4)] = (uint16_t)(histogram[RANK_VALUES + (value >> 4)] + delta);
+}
+
+
+// sum += add, count a multiple of 8
+static void rank_add(uint16_t *sum, const uint16_t *add, int count)
+{
+#if defined(__SSE2__)
+    for (int i = 0; i < count; i += 8) {
+        __m128i total = _mm_add_epi16(_mm_loadu_si128((const __m128i *)(sum + i)),
+                                      _mm_loadu_si128((const __m128i *)(add + i)));
+        _mm_storeu_si128((__m128i *)(sum + i), total);
+    }
+#else
+    for (int i = 0; i < count; i++)
+        sum[i] = (uint16_t)(sum[i] + add[i]);
+#endif
+}
+
+
+// sum += add - sub, count a multiple of 8
+static void rank_slide(uint16_t *sum, const uint16_t *add, const uint16_t *sub, int count)
+{
+#if defined(__SSE2__)
+    for (int i = 0; i < count; i += 8) {
+        __m128i total = _mm_add_epi16(_mm_loadu_si128((const __m128i *)(sum + i)),
+                                      _mm_loadu_si128((const __m128i *)(add + i)));
+        total = _mm_sub_epi16(total, _mm_loadu_si128((const __m128i *)(sub + i)));
+        _mm_storeu_si128((__m128i *)(sum + i), total);
+    }
+#else
+    for (int i = 0; i < count; i++)
+        sum[i] = (uint16_t)(sum[i] + add[i] - sub[i]);
+#endif
+}
+
+
+// Bring the fine bins of one coarse bin of the square up to column x. They
+// are only updated when a rank falls into them, from the column they were
+// last updated at, or summed again when the square moved past all its columns
+static void rank_catchUp(uint16_t *kernel, int *updated, const uint16_t *histograms,
+                         int bin, int x, int radius)
+{
+    int offset = bin * RANK_SEGMENT;
+    uint16_t *fine = kernel + offset;
+    if (x - updated[bin] > 2 * radius) {
+        memset(fine, 0, RANK_SEGMENT * sizeof(uint16_t));
+        for (int i = x; i <= x + 2 * radius; i++)
+            rank_add(fine, histograms + (size_t)i * RANK_BINS + offset, RANK_SEGMENT);
+    } else {
+        for (int i = updated[bin] + 1; i <= x; i++)
+            rank_slide(fine, histograms + (size_t)(i + 2 * radius) * RANK_BINS + offset,
+                       histograms + (size_t)(i - 1) * RANK_BINS + offset, RANK_SEGMENT);
+    }
+    updated[bin] = x;
+}
+
+
+// Value of the given rank (0 for the smallest) in the square at column x;
+// rank is below the count
+static uint8_t rank_find(uint16_t *kernel, int *updated, const uint16_t *histograms,
+                         unsigned int rank, int x, int radius)
+{
+    const uint16_t *coarse = kernel + RANK_VALUES;
+    unsigned int below = 0;
+    int bin = 0;
+    while (below + coarse[bin] <= rank)
+        below += coarse[bin++];
+
+    rank_catchUp(kernel, updated, histograms, bin, x, radius);
+    int value = bin * RANK_SEGMENT;
+    while (below + kernel[value] <= rank)
+        below += kernel[value++];
+    return (uint8_t)value;
+}
+
+// ========================================
+// RANK FILTER
+// ========================================
+
+
+// Output columns x0 to x1 - 1, every row
+static int rank_stripe(const t_image_view *src, t_image_view *dst, int radius, unsigned int rank,
+                       int x0, int x1)
+{
+    int width = (int)src->width, height = (int)src->height;
+    int channels = (int)src->format;
+    int columns = x1 - x0 + 2 * radius;
+
+    // One histogram per column from x0 - radius to x1 + radius - 1, then the square
+    size_t mark = scratch_mark();
+    uint16_t *histograms = scratch_alloc((size_t)(columns + 1) * RANK_BINS * sizeof(uint16_t));
+    int *offsets = scratch_alloc((size_t)columns * sizeof(int));
+    int updated[RANK_COARSE];
+    if (!histograms || !offsets) {
+        scratch_release(mark);
+        return 0;
+    }
+    uint16_t *kernel = histograms + (size_t)columns * RANK_BINS;
+    for (int i = 0; i < columns; i++)
+        offsets[i] = (int)rank_clamp(x0 - radius + i, width) * channels;
+
+    for (int c = 0; c < channels; c++) {
+        memset(histograms, 0, (size_t)columns * RANK_BINS * sizeof(uint16_t));
+        for (int j = -radius; j <= radius; j++) {
+            const uint8_t *row = view_row(src, rank_clamp(j, height)) + c;
+            for (int i = 0; i < columns; i++)
+                rank_count(histograms + (size_t)i * RANK_BINS, row[offsets[i]], 1);
+        }
+
+        for (int y = 0; y < height; y++) {
+            // Move the column histograms down one row
+            unsigned int leaving = rank_clamp(y - radius - 1, height);
+            unsigned int entering = rank_clamp(y + radius, height);
+            if (y > 0 && leaving != entering) {
+                const uint8_t *out = view_row(src, leaving) + c;
+                const uint8_t *in = view_row(src, entering) + c;
+                for (int i = 0; i < columns; i++) {
+                    uint16_t *histogram = histograms + (size_t)i * RANK_BINS;
+                    rank_count(histogram, out[offsets[i]], -1);
+                    rank_count(histogram, in[offsets[i]], 1);
+                }
+            }
+
+            // Coarse bins of the square at the first column, then slide them
+            // right; fine bins follow only when needed
+            uint16_t *coarse = kernel + RANK_VALUES;
+            memcpy(coarse, histograms + RANK_VALUES, RANK_COARSE * sizeof(uint16_t));
+            for (int i = 1; i <= 2 * radius; i++)
+                rank_add(coarse, histograms + (size_t)i * RANK_BINS + RANK_VALUES, RANK_COARSE);
+            for (int bin = 0; bin < RANK_COARSE; bin++)
+                updated[bin] = -2 * radius - 1;
+
+            uint8_t *row = view_row(dst, (unsigned int)y) + (size_t)x0 * channels + c;
+            row[0] = rank_find(kernel, updated, histograms, rank, 0, radius);
+            for (int x = 1; x < x1 - x0; x++) {
+                rank_slide(coarse, histograms + (size_t)(x + 2 * radius) * RANK_BINS + RANK_VALUES,
+                           histograms + (size_t)(x - 1) * RANK_BINS + RANK_VALUES, RANK_COARSE);
+                row[(size_t)x * channels] = rank_find(kernel, updated, histograms, rank, x, radius);
+            }
+        }
+    }
+
+    scratch_release(mark);
+    return 1;
+}
+
+
+int view_rankFilter(const t_image_view *src, t_image_view *dst, int radius, int percentile)
+{
+    if (src->format != dst->format || src->width != dst->width || src->height != dst->height
+        || src->width == 0 || src->height == 0 || radius < 1 || radius > RANK_MAX_RADIUS
+        || percentile < 0 || percentile > 100)
+        return 0;
+
+    unsigned int side = 2 * (unsigned int)radius + 1;
+    unsigned int rank = (unsigned int)percentile * (side * side - 1) / 100;
+
+    int width = (int)src->width;
+    int stripes = (width + RANK_STRIPE_COLUMNS - 1) / RANK_STRIPE_COLUMNS;
+    int failed = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(|:failed)
+    for (int stripe = 0; stripe < stripes; stripe++) {
+        int x0 = stripe * RANK_STRIPE_COLUMNS;
+        int x1 = width - x0 < RANK_STRIPE_COLUMNS ? width : x0 + RANK_STRIPE_COLUMNS;
+        failed |= !rank_stripe(src, dst, radius, rank, x0, x1);
+    }
+
+    if (failed)
+        printf("Error: Not enough memory for the rank filter\n");
+    return !failed;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file rank.h
+ * @brief Median and rank filters of image views
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines the rank filters: each output pixel is the value
+ * of a given rank among the (2 * radius + 1)^2 pixels of the square around
+ * it, per channel. Percentile 50 is the median, which removes noise without
+ * blurring edges; 0 is the minimum and 100 the maximum.
+ *
+ * The cost does not depend on the radius (Perreault and Hebert):
+ * - Every column keeps the histogram of the 2 * radius + 1 pixels above and
+ *   below the current row; going down one row removes one pixel and adds
+ *   one in each column
+ * - The histogram of the square is the sum of 2 * radius + 1 column
+ *   histograms; going right one pixel adds the column entering and
+ *   subtracts the one leaving, 8 bins at a time with SSE2
+ * - Histograms have 16 coarse bins of 16 values each on top of the 256
+ *   fine bins. Only the coarse bins of the square slide with every pixel;
+ *   the 16 fine bins of a coarse bin are brought up to date when a rank
+ *   falls into them, which on real images is mostly the same few bins
+ * - The image is cut into vertical stripes of RANK_STRIPE_COLUMNS columns,
+ *   each with its own column histograms, which run in parallel with OpenMP
+ *
+ * Pixels beyond the edges repeat the edge pixel.
+ */
+
+#ifndef RANK_H
+#define RANK_H
+
+#include "imageview.h"
+
+/* ============================================================================
+ * RANK FILTER CONSTANTS
+ * ============================================================================ */
+
+#define RANK_MAX_RADIUS     127     /**< Largest radius (counts of a square fit 16 bits) */
+#define RANK_STRIPE_COLUMNS 512     /**< Output columns computed by one stripe */
+#define RANK_MEDIAN         50      /**< Percentile of the median */
+
+/* ============================================================================
+ * RANK FILTER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Draw a view through a rank filter
+ * @param src Source pixels (not modified)
+ * @param dst Destination of the same size and format, not overlapping src
+ * @param radius Half side of the square, from 1 to RANK_MAX_RADIUS
+ * @param percentile Rank of the value kept, from 0 (minimum) to 100
+ *                   (maximum); RANK_MEDIAN for the median
+ * @return 1 on success, 0 if the views do not match, a parameter is out of
+ *         range or memory is missing
+ *
+ * Among the n values of the square, the value kept is the one of rank
+ * percentile * (n - 1) / 100 in increasing order.
+ */
+int view_rankFilter(const t_image_view *src, t_image_view *dst, int radius, int percentile);
+
+#endif //RANK_H
@@ -0,0 +1,571 @@
+/**
+ * @file resize.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Resizing of image views with separable filters
+ *
+ */
+
+#include "resize.h"
+#include "scratch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define RESIZE_ONE      (1 << RESIZE_WEIGHT_BITS)
+#define RESIZE_HALF     (1 << (RESIZE_WEIGHT_BITS - 1))
+#define RESIZE_PI       3.14159265358979323846
+
+// Fractional bits kept between the two passes of a resize; overshoot of
+// bicubic and Lanczos stays well inside 16 bits
+#define RESIZE_EXTRA_BITS   6
+#define RESIZE_WIDE_HALF    (1 << (RESIZE_WEIGHT_BITS - RESIZE_EXTRA_BITS - 1))
+#define RESIZE_NARROW_HALF  (1 << (RESIZE_WEIGHT_BITS + RESIZE_EXTRA_BITS - 1))
+
+// ========================================
+// FILTERS
+// ========================================
+
+
+static double resize_sinc(double x)
+{
+    if (x == 0.0)
+        return 1.0;
+    x *= RESIZE_PI;
+    return sin(x) / x;
+}
+
+
+// Distance from the centre, in source pixels, where the filter becomes 0
+static double resize_support(t_sampling filter, double scale)
+{
+    switch (filter) {
+        case SAMPLE_AREA:     return scale / 2.0 + 0.5;
+        case SAMPLE_BICUBIC:  return 2.0 * scale;
+        case SAMPLE_LANCZOS3: return 3.0 * scale;
+        default:              return scale;
+    }
+}
+
+
+// Weight of source pixel j for an output pixel centred on center
+static double resize_weight(t_sampling filter, double scale, double center, int j)
+{
+    if (filter == SAMPLE_AREA) {
+        // Length of the source pixel inside the output pixel
+        double left = fmax(j - 0.5, center - scale / 2.0);
+        double right = fmin(j + 0.5, center + scale / 2.0);
+        return right > left ? right - left : 0.0;
+    }
+
+    double t = fabs(j - center) / scale;
+    switch (filter) {
+        case SAMPLE_BICUBIC:
+            // Keys cubic convolution with a = -0.5
+            if (t < 1.0) return (1.5 * t - 2.5) * t * t + 1.0;
+            if (t < 2.0) return ((-0.5 * t + 2.5) * t - 4.0) * t + 2.0;
+            return 0.0;
+        case SAMPLE_LANCZOS3:
+            return t < 3.0 ? resize_sinc(t) * resize_sinc(t / 3.0) : 0.0;
+        default:
+            return t < 1.0 ? 1.0 - t : 0.0;
+    }
+}
+
+// ========================================
+// WEIGHT TABLES
+// ========================================
+
+
+static void resize_freeAxis(t_resize_axis *axis)
+{
+    if (!axis)
+        return;
+    free(axis->start);
+    free(axis->weights);
+    free(axis);
+}
+
+
+static t_resize_axis * resize_computeAxis(unsigned int srcSize, unsigned int dstSize, t_sampling filter)
+{
+    double scale = (double)srcSize / dstSize;
+    double filterScale = scale > 1.0 ? scale : 1.0;   // Widened when shrinking
+    double support = resize_support(filter, filterScale);
+
+    t_resize_axis *axis = calloc(1, sizeof(t_resize_axis));
+    if (!axis)
+        return NULL;
+    axis->srcSize = srcSize;
+    axis->dstSize = dstSize;
+    axis->filter = filter;
+    axis->taps = filter == SAMPLE_NEAREST ? 1 : (int)floor(2.0 * support) + 1;
+    if (axis->taps > (int)srcSize)
+        axis->taps = (int)srcSize;
+
+    int taps = axis->taps;
+    axis->start = malloc(dstSize * sizeof(int));
+    axis->weights = malloc((size_t)dstSize * taps * sizeof(int16_t));
+    double *weights = malloc(taps * sizeof(double));
+    if (!axis->start || !axis->weights || !weights) {
+        printf("Error: Failed to allocate the resize weights\n");
+        free(weights);
+        resize_freeAxis(axis);
+        return NULL;
+    }
+
+    for (unsigned int i = 0; i < dstSize; i++) {
+        double center = (i + 0.5) * scale - 0.5;
+        int16_t *fixed = axis->weights + (size_t)i * taps;
+
+        if (filter == SAMPLE_NEAREST) {
+            int j = (int)floor(center + 0.5);
+            axis->start[i] = j < 0 ? 0 : (j >= (int)srcSize ? (int)srcSize - 1 : j);
+            fixed[0] = RESIZE_ONE;
+            continue;
+        }
+
+        // Pixels beyond an edge count as the edge pixel: their weight is
+        // added to it, which keeps the window inside the source
+        int left = (int)ceil(center - support);
+        int right = (int)floor(center + support);
+        int first = left < 0 ? 0 : left;
+        if (first > (int)srcSize - taps)
+            first = (int)srcSize - taps;
+        axis->start[i] = first;
+
+        memset(weights, 0, taps * sizeof(double));
+        double sum = 0.0;
+        for (int j = left; j <= right; j++) {
+            int k = (j < 0 ? 0 : (j >= (int)srcSize ? (int)srcSize - 1 : j)) - first;
+            double w = resize_weight(filter, filterScale, center, j);
+            weights[k] += w;
+            sum += w;
+        }
+
+        // Rounded to fixed point; the rounding error goes to the largest weight
+        int total = 0, largest = 0;
+        for (int k = 0; k < taps; k++) {
+            fixed[k] = (int16_t)lround(weights[k] / sum * RESIZE_ONE);
+            total += fixed[k];
+            if (abs(fixed[k]) > abs(fixed[largest]))
+                largest = k;
+        }
+        fixed[largest] = (int16_t)(fixed[largest] + RESIZE_ONE - total);
+    }
+    free(weights);
+    return axis;
+}
+
+// ========================================
+// WEIGHT TABLE CACHE
+// ========================================
+
+// Most recently used first
+static t_resize_axis *resize_cache[RESIZE_CACHE_AXES];
+static int resize_cacheCount = 0;
+static unsigned long resize_hits = 0;
+static unsigned long resize_misses = 0;
+
+// Held for a few instructions at a time: a spin lock is enough
+static atomic_flag resize_lock = ATOMIC_FLAG_INIT;
+
+static void resize_acquire(void)
+{
+    while (atomic_flag_test_and_set_explicit(&resize_lock, memory_order_acquire))
+        ;
+}
+
+static void resize_releaseLock(void)
+{
+    atomic_flag_clear_explicit(&resize_lock, memory_order_release);
+}
+
+
+t_resize_axis * resize_getAxis(unsigned int srcSize, unsigned int dstSize, t_sampling filter)
+{
+    if (srcSize == 0 || dstSize == 0 || filter > SAMPLE_LANCZOS3)
+        return NULL;
+
+    resize_acquire();
+    for (int i = 0; i < resize_cacheCount; i++) {
+        t_resize_axis *axis = resize_cache[i];
+        if (axis->srcSize == srcSize && axis->dstSize == dstSize && axis->filter == filter) {
+            memmove(resize_cache + 1, resize_cache, i * sizeof(t_resize_axis *));
+            resize_cache[0] = axis;
+            axis->refs++;
+            resize_hits++;
+            resize_releaseLock();
+            return axis;
+        }
+    }
+    resize_releaseLock();
+
+    // Computed without the lock; a table computed twice at the same time
+    // is only a wasted entry
+    t_resize_axis *axis = resize_computeAxis(srcSize, dstSize, filter);
+    if (!axis)
+        return NULL;
+
+    t_resize_axis *evicted = NULL;
+    resize_acquire();
+    resize_misses++;
+    if (resize_cacheCount == RESIZE_CACHE_AXES) {
+        evicted = resize_cache[--resize_cacheCount];
+        evicted->cached = 0;
+        if (evicted->refs > 0)
+            evicted = NULL;   // Freed by its last resize_releaseAxis
+    }
+    memmove(resize_cache + 1, resize_cache, resize_cacheCount * sizeof(t_resize_axis *));
+    resize_cache[0] = axis;
+    resize_cacheCount++;
+    axis->refs = 1;
+    axis->cached = 1;
+    resize_releaseLock();
+
+    resize_freeAxis(evicted);
+    return axis;
+}
+
+
+void resize_releaseAxis(t_resize_axis *axis)
+{
+    if (!axis)
+        return;
+    resize_acquire();
+    axis->refs--;
+    int unused = axis->refs == 0 && !axis->cached;
+    resize_releaseLock();
+    if (unused)
+        resize_freeAxis(axis);
+}
+
+
+t_resize_stats resize_getStats(void)
+{
+    resize_acquire();
+    t_resize_stats stats = {resize_hits, resize_misses, resize_cacheCount};
+    resize_releaseLock();
+    return stats;
+}
+
+
+void resize_clearCache(void)
+{
+    t_resize_axis *unused[RESIZE_CACHE_AXES];
+    int count = 0;
+
+    resize_acquire();
+    for (int i = 0; i < resize_cacheCount; i++) {
+        resize_cache[i]->cached = 0;
+        if (resize_cache[i]->refs == 0)
+            unused[count++] = resize_cache[i];
+    }
+    resize_cacheCount = 0;
+    resize_releaseLock();
+
+    for (int i = 0; i < count; i++)
+        resize_freeAxis(unused[i]);
+}
+
+// ========================================
+// RESIZE PASSES
+// ========================================
+
+
+// Rounded fixed-point sum back to a channel value; filters with negative
+// lobes can go past 0 or 255
+static inline uint8_t resize_clamp(int sum)
+{
+    sum >>= RESIZE_WEIGHT_BITS;
+    return (uint8_t)(sum < 0 ? 0 : (sum > 255 ? 255 : sum));
+}
+
+
+// First pass of two: the sum keeps RESIZE_EXTRA_BITS fractional bits and
+// its overshoot, so that only the final value is rounded and clamped
+static inline int16_t resize_widen(int sum)
+{
+    sum >>= RESIZE_WEIGHT_BITS - RESIZE_EXTRA_BITS;
+    return (int16_t)(sum < INT16_MIN ? INT16_MIN : (sum > INT16_MAX ? INT16_MAX : sum));
+}
+
+
+// Second pass of two: sum of widened values back to a channel value
+static inline uint8_t resize_narrow(int sum)
+{
+    sum >>= RESIZE_WEIGHT_BITS + RESIZE_EXTRA_BITS;
+    return (uint8_t)(sum < 0 ? 0 : (sum > 255 ? 255 : sum));
+}
+
+
+// One source row resized horizontally, into out, or into wide when a
+// vertical pass follows
+static void resize_horizontal(const uint8_t *in, uint8_t *out, int16_t *wide, const t_resize_axis *axis,
+                              t_view_format format)
+{
+    int taps = axis->taps;
+    const int16_t *weights = axis->weights;
+    int half = wide ? RESIZE_WIDE_HALF : RESIZE_HALF;
+
+    if (format == VIEW_GRAY8) {
+        for (unsigned int x = 0; x < axis->dstSize; x++, weights += taps) {
+            const uint8_t *pixel = in + axis->start[x];
+            int sum = half;
+            for (int k = 0; k < taps; k++)
+                sum += pixel[k] * weights[k];
+            if (wide) wide[x] = resize_widen(sum);
+            else out[x] = resize_clamp(sum);
+        }
+        return;
+    }
+
+    for (unsigned int x = 0; x < axis->dstSize; x++, weights += taps) {
+        const uint8_t *pixel = in + (size_t)axis->start[x] * 3;
+        int red = half, green = half, blue = half;
+        for (int k = 0; k < taps; k++, pixel += 3) {
+            red += pixel[0] * weights[k];
+            green += pixel[1] * weights[k];
+            blue += pixel[2] * weights[k];
+        }
+        if (wide) {
+            wide[3 * x] = resize_widen(red);
+            wide[3 * x + 1] = resize_widen(green);
+            wide[3 * x + 2] = resize_widen(blue);
+        } else {
+            out[3 * x] = resize_clamp(red);
+            out[3 * x + 1] = resize_clamp(green);
+            out[3 * x + 2] = resize_clamp(blue);
+        }
+    }
+}
+
+
+// Horizontal pass of a row already combined vertically
+static void resize_horizontalWide(const int16_t *in, uint8_t *out, const t_resize_axis *axis,
+                                  t_view_format format)
+{
+    int taps = axis->taps;
+    const int16_t *weights = axis->weights;
+
+    if (format == VIEW_GRAY8) {
+        for (unsigned int x = 0; x < axis->dstSize; x++, weights += taps) {
+            const int16_t *pixel = in + axis->start[x];
+            int sum = RESIZE_NARROW_HALF;
+            for (int k = 0; k < taps; k++)
+                sum += pixel[k] * weights[k];
+            out[x] = resize_narrow(sum);
+        }
+        return;
+    }
+
+    for (unsigned int x = 0; x < axis->dstSize; x++, weights += taps, out += 3) {
+        const int16_t *pixel = in + (size_t)axis->start[x] * 3;
+        int red = RESIZE_NARROW_HALF, green = RESIZE_NARROW_HALF, blue = RESIZE_NARROW_HALF;
+        for (int k = 0; k < taps; k++, pixel += 3) {
+            red += pixel[0] * weights[k];
+            green += pixel[1] * weights[k];
+            blue += pixel[2] * weights[k];
+        }
+        out[0] = resize_narrow(red);
+        out[1] = resize_narrow(green);
+        out[2] = resize_narrow(blue);
+    }
+}
+
+
+// One output row from taps rows spaced by stride: every byte is a weighted
+// sum of the bytes below it, so both formats are handled as bytes. The row
+// goes to out, or to wide when a horizontal pass follows
+static void resize_vertical(const uint8_t *rows, ptrdiff_t stride, const int16_t *weights, int taps,
+                            uint8_t *out, int16_t *wide, size_t count)
+{
+    size_t i = 0;
+    int half = wide ? RESIZE_WIDE_HALF : RESIZE_HALF;
+
+#if defined(__SSE2__)
+    // Two rows at a time: their bytes are interleaved as 16-bit pairs and
+    // multiplied by the pair of weights with one madd
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        __m128i low = _mm_set1_epi32(half);
+        __m128i high = low;
+        const uint8_t *row = rows + i;
+        int k = 0;
+        for (; k + 1 < taps; k += 2, row += 2 * stride) {
+            __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)row), zero);
+            __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(row + stride)), zero);
+            __m128i pair = _mm_set1_epi32((int)((uint16_t)weights[k] | ((uint32_t)(uint16_t)weights[k + 1] << 16)));
+            low = _mm_add_epi32(low, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), pair));
+            high = _mm_add_epi32(high, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), pair));
+        }
+        if (k < taps) {
+            __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)row), zero);
+            __m128i single = _mm_set1_epi32((uint16_t)weights[k]);
+            low = _mm_add_epi32(low, _mm_madd_epi16(_mm_unpacklo_epi16(a, zero), single));
+            high = _mm_add_epi32(high, _mm_madd_epi16(_mm_unpackhi_epi16(a, zero), single));
+        }
+        if (wide) {
+            low = _mm_srai_epi32(low, RESIZE_WEIGHT_BITS - RESIZE_EXTRA_BITS);
+            high = _mm_srai_epi32(high, RESIZE_WEIGHT_BITS - RESIZE_EXTRA_BITS);
+            _mm_storeu_si128((__m128i *)(wide + i), _mm_packs_epi32(low, high));
+        } else {
+            low = _mm_srai_epi32(low, RESIZE_WEIGHT_BITS);
+            high = _mm_srai_epi32(high, RESIZE_WEIGHT_BITS);
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(low, high), zero);
+            _mm_storel_epi64((__m128i *)(out + i), packed);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        const uint8_t *row = rows + i;
+        int sum = half;
+        for (int k = 0; k < taps; k++, row += stride)
+            sum += *row * weights[k];
+        if (wide) wide[i] = resize_widen(sum);
+        else out[i] = resize_clamp(sum);
+    }
+}
+
+
+// Vertical pass of rows already resized horizontally; stride is in values
+static void resize_verticalWide(const int16_t *rows, ptrdiff_t stride, const int16_t *weights, int taps,
+                                uint8_t *out, size_t count)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        __m128i low = _mm_set1_epi32(RESIZE_NARROW_HALF);
+        __m128i high = low;
+        const int16_t *row = rows + i;
+        int k = 0;
+        for (; k + 1 < taps; k += 2, row += 2 * stride) {
+            __m128i a = _mm_loadu_si128((const __m128i *)row);
+            __m128i b = _mm_loadu_si128((const __m128i *)(row + stride));
+            __m128i pair = _mm_set1_epi32((int)((uint16_t)weights[k] | ((uint32_t)(uint16_t)weights[k + 1] << 16)));
+            low = _mm_add_epi32(low, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), pair));
+            high = _mm_add_epi32(high, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), pair));
+        }
+        if (k < taps) {
+            __m128i a = _mm_loadu_si128((const __m128i *)row);
+            __m128i single = _mm_set1_epi32((uint16_t)weights[k]);
+            low = _mm_add_epi32(low, _mm_madd_epi16(_mm_unpacklo_epi16(a, zero), single));
+            high = _mm_add_epi32(high, _mm_madd_epi16(_mm_unpackhi_epi16(a, zero), single));
+        }
+        low = _mm_srai_epi32(low, RESIZE_WEIGHT_BITS + RESIZE_EXTRA_BITS);
+        high = _mm_srai_epi32(high, RESIZE_WEIGHT_BITS + RESIZE_EXTRA_BITS);
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(low, high), zero);
+        _mm_storel_epi64((__m128i *)(out + i), packed);
+    }
+#endif
+
+    for (; i < count; i++) {
+        const int16_t *row = rows + i;
+        int sum = RESIZE_NARROW_HALF;
+        for (int k = 0; k < taps; k++, row += stride)
+            sum += *row * weights[k];
+        out[i] = resize_narrow(sum);
+    }
+}
+
+
+// Output rows y0 to y1 - 1: horizontal pass on the source rows they need,
+// then vertical pass (the other way round when shrinking the height). When
+// both axes change, the pass in between is kept in 16 bits
+static int resize_band(const t_image_view *src, t_image_view *dst, const t_resize_axis *columns,
+                       const t_resize_axis *rows, unsigned int y0, unsigned int y1)
+{
+    size_t rowBytes = (size_t)dst->width * dst->format;
+    int sameWidth = src->width == dst->width;
+
+    if (src->height == dst->height) {
+        for (unsigned int y = y0; y < y1; y++) {
+            if (sameWidth) memcpy(view_row(dst, y), view_row(src, y), rowBytes);
+            else resize_horizontal(view_row(src, y), view_row(dst, y), NULL, columns, src->format);
+        }
+        return 1;
+    }
+
+    if (sameWidth) {
+        for (unsigned int y = y0; y < y1; y++)
+            resize_vertical(view_row(src, (unsigned int)rows->start[y]), src->stride,
+                            rows->weights + (size_t)y * rows->taps, rows->taps, view_row(dst, y), NULL, rowBytes);
+        return 1;
+    }
+
+    size_t mark = scratch_mark();
+    if (dst->height < src->height) {
+        // Fewer output rows: combining rows first leaves the horizontal
+        // pass, which has no SIMD version, one row per output row
+        size_t srcValues = (size_t)src->width * src->format;
+        int16_t *combined = scratch_alloc(srcValues * sizeof(int16_t));
+        if (!combined) {
+            scratch_release(mark);
+            return 0;
+        }
+        for (unsigned int y = y0; y < y1; y++) {
+            resize_vertical(view_row(src, (unsigned int)rows->start[y]), src->stride,
+                            rows->weights + (size_t)y * rows->taps, rows->taps, NULL, combined, srcValues);
+            resize_horizontalWide(combined, view_row(dst, y), columns, src->format);
+        }
+        scratch_release(mark);
+        return 1;
+    }
+
+    int first = rows->start[y0];
+    int count = rows->start[y1 - 1] + rows->taps - first;
+    int16_t *resized = scratch_alloc((size_t)count * rowBytes * sizeof(int16_t));
+    if (!resized) {
+        scratch_release(mark);
+        return 0;
+    }
+    for (int r = 0; r < count; r++)
+        resize_horizontal(view_row(src, (unsigned int)(first + r)), NULL, resized + r * rowBytes, columns,
+                          src->format);
+
+    for (unsigned int y = y0; y < y1; y++)
+        resize_verticalWide(resized + (rows->start[y] - first) * rowBytes, (ptrdiff_t)rowBytes,
+                            rows->weights + (size_t)y * rows->taps, rows->taps, view_row(dst, y), rowBytes);
+    scratch_release(mark);
+    return 1;
+}
+
+
+int view_resize(const t_image_view *src, t_image_view *dst, t_sampling filter)
+{
+    if (src->format != dst->format || src->width == 0 || src->height == 0
+        || dst->width == 0 || dst->height == 0)
+        return 0;
+
+    // An axis that keeps its size needs no weights
+    t_resize_axis *columns = NULL, *rows = NULL;
+    if (src->width != dst->width)
+        columns = resize_getAxis(src->width, dst->width, filter);
+    if (src->height != dst->height)
+        rows = resize_getAxis(src->height, dst->height, filter);
+    int failed = filter > SAMPLE_LANCZOS3 || (src->width != dst->width && !columns)
+                 || (src->height != dst->height && !rows);
+
+    if (!failed) {
+        int bands = (int)((dst->height + RESIZE_BAND_ROWS - 1) / RESIZE_BAND_ROWS);
+        #pragma omp parallel for schedule(dynamic) reduction(|:failed)
+        for (int band = 0; band < bands; band++) {
+            unsigned int y0 = (unsigned int)band * RESIZE_BAND_ROWS;
+            unsigned int y1 = dst->height - y0 < RESIZE_BAND_ROWS ? dst->height : y0 + RESIZE_BAND_ROWS;
+            failed |= !resize_band(src, dst, columns, rows, y0, y1);
+        }
+    }
+
+    resize_releaseAxis(columns);
+    resize_releaseAxis(rows);
+    if (failed)
+        printf("Error: Not enough memory to resize the image\n");
+    return !failed;
+}
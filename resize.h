@@ -0,0 +1,122 @@
+/**
+ * @file resize.h
+ * @brief Resizing of image views with separable filters
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines the resize engine used by bmp8_resize and
+ * bmp24_resize. A resize is done in two separable passes:
+ * - For each axis, a table gives the first source pixel and the fixed-point
+ *   weights of every output pixel (area, bilinear, bicubic or Lanczos-3,
+ *   widened by the reduction factor when shrinking so nothing aliases)
+ * - The horizontal pass resizes the source rows of a band of output rows,
+ *   the vertical pass then combines these rows, 8 pixels at a time with SSE2
+ * - When the height shrinks, rows are combined first instead, so the scalar
+ *   horizontal pass only runs once per output row
+ * - Between the two passes values are kept in 16 bits with 6 fractional
+ *   bits and without clamping, so the overshoot of bicubic and Lanczos
+ *   reaches the second pass and only the final value is rounded and clamped
+ * - Bands of RESIZE_BAND_ROWS output rows are independent and run in
+ *   parallel with OpenMP
+ *
+ * Weight tables only depend on the sizes and the filter, so the last
+ * RESIZE_CACHE_AXES tables are kept: a batch of images with the same
+ * geometry computes them once.
+ */
+
+#ifndef RESIZE_H
+#define RESIZE_H
+
+#include <stdint.h>
+#include "imageview.h"
+
+/* ============================================================================
+ * RESIZE CONSTANTS
+ * ============================================================================ */
+
+#define RESIZE_BAND_ROWS    64      /**< Output rows computed by one band */
+#define RESIZE_CACHE_AXES   16      /**< Weight tables kept for later resizes */
+#define RESIZE_WEIGHT_BITS  14      /**< Fixed-point precision of the weights */
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @struct t_resize_axis
+ * @brief Weights of one axis of a resize
+ *
+ * Output pixel i is the sum of source pixels start[i] to start[i] + taps - 1
+ * times weights[i * taps] to weights[i * taps + taps - 1], divided by
+ * 2^RESIZE_WEIGHT_BITS. Pixels beyond the edges are folded into the edge
+ * pixel, so the range always lies inside the source.
+ */
+typedef struct {
+    unsigned int srcSize;   /**< Source width or height */
+    unsigned int dstSize;   /**< Resized width or height */
+    t_sampling filter;      /**< Filter the weights come from */
+    int taps;               /**< Number of weights per output pixel */
+    int *start;             /**< First source pixel of each output pixel */
+    int16_t *weights;       /**< taps weights per output pixel, sum 2^RESIZE_WEIGHT_BITS */
+    int refs;               /**< Resizes using the table */
+    int cached;             /**< Still in the cache */
+} t_resize_axis;
+
+/**
+ * @struct t_resize_stats
+ * @brief Use of the weight table cache
+ */
+typedef struct {
+    unsigned long hits;     /**< Tables found in the cache */
+    unsigned long misses;   /**< Tables computed */
+    int tables;             /**< Tables in the cache */
+} t_resize_stats;
+
+/* ============================================================================
+ * RESIZE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Get the weights of one axis, from the cache or computed
+ * @param srcSize Source size in pixels
+ * @param dstSize Resized size in pixels
+ * @param filter Filter giving the weights
+ * @return Table to give back with resize_releaseAxis, or NULL on failure
+ */
+t_resize_axis *resize_getAxis(unsigned int srcSize, unsigned int dstSize, t_sampling filter);
+
+/**
+ * @brief Give back a table returned by resize_getAxis
+ * @param axis Table, or NULL
+ */
+void resize_releaseAxis(t_resize_axis *axis);
+
+/**
+ * @brief Draw a view resized into another view
+ * @param src Source pixels (not modified)
+ * @param dst Destination of the size wanted, same format, not overlapping src
+ * @param filter SAMPLE_NEAREST, SAMPLE_BILINEAR, SAMPLE_AREA, SAMPLE_BICUBIC
+ *               or SAMPLE_LANCZOS3
+ * @return 1 on success, 0 if the formats differ, a view is empty or memory
+ *         is missing
+ *
+ * Area averages the source pixels each output pixel covers, which is the
+ * usual choice for thumbnails; Lanczos-3 is the sharpest. An axis whose
+ * size does not change is copied as is.
+ */
+int view_resize(const t_image_view *src, t_image_view *dst, t_sampling filter);
+
+/**
+ * @brief Use of the weight table cache
+ * @return Counters since the start of the program
+ */
+t_resize_stats resize_getStats(void);
+
+/**
+ * @brief Free the cached weight tables
+ *
+ * Tables still in use are freed when they are given back.
+ */
+void resize_clearCache(void);
+
+#endif //RESIZE_H
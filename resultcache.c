@@ -0,0 +1,418 @@
+/**
+ * @file resultcache.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Content-addressed disk cache of operation chain results
+ *
+ * Keys are computed with XXH64 (https://github.com/Cyan4973/xxHash), which
+ * hashes 32 bytes per step at several gigabytes per second: hashing the
+ * input costs far less than decoding or filtering it.
+ *
+ */
+
+#include "resultcache.h"
+#include "qoi.h"
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+// ========================================
+// HASH FUNCTION (XXH64)
+// ========================================
+
+#define PRIME64_1  0x9E3779B185EBCA87ULL
+#define PRIME64_2  0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3  0x165667B19E3779F9ULL
+#define PRIME64_4  0x85EBCA77C2B2AE63ULL
+#define PRIME64_5  0x27D4EB2F165667C5ULL
+
+typedef struct {
+    uint64_t total;          // Bytes hashed so far
+    uint64_t seed;
+    uint64_t v[4];           // Accumulators of the 32-byte stripes
+    uint8_t buffer[32];      // Bytes waiting for a full stripe
+    size_t buffered;
+} t_hash64;
+
+
+static uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+
+static uint64_t read64(const uint8_t *p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));   // Little-endian, like the BMP fields
+    return value;
+}
+
+
+static uint64_t hash64_round(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME64_2;
+    return rotl64(acc, 31) * PRIME64_1;
+}
+
+
+static uint64_t hash64_merge(uint64_t acc, uint64_t v)
+{
+    acc ^= hash64_round(0, v);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+
+static void hash64_init(t_hash64 *h, uint64_t seed)
+{
+    memset(h, 0, sizeof(*h));
+    h->seed = seed;
+    h->v[0] = seed + PRIME64_1 + PRIME64_2;
+    h->v[1] = seed + PRIME64_2;
+    h->v[2] = seed;
+    h->v[3] = seed - PRIME64_1;
+}
+
+
+static void hash64_stripe(t_hash64 *h, const uint8_t *p)
+{
+    for (int i = 0; i < 4; i++)
+        h->v[i] = hash64_round(h->v[i], read64(p + i * 8));
+}
+
+
+static void hash64_update(t_hash64 *h, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    h->total += size;
+
+    if (h->buffered) {
+        size_t n = 32 - h->buffered < size ? 32 - h->buffered : size;
+        memcpy(h->buffer + h->buffered, p, n);
+        h->buffered += n;
+        p += n;
+        size -= n;
+        if (h->buffered < 32)
+            return;
+        hash64_stripe(h, h->buffer);
+        h->buffered = 0;
+    }
+    for (; size >= 32; p += 32, size -= 32)
+        hash64_stripe(h, p);
+    memcpy(h->buffer, p, size);
+    h->buffered = size;
+}
+
+
+static uint64_t hash64_final(const t_hash64 *h)
+{
+    uint64_t acc;
+    if (h->total >= 32) {
+        acc = rotl64(h->v[0], 1) + rotl64(h->v[1], 7) + rotl64(h->v[2], 12) + rotl64(h->v[3], 18);
+        for (int i = 0; i < 4; i++)
+            acc = hash64_merge(acc, h->v[i]);
+    } else {
+        acc = h->seed + PRIME64_5;
+    }
+    acc += h->total;
+
+    const uint8_t *p = h->buffer;
+    size_t size = h->buffered;
+    for (; size >= 8; p += 8, size -= 8)
+        acc = rotl64(acc ^ hash64_round(0, read64(p)), 27) * PRIME64_1 + PRIME64_4;
+    if (size >= 4) {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        acc = rotl64(acc ^ (uint64_t)value * PRIME64_1, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+        size -= 4;
+    }
+    for (; size > 0; p++, size--)
+        acc = rotl64(acc ^ *p * PRIME64_5, 11) * PRIME64_1;
+
+    // Final avalanche
+    acc ^= acc >> 33;
+    acc *= PRIME64_2;
+    acc ^= acc >> 29;
+    acc *= PRIME64_3;
+    acc ^= acc >> 32;
+    return acc;
+}
+
+// ========================================
+// KEYS
+// ========================================
+
+
+// Hash of the image description, then the pixels were hashed by the caller
+static void rcache_startKey(t_hash64 *h, int bits, uint32_t width, uint32_t height)
+{
+    uint32_t description[3] = {bits, width, height};
+    hash64_init(h, RCACHE_VERSION);
+    hash64_update(h, description, sizeof(description));
+}
+
+
+static unsigned long long rcache_finishKey(t_hash64 *h, const t_opchain *chain)
+{
+    char text[OPCHAIN_MAX_OPS * 32];
+    opchain_toString(chain, text, sizeof(text));
+    hash64_update(h, text, strlen(text) + 1);   // The '\0' ends the chain
+    return hash64_final(h);
+}
+
+
+unsigned long long rcache_key8(t_bmp8 *img, const t_opchain *chain)
+{
+    t_hash64 h;
+    rcache_startKey(&h, 8, img->width, img->height);
+    for (size_t y = 0; y < img->height; y++)
+        hash64_update(&h, img->data + y * img->stride, img->width);
+    return rcache_finishKey(&h, chain);
+}
+
+
+unsigned long long rcache_key24(t_bmp24 *img, const t_opchain *chain)
+{
+    t_hash64 h;
+    rcache_startKey(&h, 24, img->width, img->height);
+    for (int y = 0; y < img->height; y++)
+        hash64_update(&h, img->data[y], (size_t)img->width * sizeof(t_pixel));
+    return rcache_finishKey(&h, chain);
+}
+
+// ========================================
+// CACHE FUNCTIONS
+// ========================================
+
+
+t_result_cache * rcache_open(const char *directory, unsigned long long capacity)
+{
+#ifdef _WIN32
+    int made = _mkdir(directory);
+#else
+    int made = mkdir(directory, 0755);
+#endif
+    if (made != 0 && errno != EEXIST) {
+        printf("Error : Cannot create the cache directory %s\n", directory);
+        return NULL;
+    }
+
+    t_result_cache *cache = calloc(1, sizeof(t_result_cache));
+    if (!cache) {
+        printf("Error allocating memory for the cache\n");
+        return NULL;
+    }
+    if (snprintf(cache->directory, sizeof(cache->directory), "%s", directory) >= (int)sizeof(cache->directory)) {
+        printf("Error : Cache directory path too long\n");
+        free(cache);
+        return NULL;
+    }
+    cache->capacity = capacity;
+    rcache_trim(cache);   // Total size of the results already stored
+    return cache;
+}
+
+
+void rcache_close(t_result_cache *cache)
+{
+    free(cache);
+}
+
+
+static void rcache_path(const t_result_cache *cache, unsigned long long key, const char *suffix, char *path)
+{
+    snprintf(path, RCACHE_PATH_MAX + 32, "%s/%016llx%s", cache->directory, key, suffix);
+}
+
+
+// Remove a stored result and take its size off the running total
+static void rcache_remove(t_result_cache *cache, const char *path)
+{
+    struct stat info;
+    if (stat(path, &info) != 0 || remove(path) != 0)
+        return;
+    unsigned long long size = (unsigned long long)info.st_size;
+    cache->bytes = cache->bytes > size ? cache->bytes - size : 0;
+}
+
+
+/**
+ * Store rows (top row first) as a QOI result. The file is written under a
+ * temporary name and renamed, so readers never see a partial result.
+ */
+static void rcache_store(t_result_cache *cache, unsigned long long key, unsigned int width, unsigned int height,
+                         int channels, const uint8_t *const *rows)
+{
+    char temp[RCACHE_PATH_MAX + 32], path[RCACHE_PATH_MAX + 32];
+    rcache_path(cache, key, ".tmp", temp);
+    rcache_path(cache, key, ".qoi", path);
+
+    t_qoi_encoder *enc = qoi_encoderOpen(temp, width, height, channels);
+    if (!enc) return;
+    for (unsigned int y = 0; y < height; y++)
+        qoi_encodeRow(enc, rows[y]);
+
+    if (qoi_encoderClose(enc)) {
+        struct stat info;
+        if (stat(temp, &info) != 0)
+            info.st_size = 0;
+        rcache_remove(cache, path);   // rename does not replace files on Windows
+        if (rename(temp, path) == 0)
+            cache->bytes += (unsigned long long)info.st_size;
+        else
+            remove(temp);
+        if (cache->bytes > cache->capacity)
+            rcache_trim(cache);
+    } else {
+        remove(temp);
+    }
+}
+
+
+t_bmp8 * rcache_run8(t_result_cache *cache, const t_opchain *chain, t_bmp8 *img)
+{
+    unsigned long long key = rcache_key8(img, chain);
+    char path[RCACHE_PATH_MAX + 32];
+    rcache_path(cache, key, ".qoi", path);
+
+    FILE *probe = fopen(path, "rb");
+    if (probe) {
+        fclose(probe);
+        t_bmp8 *result = bmp8_loadQOI(path);
+        unsigned int width, height;
+        opchain_outputSize(chain, img->width, img->height, &width, &height);
+        if (result && result->width == width && result->height == height) {
+            cache->hits++;
+            utime(path, NULL);   // Most recently used
+            memcpy(result->header, img->header, sizeof(result->header));
+            memcpy(result->colorTable, img->colorTable, sizeof(result->colorTable));
+            if (width != img->width || height != img->height)
+                bmp8_updateHeader(result);   // As bmp8_rotate and bmp8_resize do
+            return result;
+        }
+        bmp8_freeImage(result);
+        rcache_remove(cache, path);   // Unreadable result: compute it again
+    }
+
+    cache->misses++;
+    t_bmp8 *result = bmp8_copy(img);
+    if (!result) return NULL;
+    if (!opchain_apply8(chain, result)) {
+        bmp8_freeImage(result);
+        return NULL;
+    }
+
+    // QOI rows go top row first
+    const uint8_t **rows = malloc(result->height * sizeof(uint8_t *));
+    if (rows) {
+        for (size_t y = 0; y < result->height; y++)
+            rows[y] = result->data + (result->height - 1 - y) * result->stride;
+        rcache_store(cache, key, result->width, result->height, 1, rows);
+        free(rows);
+    }
+    return result;
+}
+
+
+t_bmp24 * rcache_run24(t_result_cache *cache, const t_opchain *chain, t_bmp24 *img)
+{
+    unsigned long long key = rcache_key24(img, chain);
+    char path[RCACHE_PATH_MAX + 32];
+    rcache_path(cache, key, ".qoi", path);
+
+    FILE *probe = fopen(path, "rb");
+    if (probe) {
+        fclose(probe);
+        t_bmp24 *result = bmp24_loadQOI(path);
+        unsigned int width, height;
+        opchain_outputSize(chain, img->width, img->height, &width, &height);
+        if (result && (unsigned int)result->width == width && (unsigned int)result->height == height) {
+            cache->hits++;
+            utime(path, NULL);   // Most recently used
+            result->header = img->header;
+            result->header_info = img->header_info;
+            if (width != (unsigned int)img->width || height != (unsigned int)img->height)
+                bmp24_updateHeaders(result);   // As bmp24_rotate and bmp24_resize do
+            return result;
+        }
+        if (result) bmp24_free(result);
+        rcache_remove(cache, path);
+    }
+
+    cache->misses++;
+    t_bmp24 *result = bmp24_copy(img);
+    if (!result) return NULL;
+    if (!opchain_apply24(chain, result)) {
+        bmp24_free(result);
+        return NULL;
+    }
+    rcache_store(cache, key, result->width, result->height, 3, (const uint8_t *const *)result->data);
+    return result;
+}
+
+
+typedef struct {
+    char name[32];
+    time_t mtime;
+    unsigned long long size;
+} t_rcache_file;
+
+
+static int rcache_compareAge(const void *a, const void *b)
+{
+    time_t ta = ((const t_rcache_file *)a)->mtime;
+    time_t tb = ((const t_rcache_file *)b)->mtime;
+    return (ta > tb) - (ta < tb);
+}
+
+
+void rcache_trim(t_result_cache *cache)
+{
+    DIR *dir = opendir(cache->directory);
+    if (!dir) return;
+
+    // List the stored results and their total size
+    t_rcache_file *files = NULL;
+    size_t count = 0, capacity = 0;
+    unsigned long long total = 0;
+    char path[RCACHE_PATH_MAX + 32];
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        if (length >= sizeof(files->name) || length < 4 || strcmp(entry->d_name + length - 4, ".qoi") != 0)
+            continue;
+        struct stat info;
+        snprintf(path, sizeof(path), "%s/%s", cache->directory, entry->d_name);
+        if (stat(path, &info) != 0)
+            continue;
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            t_rcache_file *bigger = realloc(files, capacity * sizeof(t_rcache_file));
+            if (!bigger) break;
+            files = bigger;
+        }
+        strcpy(files[count].name, entry->d_name);
+        files[count].mtime = info.st_mtime;
+        files[count].size = (unsigned long long)info.st_size;
+        total += files[count].size;
+        count++;
+    }
+    closedir(dir);
+
+    // Oldest first
+    if (total > cache->capacity) {
+        qsort(files, count, sizeof(t_rcache_file), rcache_compareAge);
+        for (size_t i = 0; i < count && total > cache->capacity; i++) {
+            snprintf(path, sizeof(path), "%s/%s", cache->directory, files[i].name);
+            if (remove(path) == 0)
+                total -= files[i].size;
+        }
+    }
+    free(files);
+    cache->bytes = total;
+}
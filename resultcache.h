@@ -0,0 +1,121 @@
+/**
+ * @file resultcache.h
+ * @brief Content-addressed disk cache of operation chain results
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines a cache of processed images stored on local
+ * disk. A result is found again from what produced it, not from file names:
+ * - The key is a 64-bit hash of the input pixels and dimensions, followed by
+ *   the canonical text of the operation chain (opchain_toString)
+ * - Results are stored as QOI files named after the key
+ * - The directory is capped in size; the least recently used results
+ *   (oldest modification time, refreshed on every hit) are removed first
+ * - The directory is listed when the cache is opened and again only when
+ *   the running total of stored bytes goes over the cap, not on every store
+ *
+ * A hit loads the stored result without running any bmp8_* or bmp24_*
+ * processing function.
+ */
+
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include "bmp8.h"
+#include "bmp24.h"
+#include "opchain.h"
+
+/* ============================================================================
+ * RESULT CACHE CONSTANTS
+ * ============================================================================ */
+
+/**
+ * Part of every key. Increase it when an operation changes its output
+ * (kernel values, rounding...) so that older results are no longer used.
+ */
+#define RCACHE_VERSION   1
+#define RCACHE_PATH_MAX  1024   /**< Maximum length of the directory path */
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @struct t_result_cache
+ * @brief Directory of cached results
+ */
+typedef struct {
+    char directory[RCACHE_PATH_MAX];  /**< Directory holding the results */
+    unsigned long long capacity;      /**< Maximum total size of the results in bytes */
+    unsigned long long bytes;         /**< Total size of the results, as of the last listing plus this process's stores */
+    unsigned long hits;               /**< Results loaded from disk */
+    unsigned long misses;             /**< Results computed and stored */
+} t_result_cache;
+
+/* ============================================================================
+ * CACHE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Open a result cache, creating its directory if needed
+ * @param directory Directory holding the results
+ * @param capacity Maximum total size of the stored results in bytes
+ * @return Pointer to the cache, or NULL on failure
+ */
+t_result_cache *rcache_open(const char *directory, unsigned long long capacity);
+
+/**
+ * @brief Close a result cache (the stored results are kept)
+ * @param cache Cache to close
+ */
+void rcache_close(t_result_cache *cache);
+
+/**
+ * @brief Key of a chain applied to an 8-bit image
+ * @param img Input image
+ * @param chain Operations to apply
+ * @return 64-bit key of the result
+ */
+unsigned long long rcache_key8(t_bmp8 *img, const t_opchain *chain);
+
+/**
+ * @brief Key of a chain applied to a 24-bit image
+ * @param img Input image
+ * @param chain Operations to apply
+ * @return 64-bit key of the result
+ */
+unsigned long long rcache_key24(t_bmp24 *img, const t_opchain *chain);
+
+/**
+ * @brief Apply a chain to an 8-bit image, through the cache
+ * @param cache Result cache
+ * @param chain Operations to apply
+ * @param img Input image (not modified)
+ * @return New image holding the result, or NULL if the chain cannot be applied
+ *
+ * On a hit the result is read from disk; on a miss the chain is applied to a
+ * copy of img and the result is stored. The header and color table of the
+ * result are those of img.
+ */
+t_bmp8 *rcache_run8(t_result_cache *cache, const t_opchain *chain, t_bmp8 *img);
+
+/**
+ * @brief Apply a chain to a 24-bit image, through the cache
+ * @param cache Result cache
+ * @param chain Operations to apply
+ * @param img Input image (not modified)
+ * @return New image holding the result, or NULL if the chain cannot be applied
+ */
+t_bmp24 *rcache_run24(t_result_cache *cache, const t_opchain *chain, t_bmp24 *img);
+
+/**
+ * @brief Remove the least recently used results until the size cap is met
+ * @param cache Result cache
+ *
+ * Lists the directory and updates bytes. Called when the cache is opened
+ * and when a store takes bytes over the capacity; also useful after
+ * lowering the capacity.
+ */
+void rcache_trim(t_result_cache *cache);
+
+#endif //RESULTCACHE_H
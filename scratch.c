@@ -0,0 +1,186 @@
+/**
+ * @file scratch.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Per-thread scratch arena for temporary buffers
+ *
+ */
+
+#include "scratch.h"
+#include "bufpool.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+// ========================================
+// ARENA STATE
+// ========================================
+
+typedef struct t_scratch_block {
+    struct t_scratch_block *prev;
+    struct t_scratch_block *next;
+    size_t start;        // Arena position of the first byte of data
+    size_t size;         // Usable bytes after the header
+    void *memory;        // Pointer returned by pool_alloc
+    unsigned char *data; // Aligned start of the usable bytes
+} t_scratch_block;
+
+typedef struct {
+    t_scratch_block *first;
+    t_scratch_block *current;
+    size_t used;         // Arena position: start of current + bytes used in it
+    size_t reserved;
+    size_t highWater;
+    unsigned long failures;
+} t_scratch_arena;
+
+static _Thread_local t_scratch_arena arena;
+
+// Read by every thread, written once at startup
+static size_t scratch_cap = SCRATCH_DEFAULT_CAP;
+
+// ========================================
+// BLOCK FUNCTIONS
+// ========================================
+
+
+static t_scratch_block * scratch_newBlock(size_t size)
+{
+    if (arena.reserved + size > scratch_cap)
+        return NULL;
+
+    // One pool buffer (huge pages when enabled): header, padding up to the
+    // alignment, then the data
+    void *memory = pool_alloc(sizeof(t_scratch_block) + SCRATCH_ALIGN + size);
+    if (!memory)
+        return NULL;
+    t_scratch_block *block = memory;
+    uintptr_t data = ((uintptr_t)(block + 1) + SCRATCH_ALIGN - 1) & ~(uintptr_t)(SCRATCH_ALIGN - 1);
+    block->memory = memory;
+    block->data = (unsigned char *)data;
+    block->size = size;
+    block->prev = block->next = NULL;
+    arena.reserved += size;
+    return block;
+}
+
+
+// Free a block and every block after it
+static void scratch_freeFrom(t_scratch_block *block)
+{
+    if (block && block->prev)
+        block->prev->next = NULL;
+    while (block) {
+        t_scratch_block *next = block->next;
+        arena.reserved -= block->size;
+        if (block == arena.first) arena.first = NULL;
+        pool_free(block->memory);
+        block = next;
+    }
+}
+
+
+// Make current a block that can hold size more bytes; 0 if the cap forbids it
+static int scratch_advance(size_t size)
+{
+    t_scratch_block *current = arena.current;
+    t_scratch_block *next = current ? current->next : arena.first;
+    size_t start = current ? current->start + current->size : 0;
+
+    // Blocks kept from earlier operations are reused when large enough
+    if (next && next->size < size) {
+        scratch_freeFrom(next);
+        next = NULL;
+    }
+    if (!next) {
+        next = scratch_newBlock(size > SCRATCH_BLOCK_SIZE ? size : SCRATCH_BLOCK_SIZE);
+        if (!next)
+            return 0;
+        next->prev = current;
+        if (current) current->next = next;
+        else arena.first = next;
+    }
+    next->start = start;
+    arena.current = next;
+    arena.used = start;
+    return 1;
+}
+
+// ========================================
+// ARENA FUNCTIONS
+// ========================================
+
+
+size_t scratch_mark(void)
+{
+    return arena.used;
+}
+
+
+void * scratch_alloc(size_t size)
+{
+    size = (size + SCRATCH_ALIGN - 1) & ~(size_t)(SCRATCH_ALIGN - 1);
+    t_scratch_block *block = arena.current;
+    if (!block || arena.used + size > block->start + block->size) {
+        if (!scratch_advance(size)) {
+            arena.failures++;
+            return NULL;
+        }
+        block = arena.current;
+    }
+
+    void *buffer = block->data + (arena.used - block->start);
+    arena.used += size;
+    if (arena.used > arena.highWater)
+        arena.highWater = arena.used;
+    return buffer;
+}
+
+
+void scratch_release(size_t mark)
+{
+    if (mark >= arena.used)
+        return;
+
+    // Step back to the block holding the mark; later blocks are kept
+    t_scratch_block *block = arena.current;
+    while (block->prev && block->start > mark)
+        block = block->prev;
+    arena.current = block;
+    arena.used = mark;
+
+    // Back to empty with several blocks: one block of the total size is
+    // faster next time (no block change, a single page range)
+    if (mark == 0 && arena.first && arena.first->next) {
+        size_t total = arena.reserved;
+        scratch_freeFrom(arena.first);
+        arena.first = scratch_newBlock(total);
+        arena.current = arena.first;
+        if (arena.first) arena.first->start = 0;
+    }
+}
+
+
+void scratch_setCap(size_t bytes)
+{
+    scratch_cap = bytes;
+}
+
+
+t_scratch_stats scratch_getStats(void)
+{
+    t_scratch_stats stats;
+    stats.used = arena.used;
+    stats.reserved = arena.reserved;
+    stats.highWater = arena.highWater;
+    stats.cap = scratch_cap;
+    stats.failures = arena.failures;
+    return stats;
+}
+
+
+void scratch_trim(void)
+{
+    if (arena.used != 0)
+        return;
+    scratch_freeFrom(arena.first);
+    arena.first = arena.current = NULL;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file scratch.h
+ * @brief Per-thread scratch arena for temporary buffers
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines a stack-like arena from which processing
+ * functions take their temporary buffers (image copies, kernels, CDFs...):
+ * - Each thread has its own arena, so no locking is needed
+ * - An operation takes a mark, allocates, and releases back to the mark
+ *   before returning; nothing is freed one buffer at a time
+ * - Released memory is kept for the next operation, so repeated operations
+ *   neither call malloc nor touch fresh pages once the arena has grown
+ *
+ * Usage:
+ * @code
+ *     size_t mark = scratch_mark();
+ *     uint8_t *copy = scratch_alloc(size);
+ *     ...
+ *     scratch_release(mark);
+ * @endcode
+ */
+
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include <stddef.h>
+
+/* ============================================================================
+ * SCRATCH ARENA CONSTANTS
+ * ============================================================================ */
+
+#define SCRATCH_ALIGN        64                   /**< Alignment of every buffer (cache line) */
+#define SCRATCH_BLOCK_SIZE   ((size_t)1 << 20)    /**< Smallest block taken from the buffer pool */
+#define SCRATCH_DEFAULT_CAP  ((size_t)1 << 30)    /**< Default cap of each thread's arena */
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @struct t_scratch_stats
+ * @brief Usage of the calling thread's arena
+ */
+typedef struct {
+    size_t used;        /**< Bytes currently allocated */
+    size_t reserved;    /**< Bytes held from the buffer pool, used or not */
+    size_t highWater;   /**< Largest value of used since the thread started */
+    size_t cap;         /**< Maximum of reserved */
+    unsigned long failures; /**< Allocations refused because of the cap */
+} t_scratch_stats;
+
+/* ============================================================================
+ * ARENA FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Current position of the calling thread's arena
+ * @return Mark to pass to scratch_release
+ */
+size_t scratch_mark(void);
+
+/**
+ * @brief Allocate a temporary buffer
+ * @param size Size in bytes
+ * @return Buffer aligned on SCRATCH_ALIGN bytes, or NULL if the cap would be exceeded
+ *
+ * The buffer stays valid until the arena is released to a mark taken
+ * before this call. It must not be passed to free.
+ */
+void *scratch_alloc(size_t size);
+
+/**
+ * @brief Release every buffer allocated after a mark
+ * @param mark Value returned by scratch_mark
+ *
+ * The memory is kept for later allocations. Releasing to 0 with several
+ * blocks merges them into one, so the next operation of the same size
+ * fits in a single block.
+ */
+void scratch_release(size_t mark);
+
+/**
+ * @brief Set the cap of every thread's arena
+ * @param bytes Maximum memory an arena may hold
+ *
+ * Applies to blocks taken after the call; call it before starting threads.
+ */
+void scratch_setCap(size_t bytes);
+
+/**
+ * @brief Usage statistics of the calling thread's arena
+ * @return Current statistics
+ */
+t_scratch_stats scratch_getStats(void);
+
+/**
+ * @brief Give the memory of the calling thread's arena back to the system
+ *
+ * Everything must have been released. Call it before a thread ends, or
+ * after an unusually large operation.
+ */
+void scratch_trim(void);
+
+#endif //SCRATCH_H
@@ -0,0 +1,393 @@
+/**
+ * @file shmimage.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Hand-off of images between processes through POSIX shared memory
+ *
+ * Segment layout: a t_shm_segment header, then the pixels at a page-aligned
+ * offset so that they can be mapped read-only in readers. 8-bit pixels are
+ * stored bottom row first like t_bmp8 data, 24-bit pixels top row first as
+ * packed t_pixel rows.
+ *
+ */
+
+#include "shmimage.h"
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ========================================
+// SEGMENT LAYOUT
+// ========================================
+
+typedef struct {
+    uint32_t magic;                 // SHM_MAGIC once the header is written
+    uint32_t bits;                  // 8 or 24
+    atomic_uint ready;              // Set by shm_commit, pixels are final
+    atomic_uint refCount;           // Handles on the segment, in all processes
+    uint32_t width;
+    uint32_t height;
+    uint64_t stride;                // Bytes between the starts of two rows
+    uint64_t dataOffset;            // Offset of the pixels, page aligned
+    uint64_t size;                  // Size of the whole segment
+    t_bmp_header header24;          // Headers of a 24-bit image
+    t_bmp_info info24;
+    unsigned char header8[54];      // Header and color table of an 8-bit image
+    unsigned char colorTable[1024];
+} t_shm_segment;
+
+
+// Segment names must start with '/'
+static int shm_normalizeName(char *dest, const char *name)
+{
+    int length = snprintf(dest, SHM_NAME_MAX, "%s%s", name[0] == '/' ? "" : "/", name);
+    if (length <= 1 || length >= SHM_NAME_MAX || strchr(dest + 1, '/')) {
+        printf("Error : Invalid shared memory name %s\n", name);
+        return 0;
+    }
+    return 1;
+}
+
+
+/**
+ * Build the t_bmp8 or t_bmp24 view of a mapped segment in img.
+ * Returns 1 on success, 0 if the memory allocation failed.
+ */
+static int shm_makeView(t_shm_image *img)
+{
+    t_shm_segment *seg = img->base;
+    unsigned char *pixels = (unsigned char *)img->base + seg->dataOffset;
+
+    if (seg->bits == 8) {
+        img->bmp8 = malloc(sizeof(t_bmp8));
+        if (!img->bmp8) return 0;
+        memcpy(img->bmp8->header, seg->header8, 54);
+        memcpy(img->bmp8->colorTable, seg->colorTable, 1024);
+        img->bmp8->data = pixels;
+        img->bmp8->width = seg->width;
+        img->bmp8->height = seg->height;
+        img->bmp8->colorDepth = 8;
+        img->bmp8->stride = seg->stride;
+        img->bmp8->dataSize = seg->stride * seg->height;
+        return 1;
+    }
+
+    img->bmp24 = malloc(sizeof(t_bmp24));
+    t_pixel **rows = malloc(seg->height * sizeof(t_pixel *));
+    if (!img->bmp24 || !rows) {
+        free(img->bmp24);
+        free(rows);
+        img->bmp24 = NULL;
+        return 0;
+    }
+    for (uint32_t y = 0; y < seg->height; y++)
+        rows[y] = (t_pixel *)(pixels + y * seg->stride);
+    img->bmp24->header = seg->header24;
+    img->bmp24->header_info = seg->info24;
+    img->bmp24->width = seg->width;
+    img->bmp24->height = seg->height;
+    img->bmp24->colorDepth = 24;
+    img->bmp24->data = rows;
+    return 1;
+}
+
+
+static void shm_freeView(t_shm_image *img)
+{
+    if (img->bmp8)
+        free(img->bmp8);
+    if (img->bmp24) {
+        free(img->bmp24->data);
+        free(img->bmp24);
+    }
+}
+
+// ========================================
+// PUBLISHING FUNCTIONS
+// ========================================
+
+
+/**
+ * Create and map a new segment for a width x height image.
+ * The header is filled in and the count holds the caller's reference.
+ */
+static t_shm_image * shm_create(const char *name, uint32_t width, uint32_t height, int bits)
+{
+    t_shm_image *img = calloc(1, sizeof(t_shm_image));
+    if (!img) {
+        printf("Error allocating memory for the shared image\n");
+        return NULL;
+    }
+    if (!shm_normalizeName(img->name, name)) {
+        free(img);
+        return NULL;
+    }
+
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t stride = (uint64_t)width * (bits / 8);
+    uint64_t dataOffset = (sizeof(t_shm_segment) + page - 1) / page * page;
+    uint64_t size = dataOffset + stride * height;
+
+    int fd = shm_open(img->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        printf("Error : Cannot create shared memory %s\n", img->name);
+        free(img);
+        return NULL;
+    }
+    void *base = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0)
+        base = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);   // The mapping stays valid without the descriptor
+    if (base == MAP_FAILED) {
+        printf("Error : Cannot map shared memory %s\n", img->name);
+        shm_unlink(img->name);
+        free(img);
+        return NULL;
+    }
+    img->base = base;
+    img->size = (size_t)size;
+    img->bits = bits;
+
+    t_shm_segment *seg = base;
+    seg->bits = bits;
+    seg->width = width;
+    seg->height = height;
+    seg->stride = stride;
+    seg->dataOffset = dataOffset;
+    seg->size = size;
+    atomic_init(&seg->ready, 0);
+    atomic_init(&seg->refCount, 1);
+    seg->magic = SHM_MAGIC;
+
+    return img;
+}
+
+
+t_shm_image * shm_create8(const char *name, unsigned int width, unsigned int height)
+{
+    t_shm_image *img = shm_create(name, width, height, 8);
+    if (!img) return NULL;
+    t_shm_segment *seg = img->base;
+
+    // Standard header of an uncompressed 8-bit image with a 256-entry palette
+    t_bmp_info info = {0};
+    uint16_t type = BMP_TYPE;
+    uint32_t offset = HEADER_SIZE + INFO_SIZE + 1024;
+    info.size = INFO_SIZE;
+    info.width = width;
+    info.height = height;
+    info.planes = 1;
+    info.bits = 8;
+    info.compression = COMPRESSION_RGB;
+    info.ncolors = 256;
+    memcpy(seg->header8 + BITMAP_MAGIC, &type, sizeof(type));
+    memcpy(seg->header8 + BITMAP_OFFSET, &offset, sizeof(offset));
+    memcpy(seg->header8 + HEADER_SIZE, &info, sizeof(info));
+
+    // Identity grayscale palette: entry i is (i, i, i, 0)
+    for (int i = 0; i < 256; i++) {
+        seg->colorTable[i * 4] = i;
+        seg->colorTable[i * 4 + 1] = i;
+        seg->colorTable[i * 4 + 2] = i;
+    }
+
+    if (!shm_makeView(img)) {
+        printf("Error allocating memory for the shared image\n");
+        shm_release(img);
+        return NULL;
+    }
+    return img;
+}
+
+
+t_shm_image * shm_create24(const char *name, int width, int height)
+{
+    if (width <= 0 || height <= 0) {
+        printf("Error : Invalid image size %dx%d\n", width, height);
+        return NULL;
+    }
+    t_shm_image *img = shm_create(name, width, height, 24);
+    if (!img) return NULL;
+    t_shm_segment *seg = img->base;
+
+    // Same default headers as bmp24_allocate
+    uint64_t imageSize = (((uint64_t)width * 3 + 3) / 4 * 4) * height;
+    int fits = imageSize <= UINT32_MAX - (HEADER_SIZE + INFO_SIZE);
+    seg->header24.type = BMP_TYPE;
+    seg->header24.offset = HEADER_SIZE + INFO_SIZE;
+    seg->header24.size = fits ? (uint32_t)(HEADER_SIZE + INFO_SIZE + imageSize) : 0;
+    seg->info24.size = INFO_SIZE;
+    seg->info24.width = width;
+    seg->info24.height = height;
+    seg->info24.planes = 1;
+    seg->info24.bits = DEFAULT_DEPTH;
+    seg->info24.compression = COMPRESSION_RGB;
+    seg->info24.imagesize = fits ? (uint32_t)imageSize : 0;
+    seg->info24.xresolution = 2835;   // 72 DPI
+    seg->info24.yresolution = 2835;
+
+    if (!shm_makeView(img)) {
+        printf("Error allocating memory for the shared image\n");
+        shm_release(img);
+        return NULL;
+    }
+    return img;
+}
+
+
+void shm_commit(t_shm_image *img)
+{
+    t_shm_segment *seg = img->base;
+
+    // Headers may have been changed through the view
+    if (img->bmp8) {
+        memcpy(seg->header8, img->bmp8->header, 54);
+        memcpy(seg->colorTable, img->bmp8->colorTable, 1024);
+    } else {
+        seg->header24 = img->bmp24->header;
+        seg->info24 = img->bmp24->header_info;
+    }
+
+    // Release order: readers that see ready also see the pixels
+    atomic_store_explicit(&seg->ready, 1, memory_order_release);
+}
+
+
+t_shm_image * shm_publish8(const char *name, t_bmp8 *img)
+{
+    t_shm_image *shared = shm_create8(name, img->width, img->height);
+    if (!shared) return NULL;
+
+    t_bmp8 *view = shared->bmp8;
+    memcpy(view->header, img->header, 54);
+    memcpy(view->colorTable, img->colorTable, 1024);
+    for (size_t y = 0; y < img->height; y++)
+        memcpy(view->data + y * view->stride, img->data + y * img->stride, img->width);
+
+    shm_commit(shared);
+    return shared;
+}
+
+
+t_shm_image * shm_publish24(const char *name, t_bmp24 *img)
+{
+    t_shm_image *shared = shm_create24(name, img->width, img->height);
+    if (!shared) return NULL;
+
+    t_bmp24 *view = shared->bmp24;
+    view->header = img->header;
+    view->header_info = img->header_info;
+    for (int y = 0; y < img->height; y++)
+        memcpy(view->data[y], img->data[y], (size_t)img->width * sizeof(t_pixel));
+
+    shm_commit(shared);
+    return shared;
+}
+
+// ========================================
+// ATTACHING FUNCTIONS
+// ========================================
+
+
+t_shm_image * shm_attach(const char *name)
+{
+    t_shm_image *img = calloc(1, sizeof(t_shm_image));
+    if (!img) {
+        printf("Error allocating memory for the shared image\n");
+        return NULL;
+    }
+    if (!shm_normalizeName(img->name, name)) {
+        free(img);
+        return NULL;
+    }
+
+    // Read-write descriptor: the reference count lives in the segment
+    int fd = shm_open(img->name, O_RDWR, 0);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(t_shm_segment)) {
+        printf("Error : No shared image named %s\n", img->name);
+        if (fd >= 0) close(fd);
+        free(img);
+        return NULL;
+    }
+    img->size = (size_t)info.st_size;
+    img->base = mmap(NULL, img->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (img->base == MAP_FAILED) {
+        printf("Error : Cannot map shared memory %s\n", img->name);
+        free(img);
+        return NULL;
+    }
+
+    t_shm_segment *seg = img->base;
+    if (seg->magic != SHM_MAGIC || !atomic_load_explicit(&seg->ready, memory_order_acquire)
+        || seg->size != img->size) {
+        printf("Error : Shared image %s is not published yet\n", img->name);
+        munmap(img->base, img->size);
+        free(img);
+        return NULL;
+    }
+
+    // Take a reference unless the last one is being dropped
+    unsigned int count = atomic_load(&seg->refCount);
+    do {
+        if (count == 0) {
+            printf("Error : Shared image %s is being released\n", img->name);
+            munmap(img->base, img->size);
+            free(img);
+            return NULL;
+        }
+    } while (!atomic_compare_exchange_weak(&seg->refCount, &count, count + 1));
+
+    // Readers only see the pixels read-only
+    mprotect((unsigned char *)img->base + seg->dataOffset, img->size - seg->dataOffset, PROT_READ);
+
+    img->bits = seg->bits;
+    if (!shm_makeView(img)) {
+        printf("Error allocating memory for the shared image\n");
+        shm_release(img);
+        return NULL;
+    }
+    return img;
+}
+
+
+void shm_release(t_shm_image *img)
+{
+    if (!img) return;
+    t_shm_segment *seg = img->base;
+
+    if (atomic_fetch_sub(&seg->refCount, 1) == 1)
+        shm_unlink(img->name);
+
+    shm_freeView(img);
+    munmap(img->base, img->size);
+    free(img);
+}
+
+#else
+
+// ========================================
+// WINDOWS
+// ========================================
+
+
+static t_shm_image * shm_unsupported(void)
+{
+    printf("Error : Shared memory images are not supported on this system\n");
+    return NULL;
+}
+
+t_shm_image * shm_create8(const char *name, unsigned int width, unsigned int height) { return shm_unsupported(); }
+t_shm_image * shm_create24(const char *name, int width, int height) { return shm_unsupported(); }
+void shm_commit(t_shm_image *img) { }
+t_shm_image * shm_publish8(const char *name, t_bmp8 *img) { return shm_unsupported(); }
+t_shm_image * shm_publish24(const char *name, t_bmp24 *img) { return shm_unsupported(); }
+t_shm_image * shm_attach(const char *name) { return shm_unsupported(); }
+void shm_release(t_shm_image *img) { }
+
+#endif
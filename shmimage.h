@@ -0,0 +1,129 @@
+/**
+ * @file shmimage.h
+ * @brief Hand-off of images between processes through POSIX shared memory
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines functions to publish a t_bmp8 or t_bmp24 in a
+ * named shared-memory segment and to attach to it from another process:
+ * - The segment holds a small header followed by contiguous pixels
+ * - Attached images are t_bmp8 / t_bmp24 views on the segment: no file, no
+ *   serialization and no copy
+ * - A reference count in the segment header removes the name when the last
+ *   user releases it
+ *
+ * Only available on POSIX systems (shm_open and mmap); on Windows every
+ * function prints an error and returns NULL.
+ */
+
+#ifndef SHMIMAGE_H
+#define SHMIMAGE_H
+
+#include "bmp8.h"
+#include "bmp24.h"
+
+/* ============================================================================
+ * SHARED MEMORY CONSTANTS
+ * ============================================================================ */
+
+#define SHM_MAGIC     0x494D4853   /**< "SHMI": marks an initialised segment */
+#define SHM_NAME_MAX  256          /**< Maximum length of a segment name */
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @struct t_shm_image
+ * @brief One process's handle on a shared image
+ *
+ * Exactly one of bmp8 and bmp24 is set, depending on bits. Their pixel data
+ * points into the segment; they are released with shm_release, never with
+ * bmp8_freeImage or bmp24_free. Operations that keep the size fill them in
+ * place; resizing, or a quarter turn of a non-square image, needs a new pixel
+ * array and must not be applied to them.
+ */
+typedef struct {
+    char name[SHM_NAME_MAX];  /**< Segment name, starting with '/' */
+    int bits;                 /**< 8 or 24 */
+    t_bmp8 *bmp8;             /**< View on an 8-bit image, or NULL */
+    t_bmp24 *bmp24;           /**< View on a 24-bit image, or NULL */
+    void *base;               /**< Start of the mapped segment */
+    size_t size;              /**< Size of the segment in bytes */
+} t_shm_image;
+
+/* ============================================================================
+ * PUBLISHING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Create a segment for an 8-bit image to be filled in place
+ * @param name Segment name ('/' is added in front if missing)
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @return Writable handle holding one reference, or NULL on failure
+ *
+ * The view has an identity gray palette and uninitialised pixels. Other
+ * processes cannot attach until shm_commit is called.
+ */
+t_shm_image *shm_create8(const char *name, unsigned int width, unsigned int height);
+
+/**
+ * @brief Create a segment for a 24-bit image to be filled in place
+ * @param name Segment name ('/' is added in front if missing)
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @return Writable handle holding one reference, or NULL on failure
+ *
+ * Other processes cannot attach until shm_commit is called.
+ */
+t_shm_image *shm_create24(const char *name, int width, int height);
+
+/**
+ * @brief Make a created segment available to shm_attach
+ * @param img Handle returned by shm_create8 or shm_create24
+ *
+ * The pixels must not be modified afterwards: readers may be using them.
+ */
+void shm_commit(t_shm_image *img);
+
+/**
+ * @brief Copy an 8-bit image into a new segment and commit it
+ * @param name Segment name
+ * @param img Image to publish
+ * @return Handle holding one reference, or NULL on failure
+ */
+t_shm_image *shm_publish8(const char *name, t_bmp8 *img);
+
+/**
+ * @brief Copy a 24-bit image into a new segment and commit it
+ * @param name Segment name
+ * @param img Image to publish
+ * @return Handle holding one reference, or NULL on failure
+ */
+t_shm_image *shm_publish24(const char *name, t_bmp24 *img);
+
+/* ============================================================================
+ * ATTACHING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Attach to a committed segment published by another process
+ * @param name Segment name
+ * @return Read-only handle holding one more reference, or NULL on failure
+ *
+ * The pixels are mapped read-only: copy them into a bmp8 or bmp24 image of
+ * this process before modifying them.
+ */
+t_shm_image *shm_attach(const char *name);
+
+/**
+ * @brief Drop this handle's reference and unmap the segment
+ * @param img Handle to release, freed by this call
+ *
+ * The segment name is removed when the last reference is dropped, so a
+ * publisher should keep its reference until the readers have attached.
+ */
+void shm_release(t_shm_image *img);
+
+#endif //SHMIMAGE_H
@@ -0,0 +1,249 @@
+/**
+ * @file undo.c
+ * @authors Nolann FOTSO, Rafael ISLAM
+ * @brief Tile-based undo history of an image
+ *
+ */
+
+#include "undo.h"
+#include "bufpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ========================================
+// TILE FUNCTIONS
+// ========================================
+
+
+// Rectangle of a tile, clipped to the image
+static t_image_view undo_tileView(const t_undo_history *history, const t_image_view *view, unsigned int index)
+{
+    unsigned int x = (index % history->tilesX) * UNDO_TILE;
+    unsigned int y = (index / history->tilesX) * UNDO_TILE;
+    return view_sub(view, x, y, UNDO_TILE, UNDO_TILE);
+}
+
+
+static size_t undo_tileBytes(const t_image_view *tile)
+{
+    return (size_t)tile->width * tile->height * tile->format;
+}
+
+
+static void undo_copyOut(const t_image_view *tile, uint8_t *pixels)
+{
+    size_t rowBytes = (size_t)tile->width * tile->format;
+    for (unsigned int y = 0; y < tile->height; y++)
+        memcpy(pixels + y * rowBytes, view_row(tile, y), rowBytes);
+}
+
+
+static void undo_copyIn(const t_image_view *tile, const uint8_t *pixels)
+{
+    size_t rowBytes = (size_t)tile->width * tile->format;
+    for (unsigned int y = 0; y < tile->height; y++)
+        memcpy(view_row(tile, y), pixels + y * rowBytes, rowBytes);
+}
+
+
+static int undo_differs(const t_image_view *tile, const uint8_t *pixels)
+{
+    size_t rowBytes = (size_t)tile->width * tile->format;
+    for (unsigned int y = 0; y < tile->height; y++)
+        if (memcmp(pixels + y * rowBytes, view_row(tile, y), rowBytes) != 0)
+            return 1;
+    return 0;
+}
+
+// ========================================
+// HISTORY FUNCTIONS
+// ========================================
+
+
+static void undo_freeStep(t_undo_step *step)
+{
+    for (unsigned int i = 0; i < step->count; i++)
+        pool_free(step->tiles[i].pixels);
+    free(step->tiles);
+}
+
+
+static void undo_clear(t_undo_history *history)
+{
+    for (int i = 0; i < history->count; i++)
+        undo_freeStep(&history->steps[i]);
+    history->count = 0;
+    history->bytes = 0;
+}
+
+
+static void undo_freeTiles(t_undo_history *history)
+{
+    if (!history->current)
+        return;
+    for (unsigned int i = 0; i < history->tilesX * history->tilesY; i++)
+        pool_free(history->current[i]);
+    free(history->current);
+    history->current = NULL;
+}
+
+
+// Drop every step and take the tiles from the image as it is
+static int undo_reset(t_undo_history *history, const t_image_view *view)
+{
+    undo_clear(history);
+    undo_freeTiles(history);
+
+    history->width = view->width;
+    history->height = view->height;
+    history->format = view->format;
+    history->tilesX = (view->width + UNDO_TILE - 1) / UNDO_TILE;
+    history->tilesY = (view->height + UNDO_TILE - 1) / UNDO_TILE;
+
+    unsigned int tileCount = history->tilesX * history->tilesY;
+    history->current = calloc(tileCount ? tileCount : 1, sizeof(uint8_t *));
+    if (!history->current) {
+        printf("Error: Failed to allocate the undo tiles\n");
+        return 0;
+    }
+    for (unsigned int i = 0; i < tileCount; i++) {
+        t_image_view tile = undo_tileView(history, view, i);
+        history->current[i] = pool_alloc(undo_tileBytes(&tile));
+        if (!history->current[i]) {
+            printf("Error: Failed to allocate the undo tiles\n");
+            undo_freeTiles(history);
+            return 0;
+        }
+        undo_copyOut(&tile, history->current[i]);
+    }
+    return 1;
+}
+
+
+t_undo_history * undo_create(const t_image_view *view, int depth)
+{
+    t_undo_history *history = calloc(1, sizeof(t_undo_history));
+    if (!history) {
+        printf("Error: Failed to allocate the undo history\n");
+        return NULL;
+    }
+    history->depth = depth < 1 ? 1 : depth;
+    history->steps = malloc(history->depth * sizeof(t_undo_step));
+    if (!history->steps || !undo_reset(history, view)) {
+        free(history->steps);
+        free(history);
+        return NULL;
+    }
+    return history;
+}
+
+
+int undo_commit(t_undo_history *history, const t_image_view *view, const char *label)
+{
+    if (view->width != history->width || view->height != history->height
+        || view->format != history->format || !history->current)
+        return undo_reset(history, view) ? 0 : -1;
+
+    unsigned int tileCount = history->tilesX * history->tilesY;
+    t_undo_step step;
+    step.count = 0;
+    step.tiles = NULL;
+    size_t bytes = 0;
+    int failed = 0;
+
+    for (unsigned int i = 0; i < tileCount && !failed; i++) {
+        t_image_view tile = undo_tileView(history, view, i);
+        if (!undo_differs(&tile, history->current[i]))
+            continue;
+
+        if (!step.tiles) {
+            step.tiles = malloc(tileCount * sizeof(t_undo_tile));
+            if (!step.tiles) {
+                failed = 1;
+                break;
+            }
+        }
+
+        // The previous content moves into the step, the tile gets a new buffer
+        uint8_t *pixels = pool_alloc(undo_tileBytes(&tile));
+        if (!pixels) {
+            failed = 1;
+            break;
+        }
+        undo_copyOut(&tile, pixels);
+        step.tiles[step.count].index = i;
+        step.tiles[step.count].pixels = history->current[i];
+        step.count++;
+        history->current[i] = pixels;
+        bytes += undo_tileBytes(&tile);
+    }
+
+    if (failed) {
+        printf("Error: Not enough memory for the undo history, earlier steps are lost\n");
+        undo_freeStep(&step);
+        return undo_reset(history, view) ? 0 : -1;
+    }
+    if (step.count == 0)
+        return 0;
+    t_undo_tile *shrunk = realloc(step.tiles, step.count * sizeof(t_undo_tile));
+    if (shrunk)
+        step.tiles = shrunk;
+
+    // The oldest step goes when the history is full
+    if (history->count == history->depth) {
+        for (unsigned int i = 0; i < history->steps[0].count; i++) {
+            t_image_view tile = undo_tileView(history, view, history->steps[0].tiles[i].index);
+            history->bytes -= undo_tileBytes(&tile);
+        }
+        undo_freeStep(&history->steps[0]);
+        memmove(history->steps, history->steps + 1, (history->depth - 1) * sizeof(t_undo_step));
+        history->count--;
+    }
+
+    snprintf(step.label, sizeof(step.label), "%s", label ? label : "");
+    history->steps[history->count++] = step;
+    history->bytes += bytes;
+    return (int)step.count;
+}
+
+
+int undo_revert(t_undo_history *history, const t_image_view *view)
+{
+    if (history->count == 0 || view->width != history->width
+        || view->height != history->height || view->format != history->format)
+        return 0;
+
+    t_undo_step *step = &history->steps[history->count - 1];
+    for (unsigned int i = 0; i < step->count; i++) {
+        unsigned int index = step->tiles[i].index;
+        t_image_view tile = undo_tileView(history, view, index);
+        undo_copyIn(&tile, step->tiles[i].pixels);
+
+        // The old buffer is the current content again; the newer one goes
+        uint8_t *newer = history->current[index];
+        history->current[index] = step->tiles[i].pixels;
+        step->tiles[i].pixels = newer;
+        history->bytes -= undo_tileBytes(&tile);
+    }
+    undo_freeStep(step);
+    history->count--;
+    return 1;
+}
+
+
+const char * undo_lastLabel(const t_undo_history *history)
+{
+    return history->count ? history->steps[history->count - 1].label : NULL;
+}
+
+
+void undo_free(t_undo_history *history)
+{
+    if (!history)
+        return;
+    undo_clear(history);
+    undo_freeTiles(history);
+    free(history->steps);
+    free(history);
+}
@@ -0,0 +1,133 @@
+/**
+ * @file undo.h
+ * @brief Tile-based undo history of an image
+ * @author Nolann FOTSO, Rafael ISLAM
+ * @date 2024-2025
+ *
+ * This header file defines an undo history that only keeps the parts of the
+ * image an operation changed, instead of a full copy per step:
+ * - The image is split into UNDO_TILE x UNDO_TILE tiles, and the history
+ *   holds one buffer per tile with the content as of the last commit
+ * - After an operation, undo_commit compares each tile with its buffer; the
+ *   buffers of changed tiles move into the new step as they are (no copy)
+ *   and the tiles get fresh buffers with their new content
+ * - undo_revert writes the tiles of the last step back into the image and
+ *   swaps their buffers back into the history
+ *
+ * The memory used is one copy of the image plus the changed tiles of each
+ * step: a brightness change stores every tile, a filter on a small region
+ * only a few. Only the last UNDO_DEFAULT_DEPTH (or the given depth) steps
+ * are kept.
+ *
+ * Usage:
+ * @code
+ *     t_image_view view = view_fromBmp24(img);
+ *     t_undo_history *history = undo_create(&view, UNDO_DEFAULT_DEPTH);
+ *     bmp24_negative(img);
+ *     undo_commit(history, &view, "Negative");
+ *     undo_revert(history, &view);             // img is back as loaded
+ * @endcode
+ */
+
+#ifndef UNDO_H
+#define UNDO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "imageview.h"
+
+/* ============================================================================
+ * UNDO CONSTANTS
+ * ============================================================================ */
+
+#define UNDO_TILE           64      /**< Width and height of a tile in pixels */
+#define UNDO_DEFAULT_DEPTH  16      /**< Default number of steps kept */
+#define UNDO_LABEL_SIZE     32      /**< Size of a step label, including the '\0' */
+
+/* ============================================================================
+ * STRUCTURE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @struct t_undo_tile
+ * @brief Content of one tile before a step
+ */
+typedef struct {
+    unsigned int index;     /**< Tile index, row by row from the top-left tile */
+    uint8_t *pixels;        /**< Tile rows, packed */
+} t_undo_tile;
+
+/**
+ * @struct t_undo_step
+ * @brief Tiles changed by one operation
+ */
+typedef struct {
+    char label[UNDO_LABEL_SIZE];    /**< Name of the operation */
+    t_undo_tile *tiles;             /**< Previous content of the changed tiles */
+    unsigned int count;             /**< Number of changed tiles */
+} t_undo_step;
+
+/**
+ * @struct t_undo_history
+ * @brief Undo history of one image
+ */
+typedef struct {
+    unsigned int width;         /**< Image width in pixels */
+    unsigned int height;        /**< Image height in pixels */
+    t_view_format format;       /**< Pixel format */
+    unsigned int tilesX;        /**< Number of tile columns */
+    unsigned int tilesY;        /**< Number of tile rows */
+    uint8_t **current;          /**< Content of every tile as of the last commit */
+    t_undo_step *steps;         /**< Steps, oldest first */
+    int count;                  /**< Number of steps */
+    int depth;                  /**< Maximum number of steps */
+    size_t bytes;               /**< Bytes of tile content held by the steps */
+} t_undo_history;
+
+/* ============================================================================
+ * HISTORY FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start the history of an image
+ * @param view Whole image, in its current state
+ * @param depth Maximum number of steps (at least 1)
+ * @return Pointer to the history, or NULL on allocation failure
+ */
+t_undo_history *undo_create(const t_image_view *view, int depth);
+
+/**
+ * @brief Record the changes made since the last commit as a new step
+ * @param history History of the image
+ * @param view Whole image, after the operation
+ * @param label Name of the operation, shown by undo_lastLabel
+ * @return Number of changed tiles (0: nothing recorded), or -1 on failure
+ *
+ * When the image has a different size or format, the history starts over
+ * from the image as it is. On allocation failure the history also starts
+ * over and the earlier steps are lost.
+ */
+int undo_commit(t_undo_history *history, const t_image_view *view, const char *label);
+
+/**
+ * @brief Undo the last step
+ * @param history History of the image
+ * @param view Whole image, unchanged since the last commit
+ * @return 1 if a step was undone, 0 if there is nothing to undo
+ */
+int undo_revert(t_undo_history *history, const t_image_view *view);
+
+/**
+ * @brief Name of the step undo_revert would undo
+ * @param history History of the image
+ * @return Label of the last step, or NULL if there is none
+ */
+const char *undo_lastLabel(const t_undo_history *history);
+
+/**
+ * @brief Free a history and all its tiles
+ * @param history History to free, or NULL
+ */
+void undo_free(t_undo_history *history);
+
+#endif //UNDO_H